@@ -0,0 +1,76 @@
+#include "arena.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_ALIGN 16
+#define ARENA_MIN_BLOCK 4096
+#define ARENA_MAX_BLOCK (1 << 20)
+
+void arena_init(Arena *arena)
+{
+    memset(arena, 0, sizeof(*arena));
+}
+
+void arena_destroy(Arena *arena)
+{
+    ArenaBlock *block = arena->blocks;
+    while (block)
+    {
+        ArenaBlock *next = block->next;
+        free(block);
+        block = next;
+    }
+    memset(arena, 0, sizeof(*arena));
+}
+
+// Fiecare bloc nou are dublul celui anterior, pana la ARENA_MAX_BLOCK.
+// O alocare mai mare primeste un bloc propriu, legat dupa blocul curent ca
+// sa nu se piarda spatiul ramas in acesta.
+static ArenaBlock *new_block(Arena *arena, size_t size)
+{
+    size_t block_size = arena->blocks ? arena->blocks->size * 2 : ARENA_MIN_BLOCK;
+    if (block_size > ARENA_MAX_BLOCK)
+        block_size = ARENA_MAX_BLOCK;
+    int dedicated = block_size < size;
+    if (dedicated)
+        block_size = size;
+
+    ArenaBlock *block = (ArenaBlock *)malloc(sizeof(ArenaBlock) + block_size);
+    if (!block)
+    {
+        fprintf(stderr, "Arena: Memory allocation failed\n");
+        abort();
+    }
+    block->size = block_size;
+    block->used = 0;
+    arena->reserved += sizeof(ArenaBlock) + block_size;
+
+    if (dedicated && arena->blocks)
+    {
+        block->next = arena->blocks->next;
+        arena->blocks->next = block;
+        return block;
+    }
+    block->next = arena->blocks;
+    arena->blocks = block;
+    return block;
+}
+
+void *arena_alloc(Arena *arena, size_t size)
+{
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+
+    ArenaBlock *block = arena->blocks;
+    if (!block || block->size - block->used < size)
+    {
+        block = new_block(arena, size);
+    }
+
+    void *result = block->data + block->used;
+    block->used += size;
+    arena->used += size;
+    memset(result, 0, size);
+    return result;
+}
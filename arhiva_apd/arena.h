@@ -0,0 +1,31 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// Bloc de memorie din care arena aloca secvential
+typedef struct ArenaBlock
+{
+    struct ArenaBlock *next;
+    size_t size;
+    size_t used;
+    _Alignas(16) unsigned char data[];
+} ArenaBlock;
+
+// Alocator de tip arena: alocarile nu se elibereaza individual, ci toate
+// odata cu arena. Blocurile cresc geometric, deci memoria rezervata urmeaza
+// continutul real.
+typedef struct
+{
+    ArenaBlock *blocks; // blocul curent, urmat de cele mai vechi
+    size_t reserved;    // octeti obtinuti de la malloc
+    size_t used;        // octeti dati alocarilor
+} Arena;
+
+void arena_init(Arena *arena);
+void arena_destroy(Arena *arena);
+
+// Intoarce `size` octeti initializati cu zero, aliniati la 16
+void *arena_alloc(Arena *arena, size_t size);
+
+#endif
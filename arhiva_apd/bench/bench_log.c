@@ -0,0 +1,108 @@
+// Benchmark pentru logger: mai multe fire scriu linii de forma celor din
+// bucla de download, o data cu fprintf + fflush (varianta veche), o data
+// prin logger-ul asincron la nivelul debug si o data cu debug oprit la
+// rulare.
+//
+//   ./bench_log [fire] [linii_per_fir]
+//
+// Fisierul bench_log.txt se sterge la final.
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "log.h"
+
+#define BENCH_LOG_FILE "bench_log.txt"
+
+typedef struct
+{
+    int id;
+    int lines;
+    FILE *file; // NULL pentru logger
+} Writer;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *writer_func(void *arg)
+{
+    Writer *writer = (Writer *)arg;
+    for (int i = 0; i < writer->lines; i++)
+    {
+        if (writer->file)
+        {
+            fprintf(writer->file, "Peer %d: Requested %s segment %d from Peer %d.\n",
+                    writer->id, "file_000001.bin", i, i % 16);
+            fflush(writer->file);
+        }
+        else
+        {
+            LOG_DEBUG("Peer %d: Requested %s segment %d from Peer %d.\n",
+                      writer->id, "file_000001.bin", i, i % 16);
+        }
+    }
+    return NULL;
+}
+
+static double run(int thread_count, int lines, FILE *file)
+{
+    pthread_t *threads = (pthread_t *)malloc(thread_count * sizeof(pthread_t));
+    Writer *writers = (Writer *)malloc(thread_count * sizeof(Writer));
+    double start = now_s();
+
+    for (int t = 0; t < thread_count; t++)
+    {
+        writers[t].id = t + 1;
+        writers[t].lines = lines;
+        writers[t].file = file;
+        pthread_create(&threads[t], NULL, writer_func, &writers[t]);
+    }
+    for (int t = 0; t < thread_count; t++)
+        pthread_join(threads[t], NULL);
+
+    double elapsed = now_s() - start;
+    free(threads);
+    free(writers);
+    return elapsed;
+}
+
+static void report(const char *mode, double elapsed, long total)
+{
+    printf("%-18s %8.3f s  %12.0f lines/s  %8.1f ns/line\n",
+           mode, elapsed, total / elapsed, elapsed * 1e9 / total);
+}
+
+int main(int argc, char *argv[])
+{
+    int thread_count = argc > 1 ? atoi(argv[1]) : 4;
+    int lines = argc > 2 ? atoi(argv[2]) : 200000;
+    long total = (long)thread_count * lines;
+
+    printf("%d threads x %d lines\n", thread_count, lines);
+
+    FILE *file = fopen(BENCH_LOG_FILE, "w");
+    report("fprintf + fflush", run(thread_count, lines, file), total);
+    fclose(file);
+
+    // Timpul include golirea finala, ca sa se compare aceeasi munca
+    log_open(BENCH_LOG_FILE, LOG_LEVEL_DEBUG);
+    double start = now_s();
+    run(thread_count, lines, NULL);
+    log_close();
+    report("async, debug", now_s() - start, total);
+
+    log_open(BENCH_LOG_FILE, LOG_LEVEL_INFO);
+    start = now_s();
+    run(thread_count, lines, NULL);
+    log_close();
+    report("async, debug off", now_s() - start, total);
+
+    unlink(BENCH_LOG_FILE);
+    return 0;
+}
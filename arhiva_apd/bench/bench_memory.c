@@ -0,0 +1,187 @@
+// Benchmark pentru amprenta de memorie: layout-ul vechi cu vectori de
+// dimensiune fixa (MAX_FILES x MAX_CHUNKS x MAX_PEERS) fata de stocarea
+// dinamica (catalog + arena + blocuri contigue de hash-uri).
+//
+//   ./bench_memory
+//
+// Pentru layout-ul nou se masoara memoria ceruta efectiv de la malloc.
+#include <malloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "catalog.h"
+#include "store.h"
+
+#define OLD_MAX_FILES 10
+#define OLD_MAX_CHUNKS 100
+#define OLD_MAX_PEERS 100
+
+// Vechile structuri, cu vectorii de dimensiune fixa
+typedef struct
+{
+    char filename[MAX_FILENAME];
+    uint32_t file_id;
+    int total_segments;
+    uint8_t segment_hashes[OLD_MAX_CHUNKS][HASH_SIZE];
+    int *holders;
+    int holder_count;
+    int holder_capacity;
+} OldTrackerFile;
+
+typedef struct
+{
+    char filename[MAX_FILENAME];
+    uint32_t file_id;
+    int total_segments;
+    char segments[OLD_MAX_CHUNKS][HASH_SIZE + 1];
+} OldFileDetails;
+
+typedef struct
+{
+    OldFileDetails owned_files[OLD_MAX_FILES];
+    int owned_file_count;
+    char requested_files[OLD_MAX_FILES][MAX_FILENAME];
+    int requested_file_count;
+} OldPeerInfo;
+
+typedef struct
+{
+    char filename[MAX_FILENAME];
+    uint32_t file_id;
+    int counters[5];
+    int peers[OLD_MAX_PEERS];
+    int peer_count;
+    int have_hashes;
+    char filename_hashes[OLD_MAX_CHUNKS][HASH_SIZE + 1];
+    char lock[40];
+} OldDownloadInfo;
+
+typedef struct
+{
+    const char *name;
+    int files;
+    int segments;
+    int peers;
+} Shape;
+
+// Blocurile mari vin din mmap si apar separat in hblkhd
+static size_t heap_in_use(void)
+{
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+}
+
+// Trackerul: fiecare fisier are toate hash-urile si `peers` detinatori
+static size_t measure_tracker(const Shape *shape)
+{
+    size_t before = heap_in_use();
+    Catalog catalog;
+    catalog_init(&catalog);
+
+    for (int f = 0; f < shape->files; f++)
+    {
+        char name[MAX_FILENAME];
+        snprintf(name, sizeof(name), "file_%06d.bin", f);
+        int index = catalog_add_file(&catalog, proto_file_id(name), name);
+        TrackerFile *file = &catalog.files[index];
+        catalog_set_segments(file, shape->segments);
+        for (int p = 1; p <= shape->peers; p++)
+            catalog_add_holder(file, p);
+    }
+
+    size_t used = heap_in_use() - before;
+    catalog_destroy(&catalog);
+    return used;
+}
+
+// Un peer care a descarcat toate fisierele: segmentele ajung in store,
+// langa starea de descarcare masurata separat
+static size_t measure_peer(const Shape *shape)
+{
+    size_t before = heap_in_use();
+    Arena arena;
+    SegmentStore store;
+    uint8_t digest[HASH_SIZE];
+    arena_init(&arena);
+    store_init(&store, &arena);
+    memset(digest, 'a', HASH_SIZE);
+
+    for (int f = 0; f < shape->files; f++)
+    {
+        char name[MAX_FILENAME];
+        snprintf(name, sizeof(name), "file_%06d.bin", f);
+        FileDetails *file = store_add_file(&store, name, shape->segments);
+        for (int s = 0; s < shape->segments; s++)
+            store_put_segment(file, s, digest);
+    }
+
+    size_t used = heap_in_use() - before;
+    store_destroy(&store);
+    arena_destroy(&arena);
+    return used;
+}
+
+// Starea de descarcare a unui peer care cere toate fisierele: manifestul si
+// lista de peers pentru fiecare fisier, alocate ca in download_thread_func
+static size_t measure_download(const Shape *shape)
+{
+    size_t before = heap_in_use();
+    void **buffers = (void **)malloc(2 * shape->files * sizeof(void *));
+
+    for (int f = 0; f < shape->files; f++)
+    {
+        buffers[2 * f] = calloc((size_t)shape->segments + 1, HASH_SIZE);
+        buffers[2 * f + 1] = malloc(shape->peers * sizeof(int));
+    }
+
+    size_t used = heap_in_use() - before;
+    for (int f = 0; f < 2 * shape->files; f++)
+        free(buffers[f]);
+    free(buffers);
+    return used;
+}
+
+static void print_kib(size_t bytes, int fits)
+{
+    if (fits)
+        printf(" %12.1f", bytes / 1024.0);
+    else
+        printf(" %12s", "n/a");
+}
+
+int main(void)
+{
+    static const Shape shapes[] = {
+        {"tiny", 1, 8, 4},
+        {"typical", 3, 30, 8},
+        {"old limits", 10, 100, 100},
+        {"many files", 1000, 50, 16},
+        {"large file", 2, 200000, 64},
+        {"large swarm", 10, 1000, 4096},
+    };
+    size_t old_tracker = OLD_MAX_FILES * sizeof(OldTrackerFile);
+    size_t old_peer = sizeof(OldPeerInfo) + OLD_MAX_FILES * sizeof(OldDownloadInfo);
+
+    printf("memory in KiB; n/a = does not fit the old fixed limits\n");
+    printf("%-12s %7s %9s %6s %12s %12s %12s %12s\n", "shape", "files", "segments", "peers",
+           "tracker old", "tracker new", "peer old", "peer new");
+
+    for (size_t i = 0; i < sizeof(shapes) / sizeof(shapes[0]); i++)
+    {
+        const Shape *shape = &shapes[i];
+        int fits = shape->files <= OLD_MAX_FILES && shape->segments <= OLD_MAX_CHUNKS &&
+                   shape->peers <= OLD_MAX_PEERS;
+        // Detinatorii erau deja dinamici inainte de aceasta schimbare
+        size_t old_holders = (size_t)shape->files * shape->peers * sizeof(int);
+
+        printf("%-12s %7d %9d %6d", shape->name, shape->files, shape->segments, shape->peers);
+        print_kib(old_tracker + old_holders, fits);
+        print_kib(measure_tracker(shape), 1);
+        print_kib(old_peer, fits);
+        print_kib(measure_peer(shape) + measure_download(shape), 1);
+        printf("\n");
+    }
+
+    return 0;
+}
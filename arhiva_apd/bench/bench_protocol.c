@@ -0,0 +1,289 @@
+// Microbenchmark: costul de codare/decodare si dimensiunea mesajelor
+// pentru formatul text vechi (sprintf/sscanf) si protocolul binar.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "protocol.h"
+
+#define ITERATIONS 2000000
+#define LIST_PEERS_COUNT 16
+#define MANIFEST_SEGMENTS 100
+
+static volatile unsigned long sink;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void report(const char *name, double encode_ns, double decode_ns, size_t bytes)
+{
+    printf("%-26s encode %8.1f ns  decode %8.1f ns  %5zu bytes\n",
+           name, encode_ns / ITERATIONS, decode_ns / ITERATIONS, bytes);
+}
+
+// Inregistrarea unui fisier la tracker: formatul text trimitea cate un
+// mesaj "UPLOAD %s %d %s" pentru fiecare segment.
+static void bench_upload(const char *filename, const char *hash)
+{
+    char text[MANIFEST_SEGMENTS][256];
+    size_t text_bytes = 0;
+    double t0 = now_ns();
+    for (int i = 0; i < ITERATIONS / MANIFEST_SEGMENTS; i++)
+    {
+        text_bytes = 0;
+        for (int s = 0; s < MANIFEST_SEGMENTS; s++)
+            text_bytes += sprintf(text[s], "UPLOAD %s %d %s", filename, s, hash) + 1;
+        sink += text[i % MANIFEST_SEGMENTS][7];
+    }
+    double t1 = now_ns();
+    for (int i = 0; i < ITERATIONS / MANIFEST_SEGMENTS; i++)
+    {
+        char hashes[MANIFEST_SEGMENTS][HASH_SIZE + 1];
+        for (int s = 0; s < MANIFEST_SEGMENTS; s++)
+        {
+            char name[MAX_FILENAME];
+            char hash_text[256];
+            int segment;
+            // Randul destinatie se afla abia dupa sscanf, din indexul citit
+            if (sscanf(text[s], "UPLOAD %49s %d %255s", name, &segment, hash_text) == 3 &&
+                segment >= 0 && segment < MANIFEST_SEGMENTS)
+            {
+                memcpy(hashes[segment], hash_text, HASH_SIZE);
+                hashes[segment][HASH_SIZE] = '\0';
+            }
+        }
+        sink += hashes[MANIFEST_SEGMENTS - 1][0];
+    }
+    double t2 = now_ns();
+    printf("%-26s encode %8.1f ns  decode %8.1f ns  %5zu bytes in %d messages\n",
+           "UPLOAD per file (text)", (t1 - t0) / (ITERATIONS / MANIFEST_SEGMENTS),
+           (t2 - t1) / (ITERATIONS / MANIFEST_SEGMENTS), text_bytes, MANIFEST_SEGMENTS);
+
+    size_t size = proto_upload_size(MANIFEST_SEGMENTS);
+    UploadMsg *msg = (UploadMsg *)malloc(size);
+    uint32_t file_id = proto_file_id(filename);
+    t0 = now_ns();
+    for (int i = 0; i < ITERATIONS / MANIFEST_SEGMENTS; i++)
+    {
+        proto_header_init(&msg->hdr, MSG_UPLOAD, MSG_FLAG_LAST);
+        msg->file_id = file_id;
+        msg->hash_count = MANIFEST_SEGMENTS;
+        for (int s = 0; s < MANIFEST_SEGMENTS; s++)
+            proto_digest_from_str(msg->digests + (size_t)s * HASH_SIZE, hash);
+        sink += msg->digests[0];
+    }
+    t1 = now_ns();
+    for (int i = 0; i < ITERATIONS / MANIFEST_SEGMENTS; i++)
+    {
+        uint8_t hashes[MANIFEST_SEGMENTS][HASH_SIZE];
+        if (proto_check_upload(msg, size) == 0)
+        {
+            memcpy(hashes, msg->digests, (size_t)msg->hash_count * HASH_SIZE);
+            sink += hashes[MANIFEST_SEGMENTS - 1][0];
+        }
+    }
+    t2 = now_ns();
+    printf("%-26s encode %8.1f ns  decode %8.1f ns  %5zu bytes in %d messages\n",
+           "UPLOAD per file (binary)", (t1 - t0) / (ITERATIONS / MANIFEST_SEGMENTS),
+           (t2 - t1) / (ITERATIONS / MANIFEST_SEGMENTS), size, 1);
+    free(msg);
+}
+
+static void bench_request(const char *filename)
+{
+    char text[256];
+    size_t text_bytes = 0;
+    double t0 = now_ns();
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+        text_bytes = sprintf(text, "%s %d", filename, i % 100) + 1;
+        sink += text[0];
+    }
+    double t1 = now_ns();
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+        char name[MAX_FILENAME];
+        int segment;
+        sscanf(text, "%s %d", name, &segment);
+        sink += segment + name[0];
+    }
+    double t2 = now_ns();
+    report("DOWNLOAD_REQUEST (text)", t1 - t0, t2 - t1, text_bytes);
+
+    FileMsg msg;
+    uint32_t file_id = proto_file_id(filename);
+    t0 = now_ns();
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+        proto_header_init(&msg.hdr, MSG_DOWNLOAD_REQUEST, 0);
+        msg.file_id = file_id;
+        msg.segment_index = i % 100;
+        sink += msg.segment_index;
+    }
+    t1 = now_ns();
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+        if (proto_check(&msg, sizeof(msg), MSG_DOWNLOAD_REQUEST, sizeof(msg)) == 0)
+            sink += msg.file_id + msg.segment_index;
+    }
+    t2 = now_ns();
+    report("DOWNLOAD_REQUEST (binary)", t1 - t0, t2 - t1, sizeof(msg));
+}
+
+static void bench_response(const char *hash)
+{
+    char text[256];
+    size_t text_bytes = 0;
+    double t0 = now_ns();
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+        text_bytes = sprintf(text, "HASH %s", hash) + 1;
+        sink += text[5];
+    }
+    double t1 = now_ns();
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+        char dummy[8];
+        char value[HASH_SIZE + 1];
+        if (strncmp(text, "HASH", 4) == 0)
+        {
+            sscanf(text, "%s %s", dummy, value);
+            sink += value[0];
+        }
+    }
+    double t2 = now_ns();
+    report("DOWNLOAD_RESPONSE (text)", t1 - t0, t2 - t1, text_bytes);
+
+    SegmentHashMsg msg;
+    t0 = now_ns();
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+        proto_header_init(&msg.hdr, MSG_DOWNLOAD_RESPONSE, 0);
+        msg.file_id = 1;
+        msg.segment_index = i % 100;
+        proto_digest_from_str(msg.digest, hash);
+        sink += msg.digest[0];
+    }
+    t1 = now_ns();
+    for (int i = 0; i < ITERATIONS; i++)
+    {
+        char value[HASH_SIZE + 1];
+        if (proto_check(&msg, sizeof(msg), MSG_DOWNLOAD_RESPONSE, sizeof(msg)) == 0 &&
+            !(msg.hdr.flags & MSG_FLAG_NACK))
+        {
+            proto_digest_to_str(value, msg.digest);
+            sink += value[0];
+        }
+    }
+    t2 = now_ns();
+    report("DOWNLOAD_RESPONSE (binary)", t1 - t0, t2 - t1, sizeof(msg));
+}
+
+// Manifestul unui fisier: lista de peers plus hash-urile tuturor segmentelor.
+// Formatul text folosea cate un mesaj "HASH %d %s" pentru fiecare segment.
+static void bench_peer_list(const char *hash)
+{
+    char text[1024];
+    char hash_text[MANIFEST_SEGMENTS][64];
+    size_t text_bytes = 0;
+    double t0 = now_ns();
+    for (int i = 0; i < ITERATIONS / MANIFEST_SEGMENTS; i++)
+    {
+        sprintf(text, "%d", MANIFEST_SEGMENTS);
+        for (int p = 0; p < LIST_PEERS_COUNT; p++)
+        {
+            char rank_str[16];
+            sprintf(rank_str, " %d", p + 1);
+            strcat(text, rank_str);
+        }
+        text_bytes = strlen(text) + 1;
+        for (int s = 0; s < MANIFEST_SEGMENTS; s++)
+            text_bytes += sprintf(hash_text[s], "HASH %d %s", s, hash) + 1;
+        sink += text[0] + hash_text[i % MANIFEST_SEGMENTS][0];
+    }
+    double t1 = now_ns();
+    for (int i = 0; i < ITERATIONS / MANIFEST_SEGMENTS; i++)
+    {
+        char copy[1024];
+        int peers[LIST_PEERS_COUNT];
+        char hashes[MANIFEST_SEGMENTS][HASH_SIZE + 1];
+        int seg_count = 0;
+        strcpy(copy, text);
+        sscanf(copy, "%d", &seg_count);
+        char *ptr = strtok(copy, " ");
+        int peer_index = 0;
+        while ((ptr = strtok(NULL, " ")) != NULL)
+            peers[peer_index++] = atoi(ptr);
+        for (int s = 0; s < seg_count; s++)
+        {
+            int segment_index;
+            sscanf(hash_text[s], "HASH %d %s", &segment_index, hashes[s]);
+        }
+        sink += seg_count + peers[peer_index - 1] + hashes[seg_count - 1][0];
+    }
+    double t2 = now_ns();
+    printf("%-26s encode %8.1f ns  decode %8.1f ns  %5zu bytes in %d messages\n",
+           "PEER_LIST manifest (text)", (t1 - t0) / (ITERATIONS / MANIFEST_SEGMENTS),
+           (t2 - t1) / (ITERATIONS / MANIFEST_SEGMENTS), text_bytes, MANIFEST_SEGMENTS + 1);
+
+    size_t size = proto_peer_list_size(LIST_PEERS_COUNT, MANIFEST_SEGMENTS, 0);
+    PeerListMsg *msg = (PeerListMsg *)malloc(size);
+    uint8_t digests[MANIFEST_SEGMENTS][HASH_SIZE];
+    for (int s = 0; s < MANIFEST_SEGMENTS; s++)
+        proto_digest_from_str(digests[s], hash);
+
+    t0 = now_ns();
+    for (int i = 0; i < ITERATIONS / MANIFEST_SEGMENTS; i++)
+    {
+        proto_header_init(&msg->hdr, MSG_PEER_LIST, 0);
+        msg->file_id = 1;
+        msg->total_segments = MANIFEST_SEGMENTS;
+        msg->hash_count = MANIFEST_SEGMENTS;
+        msg->bitfield_bytes = 0;
+        msg->version = 1;
+        msg->peer_count = 0;
+        for (int p = 0; p < LIST_PEERS_COUNT; p++)
+            msg->peers[msg->peer_count++] = p + 1;
+        memcpy(proto_peer_list_digests(msg), digests, sizeof(digests));
+        sink += msg->peer_count;
+    }
+    t1 = now_ns();
+    for (int i = 0; i < ITERATIONS / MANIFEST_SEGMENTS; i++)
+    {
+        int peers[LIST_PEERS_COUNT];
+        char hashes[MANIFEST_SEGMENTS][HASH_SIZE + 1];
+        if (proto_check_peer_list(msg, size) == 0)
+        {
+            const uint8_t *received = proto_peer_list_digests(msg);
+            for (uint32_t p = 0; p < msg->peer_count; p++)
+                peers[p] = msg->peers[p];
+            for (uint32_t s = 0; s < msg->hash_count; s++)
+                proto_digest_to_str(hashes[s], received + (size_t)s * HASH_SIZE);
+            sink += msg->total_segments + peers[LIST_PEERS_COUNT - 1] + hashes[0][0];
+        }
+    }
+    t2 = now_ns();
+    printf("%-26s encode %8.1f ns  decode %8.1f ns  %5zu bytes in %d messages\n",
+           "PEER_LIST manifest (binary)", (t1 - t0) / (ITERATIONS / MANIFEST_SEGMENTS),
+           (t2 - t1) / (ITERATIONS / MANIFEST_SEGMENTS), size, 1);
+    free(msg);
+}
+
+int main(void)
+{
+    const char *filename = "file_with_a_typical_name.bin";
+    const char *hash = "0123456789abcdef0123456789abcdef";
+
+    printf("%d iterations per case\n", ITERATIONS);
+    bench_upload(filename, hash);
+    bench_request(filename);
+    bench_response(hash);
+    bench_peer_list(hash);
+
+    return sink == 42 ? 1 : 0;
+}
@@ -0,0 +1,145 @@
+// Benchmark pentru SHA-256: verifica fiecare motor disponibil pe vectorii
+// de test standard si fata de varianta scalara, apoi masoara debitul pe un
+// singur fir (GB/s per core) pentru mai multe dimensiuni de segment.
+//
+//   ./bench_sha256 [MB_per_masuratoare]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sha256.h"
+
+#define BATCH 64
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static const struct
+{
+    const char *message;
+    const char *digest;
+} vectors[] = {
+    {"", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"},
+    {"abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"},
+    {"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+     "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"},
+    {"abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmnhijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu",
+     "cf5b16a778af8380036ce59e7b0492370b249b11e8f07a51afac45037afee9d1"},
+};
+
+#define VECTOR_COUNT (int)(sizeof(vectors) / sizeof(vectors[0]))
+
+// Vectorii standard, cate unul pe banda, plus lungimi amestecate fata de scalar
+static int check_engine(const uint8_t *data)
+{
+    Sha256Job jobs[BATCH];
+    uint8_t digests[BATCH][SHA256_DIGEST_SIZE], expected[SHA256_DIGEST_SIZE];
+    char text[2 * SHA256_DIGEST_SIZE + 1];
+    int errors = 0;
+
+    for (int i = 0; i < BATCH; i++)
+    {
+        jobs[i].data = (const uint8_t *)vectors[i % VECTOR_COUNT].message;
+        jobs[i].length = strlen(vectors[i % VECTOR_COUNT].message);
+        jobs[i].digest = digests[i];
+    }
+    sha256_many(jobs, BATCH);
+    for (int i = 0; i < BATCH; i++)
+    {
+        sha256_to_hex(digests[i], text, 2 * SHA256_DIGEST_SIZE);
+        text[2 * SHA256_DIGEST_SIZE] = '\0';
+        errors += strcmp(text, vectors[i % VECTOR_COUNT].digest) != 0;
+    }
+
+    srand(7);
+    for (int round = 0; round < 50; round++)
+    {
+        int count = 1 + rand() % BATCH;
+        for (int i = 0; i < count; i++)
+        {
+            jobs[i].length = rand() % 3000;
+            jobs[i].data = data + rand() % 1000;
+            jobs[i].digest = digests[i];
+        }
+        sha256_many(jobs, count);
+        for (int i = 0; i < count; i++)
+        {
+            sha256(jobs[i].data, jobs[i].length, expected);
+            errors += memcmp(expected, digests[i], SHA256_DIGEST_SIZE) != 0;
+        }
+    }
+    return errors;
+}
+
+// GB/s pe un fir pentru segmente de dimensiunea data
+static double measure(const uint8_t *data, size_t data_size, size_t segment, size_t total)
+{
+    Sha256Job jobs[BATCH];
+    uint8_t digests[BATCH][SHA256_DIGEST_SIZE];
+    size_t segments = data_size / segment;
+    size_t done = 0, next = 0;
+
+    double start = now_s();
+    while (done < total)
+    {
+        for (int i = 0; i < BATCH; i++)
+        {
+            jobs[i].data = data + (next++ % segments) * segment;
+            jobs[i].length = segment;
+            jobs[i].digest = digests[i];
+        }
+        sha256_many(jobs, BATCH);
+        done += BATCH * segment;
+    }
+    return done / 1e9 / (now_s() - start);
+}
+
+int main(int argc, char *argv[])
+{
+    size_t total = (size_t)(argc > 1 ? atoi(argv[1]) : 256) << 20;
+    size_t data_size = 64 << 20;
+    uint8_t *data = (uint8_t *)malloc(data_size);
+    for (size_t i = 0; i < data_size; i++)
+        data[i] = (uint8_t)(i * 2654435761u >> 13);
+
+    const char *names[] = {"scalar", "sse2", "avx2"};
+    const size_t sizes[] = {4096, 65536, 262144, 1048576};
+    double scalar[4] = {0};
+    int errors = 0;
+
+    printf("%-8s %6s", "engine", "check");
+    for (int s = 0; s < 4; s++)
+        printf(" %9zuK", sizes[s] >> 10);
+    printf("   GB/s per core\n");
+
+    for (int e = 0; e < 3; e++)
+    {
+        if (sha256_use_engine(names[e]) != 0)
+        {
+            printf("%-8s unsupported\n", names[e]);
+            continue;
+        }
+        int engine_errors = check_engine(data);
+        errors += engine_errors;
+        printf("%-8s %6s", names[e], engine_errors ? "FAIL" : "ok");
+        for (int s = 0; s < 4; s++)
+        {
+            double rate = measure(data, data_size, sizes[s], total);
+            if (e == 0)
+                scalar[s] = rate;
+            printf(" %6.3f", rate);
+            printf(e ? " x%.1f" : "     ", rate / scalar[s]);
+        }
+        printf("\n");
+    }
+
+    sha256_use_engine("auto");
+    printf("auto: %s (%d lanes)\n", sha256_engine(), sha256_lanes());
+    free(data);
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,223 @@
+// Benchmark si test de stres pentru SegmentStore: cativa scriitori (firele
+// de download) publica segmente si adauga fisiere in timp ce mai multi
+// cititori (workerii de upload) cauta segmente cu rata maxima. Se compara
+// citirea fara lock cu varianta veche, in care fiecare acces lua mutex-ul
+// peer-ului.
+//
+//   ./bench_store [cititori] [fisiere] [segmente]
+//
+// Cititorii verifica fiecare hash gasit; orice nepotrivire termina programul
+// cu cod 1. `make bench_store_tsan` construieste aceeasi sursa cu
+// ThreadSanitizer.
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "store.h"
+
+#define WRITER_COUNT 2
+
+typedef struct
+{
+    SegmentStore *store;
+    pthread_mutex_t *lock; // NULL pentru citirea fara lock
+    uint32_t *file_ids;
+    char (*names)[MAX_FILENAME];
+    int file_count;
+    int segment_count;
+    atomic_int *writers_left;
+} Shared;
+
+typedef struct
+{
+    Shared *shared;
+    int id;
+    long lookups;
+    long hits;
+    long mismatches;
+    double elapsed;
+} Worker;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Hash-ul asteptat pentru un segment, ca cititorii sa-l poata verifica
+static void expected_digest(uint8_t *digest, int file, int segment)
+{
+    for (int i = 0; i < HASH_SIZE; i++)
+        digest[i] = (uint8_t)(file * 31 + segment * 7 + i);
+}
+
+// Fiecare scriitor publica segmentele cu indicele congruent cu id-ul sau,
+// fisier cu fisier, ca tabela sa creasca in timp ce este citita
+static void *writer_func(void *arg)
+{
+    Worker *worker = (Worker *)arg;
+    Shared *shared = worker->shared;
+    double start = now_s();
+
+    for (int f = 0; f < shared->file_count; f++)
+    {
+        if (shared->lock)
+            pthread_mutex_lock(shared->lock);
+        FileDetails *file = store_add_file(shared->store, shared->names[f], shared->segment_count);
+        if (shared->lock)
+            pthread_mutex_unlock(shared->lock);
+
+        for (int s = worker->id; s < shared->segment_count; s += WRITER_COUNT)
+        {
+            uint8_t digest[HASH_SIZE];
+            expected_digest(digest, f, s);
+            if (shared->lock)
+                pthread_mutex_lock(shared->lock);
+            store_put_segment(file, s, digest);
+            if (shared->lock)
+                pthread_mutex_unlock(shared->lock);
+        }
+    }
+
+    worker->elapsed = now_s() - start;
+    atomic_fetch_sub(shared->writers_left, 1);
+    return NULL;
+}
+
+// Cititorul face ce face serve_request: cauta fisierul, testeaza segmentul
+// si copiaza hash-ul
+static void *reader_func(void *arg)
+{
+    Worker *worker = (Worker *)arg;
+    Shared *shared = worker->shared;
+    unsigned int seed = 1234u + worker->id;
+    uint8_t *bits = (uint8_t *)malloc(bitfield_bytes(shared->segment_count));
+    double start = now_s();
+
+    while (atomic_load(shared->writers_left) > 0)
+    {
+        int f = rand_r(&seed) % shared->file_count;
+        int s = rand_r(&seed) % shared->segment_count;
+        uint8_t digest[HASH_SIZE], expected[HASH_SIZE];
+        int found = 0;
+
+        if (shared->lock)
+            pthread_mutex_lock(shared->lock);
+        FileDetails *file = store_find(shared->store, shared->file_ids[f]);
+        if (file && store_has_segment(file, s))
+        {
+            memcpy(digest, store_digest(file, s), HASH_SIZE);
+            found = 1;
+        }
+        // Din cand in cand se copiaza si bitfield-ul, ca la gossip
+        if (file && (worker->lookups & 1023) == 0)
+            store_copy_bitfield(file, bits);
+        if (shared->lock)
+            pthread_mutex_unlock(shared->lock);
+
+        worker->lookups++;
+        if (found)
+        {
+            worker->hits++;
+            expected_digest(expected, f, s);
+            if (memcmp(digest, expected, HASH_SIZE) != 0)
+                worker->mismatches++;
+        }
+    }
+
+    worker->elapsed = now_s() - start;
+    free(bits);
+    return NULL;
+}
+
+// O rulare completa; intoarce numarul de hash-uri gresite vazute
+static long run(const char *mode, int locked, int reader_count, int file_count, int segment_count,
+                char (*names)[MAX_FILENAME], uint32_t *file_ids)
+{
+    Arena arena;
+    SegmentStore store;
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    atomic_int writers_left = WRITER_COUNT;
+    arena_init(&arena);
+    store_init(&store, &arena);
+
+    Shared shared = {&store, locked ? &lock : NULL, file_ids, names, file_count, segment_count, &writers_left};
+    Worker *workers = (Worker *)calloc(WRITER_COUNT + reader_count, sizeof(Worker));
+    pthread_t *threads = (pthread_t *)malloc((WRITER_COUNT + reader_count) * sizeof(pthread_t));
+
+    for (int i = 0; i < WRITER_COUNT + reader_count; i++)
+    {
+        workers[i].shared = &shared;
+        workers[i].id = i < WRITER_COUNT ? i : i - WRITER_COUNT;
+    }
+    for (int i = 0; i < reader_count; i++)
+        pthread_create(&threads[WRITER_COUNT + i], NULL, reader_func, &workers[WRITER_COUNT + i]);
+    for (int i = 0; i < WRITER_COUNT; i++)
+        pthread_create(&threads[i], NULL, writer_func, &workers[i]);
+    for (int i = 0; i < WRITER_COUNT + reader_count; i++)
+        pthread_join(threads[i], NULL);
+
+    double write_time = 0;
+    for (int i = 0; i < WRITER_COUNT; i++)
+        if (workers[i].elapsed > write_time)
+            write_time = workers[i].elapsed;
+
+    long lookups = 0, hits = 0, mismatches = 0;
+    double read_time = 0;
+    for (int i = WRITER_COUNT; i < WRITER_COUNT + reader_count; i++)
+    {
+        lookups += workers[i].lookups;
+        hits += workers[i].hits;
+        mismatches += workers[i].mismatches;
+        read_time += workers[i].elapsed;
+    }
+    read_time /= reader_count;
+
+    // La final toate segmentele trebuie sa fie publicate
+    for (int f = 0; f < file_count; f++)
+    {
+        FileDetails *file = store_find(&store, file_ids[f]);
+        if (!file || atomic_load(&file->segment_count) != segment_count)
+            mismatches++;
+    }
+
+    printf("%-10s publish %8.3f s  %12.0f segments/s  lookups %12.0f/s  hits %5.1f%%  mismatches %ld\n",
+           mode, write_time, (double)file_count * segment_count / write_time,
+           lookups / read_time, lookups ? 100.0 * hits / lookups : 0.0, mismatches);
+
+    store_destroy(&store);
+    arena_destroy(&arena);
+    pthread_mutex_destroy(&lock);
+    free(workers);
+    free(threads);
+    return mismatches;
+}
+
+int main(int argc, char *argv[])
+{
+    int reader_count = argc > 1 ? atoi(argv[1]) : 4;
+    int file_count = argc > 2 ? atoi(argv[2]) : 40;
+    int segment_count = argc > 3 ? atoi(argv[3]) : 20000;
+    if (reader_count < 1)
+        reader_count = 1;
+
+    char (*names)[MAX_FILENAME] = malloc((size_t)file_count * MAX_FILENAME);
+    uint32_t *file_ids = (uint32_t *)malloc(file_count * sizeof(uint32_t));
+    for (int f = 0; f < file_count; f++)
+    {
+        snprintf(names[f], MAX_FILENAME, "file_%06d.bin", f);
+        file_ids[f] = proto_file_id(names[f]);
+    }
+
+    printf("%d writers, %d readers, %d files x %d segments\n",
+           WRITER_COUNT, reader_count, file_count, segment_count);
+    long mismatches = run("mutex", 1, reader_count, file_count, segment_count, names, file_ids);
+    mismatches += run("lock-free", 0, reader_count, file_count, segment_count, names, file_ids);
+
+    free(names);
+    free(file_ids);
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,505 @@
+// Driver de benchmark: genereaza swarm-uri pentru fiecare combinatie de
+// parametri, ruleaza tema2 sub mpirun si scrie un raport CSV sau JSON cu
+// timpul total, segmentele pe secunda si mesajele primite de tracker (suma
+// shard-urilor, si pe secunda). Cu --transport two-sided,rma acelasi swarm
+// ruleaza cu ambele transporturi dintre peers; --ranks-per-node imparte
+// masina in noduri simulate, iar local_share este partea cererilor de
+// segmente trimise vecinilor de nod.
+//
+//   ./bench_swarm [--ranks 4,8] [--files 4] [--segments 50-200,1000]
+//                 [--seed-ratio 0.25] [--zipf 0,1] [--wanted 3]
+//                 [--segment-size 0,65536] [--trackers 1,2,4]
+//                 [--transport two-sided,rma] [--ranks-per-node 0,4] [--repeat N]
+//                 [--rng SEED] [--tema2 PATH] [--mpirun CMD] [--timeout S]
+//                 [--workdir DIR] [--format csv|json] [--output FILE]
+//                 [-- optiuni pentru tema2]
+//
+// Fiecare rulare are directorul ei (DIR/run<N>) si este verificata: fiecare
+// fisier descarcat trebuie sa contina exact hash-urile generate, iar cu
+// --segment-size > 0 si exact continutul generat (MB/s in raport).
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "swarm.h"
+
+#define MAX_SWEEP_VALUES 32
+
+typedef struct
+{
+    char *values[MAX_SWEEP_VALUES];
+    int count;
+} Sweep;
+
+typedef struct
+{
+    double wall;
+    int status; // 0 = ok, altfel motivul esecului
+    long tracker_messages; // suma shard-urilor
+    long tracker_bytes;
+    long tracker_sent; // octeti trimisi de shard-uri (liste de peers, confirmari)
+    double local_share; // cereri de segmente catre vecini de nod / toate, pe toti peers
+    int bad_files;
+} RunResult;
+
+static const char *status_names[] = {"ok", "failed", "timeout", "bad-output"};
+
+enum
+{
+    RUN_OK,
+    RUN_FAILED,
+    RUN_TIMEOUT,
+    RUN_BAD_OUTPUT
+};
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Lista separata prin virgule; sirul ramane al lui argv
+static void parse_sweep(Sweep *sweep, char *text)
+{
+    sweep->count = 0;
+    for (char *value = strtok(text, ","); value && sweep->count < MAX_SWEEP_VALUES; value = strtok(NULL, ","))
+        sweep->values[sweep->count++] = value;
+}
+
+// Sterge fisierele ramase de la o rulare anterioara
+static int prepare_dir(const char *dir)
+{
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST)
+        return -1;
+    DIR *handle = opendir(dir);
+    if (!handle)
+        return -1;
+    struct dirent *entry;
+    char path[PATH_MAX + 256];
+    while ((entry = readdir(handle)))
+    {
+        if (entry->d_name[0] == '.')
+            continue;
+        snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+        unlink(path);
+    }
+    closedir(handle);
+    return 0;
+}
+
+// Valoarea numerica a cheii din metrics<rank>.json sau -1
+static long read_metric(const char *dir, int rank, const char *key)
+{
+    char path[PATH_MAX + 64], pattern[64], text[8192];
+    snprintf(path, sizeof(path), "%s/metrics%d.json", dir, rank);
+    FILE *file = fopen(path, "r");
+    if (!file)
+        return -1;
+    size_t length = fread(text, 1, sizeof(text) - 1, file);
+    text[length] = '\0';
+    fclose(file);
+
+    snprintf(pattern, sizeof(pattern), "\"%s\": ", key);
+    char *found = strstr(text, pattern);
+    return found ? strtol(found + strlen(pattern), NULL, 10) : -1;
+}
+
+// 0 daca path contine exact continutul generat al fisierului
+static int verify_payload(const SwarmShape *shape, int file_index, const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file)
+        return -1;
+
+    uint8_t expected[1 << 16], actual[1 << 16];
+    uint64_t size = swarm_file_size(shape, file_index), offset = 0;
+    int bad = 0;
+    while (!bad)
+    {
+        size_t length = fread(actual, 1, sizeof(actual), file);
+        if (length == 0)
+            break;
+        if (offset + length > size)
+        {
+            bad = 1;
+            break;
+        }
+        swarm_fill_payload(shape, file_index, offset, expected, length);
+        bad = memcmp(actual, expected, length) != 0;
+        offset += length;
+    }
+    fclose(file);
+    return bad || offset != size ? -1 : 0;
+}
+
+// Numarul de fisiere descarcate care nu contin hash-urile generate
+static int verify_outputs(const SwarmShape *shape, const char *dir)
+{
+    int bad = 0;
+    int *wanted = (int *)malloc(shape->files * sizeof(int));
+    for (int rank = swarm_first_peer(shape); rank < shape->ranks; rank++)
+    {
+        int count = swarm_wanted_files(shape, rank, wanted);
+        for (int i = 0; i < count; i++)
+        {
+            char path[PATH_MAX + 64], line[256], hash[HASH_SIZE + 1];
+            snprintf(path, sizeof(path), "%s/client%d_file%d", dir, rank, wanted[i]);
+            FILE *file = fopen(path, "r");
+            if (!file)
+            {
+                bad++;
+                continue;
+            }
+            int segments = swarm_file_segments(shape, wanted[i]);
+            int s = 0;
+            while (fscanf(file, "%255s", line) == 1)
+            {
+                swarm_segment_hash(shape, wanted[i], s, hash);
+                if (s >= segments || strcmp(line, hash) != 0)
+                    break;
+                s++;
+            }
+            if (s != segments || !feof(file))
+                bad++;
+            fclose(file);
+
+            snprintf(path, sizeof(path), "%s/client%d_file%d.data", dir, rank, wanted[i]);
+            if (shape->segment_size > 0 && verify_payload(shape, wanted[i], path) != 0)
+                bad++;
+        }
+    }
+    free(wanted);
+    return bad;
+}
+
+// Ruleaza `mpirun -np ranks tema2 args` in dir, cu limita de timp
+static void run_swarm(const char *mpirun, const char *tema2, char **tema2_args, int tema2_argc,
+                      int ranks, int trackers, const char *dir, int timeout, RunResult *result)
+{
+    char command[8192];
+    int length = snprintf(command, sizeof(command), "exec %s -np %d %s", mpirun, ranks, tema2);
+    for (int i = 0; i < tema2_argc; i++)
+        length += snprintf(command + length, sizeof(command) - length, " %s", tema2_args[i]);
+
+    double start = now_s();
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        // Grup de procese propriu, ca la timeout sa fie oprit tot
+        setpgid(0, 0);
+        if (chdir(dir) != 0)
+            _exit(127);
+        int log = open("mpirun.log", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (log >= 0)
+        {
+            dup2(log, STDOUT_FILENO);
+            dup2(log, STDERR_FILENO);
+        }
+        execl("/bin/sh", "sh", "-c", command, (char *)NULL);
+        _exit(127);
+    }
+
+    int status = 0;
+    result->status = RUN_OK;
+    while (waitpid(pid, &status, WNOHANG) == 0)
+    {
+        if (timeout > 0 && now_s() - start > timeout)
+        {
+            kill(-pid, SIGKILL);
+            waitpid(pid, &status, 0);
+            result->status = RUN_TIMEOUT;
+            break;
+        }
+        usleep(1000);
+    }
+    result->wall = now_s() - start;
+
+    if (result->status == RUN_OK && (!WIFEXITED(status) || WEXITSTATUS(status) != 0))
+        result->status = RUN_FAILED;
+    result->tracker_messages = 0;
+    result->tracker_bytes = 0;
+    result->tracker_sent = 0;
+    for (int shard = 0; shard < trackers; shard++)
+    {
+        long messages = read_metric(dir, shard, "messages_received");
+        long bytes = read_metric(dir, shard, "bytes_received");
+        long sent = read_metric(dir, shard, "bytes_sent");
+        if (messages < 0 || bytes < 0 || sent < 0)
+        {
+            result->tracker_messages = result->tracker_bytes = result->tracker_sent = -1;
+            break;
+        }
+        result->tracker_messages += messages;
+        result->tracker_bytes += bytes;
+        result->tracker_sent += sent;
+    }
+
+    long local = 0, requests = 0;
+    for (int rank = trackers; rank < ranks; rank++)
+    {
+        long value = read_metric(dir, rank, "local_requests");
+        local += value > 0 ? value : 0;
+        value = read_metric(dir, rank, "segment_requests");
+        requests += value > 0 ? value : 0;
+    }
+    result->local_share = requests > 0 ? (double)local / requests : 0;
+}
+
+int main(int argc, char *argv[])
+{
+    static char default_ranks[] = "4", default_files[] = "4", default_segments[] = "50-200";
+    static char default_ratio[] = "0.25", default_zipf[] = "0", default_wanted[] = "3", default_size[] = "0";
+    static char default_trackers[] = "1", default_transport[] = "two-sided", default_per_node[] = "0";
+    Sweep ranks, files, segments, ratios, zipfs, wanteds, sizes, trackers, transports, per_node;
+    parse_sweep(&ranks, default_ranks);
+    parse_sweep(&files, default_files);
+    parse_sweep(&segments, default_segments);
+    parse_sweep(&ratios, default_ratio);
+    parse_sweep(&zipfs, default_zipf);
+    parse_sweep(&wanteds, default_wanted);
+    parse_sweep(&sizes, default_size);
+    parse_sweep(&trackers, default_trackers);
+    parse_sweep(&transports, default_transport);
+    parse_sweep(&per_node, default_per_node);
+
+    const char *tema2 = "./tema2";
+    const char *mpirun = getenv("MPIRUN") ? getenv("MPIRUN") : "mpirun --oversubscribe";
+    const char *workdir = "swarm_runs";
+    const char *output = NULL;
+    int json = 0, repeat = 1, timeout = 300;
+    unsigned long seed = 42;
+
+    static struct option long_options[] = {
+        {"ranks", required_argument, NULL, 'n'},
+        {"files", required_argument, NULL, 'f'},
+        {"segments", required_argument, NULL, 's'},
+        {"seed-ratio", required_argument, NULL, 'r'},
+        {"zipf", required_argument, NULL, 'z'},
+        {"wanted", required_argument, NULL, 'w'},
+        {"segment-size", required_argument, NULL, 'S'},
+        {"trackers", required_argument, NULL, 'K'},
+        {"transport", required_argument, NULL, 'X'},
+        {"ranks-per-node", required_argument, NULL, 'P'},
+        {"repeat", required_argument, NULL, 'k'},
+        {"rng", required_argument, NULL, 'R'},
+        {"tema2", required_argument, NULL, 't'},
+        {"mpirun", required_argument, NULL, 'm'},
+        {"timeout", required_argument, NULL, 'T'},
+        {"workdir", required_argument, NULL, 'W'},
+        {"format", required_argument, NULL, 'F'},
+        {"output", required_argument, NULL, 'o'},
+        {NULL, 0, NULL, 0}};
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "n:f:s:r:z:w:S:K:X:P:k:R:t:m:T:W:F:o:", long_options, NULL)) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            parse_sweep(&ranks, optarg);
+            break;
+        case 'f':
+            parse_sweep(&files, optarg);
+            break;
+        case 's':
+            parse_sweep(&segments, optarg);
+            break;
+        case 'r':
+            parse_sweep(&ratios, optarg);
+            break;
+        case 'z':
+            parse_sweep(&zipfs, optarg);
+            break;
+        case 'w':
+            parse_sweep(&wanteds, optarg);
+            break;
+        case 'S':
+            parse_sweep(&sizes, optarg);
+            break;
+        case 'K':
+            parse_sweep(&trackers, optarg);
+            break;
+        case 'X':
+            parse_sweep(&transports, optarg);
+            break;
+        case 'P':
+            parse_sweep(&per_node, optarg);
+            break;
+        case 'k':
+            repeat = atoi(optarg);
+            break;
+        case 'R':
+            seed = strtoul(optarg, NULL, 10);
+            break;
+        case 't':
+            tema2 = optarg;
+            break;
+        case 'm':
+            mpirun = optarg;
+            break;
+        case 'T':
+            timeout = atoi(optarg);
+            break;
+        case 'W':
+            workdir = optarg;
+            break;
+        case 'F':
+            json = strcmp(optarg, "json") == 0;
+            break;
+        case 'o':
+            output = optarg;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s [--ranks LIST] [--files LIST] [--segments LIST] [--seed-ratio LIST] "
+                            "[--zipf LIST] [--wanted LIST] [--segment-size LIST] [--trackers LIST] "
+                            "[--transport LIST] [--ranks-per-node LIST] [--repeat N] [--rng SEED] [--tema2 PATH] "
+                            "[--mpirun CMD] [--timeout S] [--workdir DIR] [--format csv|json] "
+                            "[--output FILE] [-- tema2 options]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // tema2 ruleaza in alt director
+    char tema2_path[PATH_MAX];
+    if (!realpath(tema2, tema2_path))
+    {
+        fprintf(stderr, "Cannot find %s\n", tema2);
+        return 1;
+    }
+    if (mkdir(workdir, 0755) != 0 && errno != EEXIST)
+    {
+        fprintf(stderr, "Cannot create %s\n", workdir);
+        return 1;
+    }
+
+    FILE *report = output ? fopen(output, "w") : stdout;
+    if (!report)
+    {
+        fprintf(stderr, "Cannot open %s\n", output);
+        return 1;
+    }
+    if (json)
+        fprintf(report, "[");
+    else
+        fprintf(report, "ranks,files,segments_min,segments_max,seed_ratio,zipf,wanted,segment_size,trackers,transport,"
+                        "ranks_per_node,repeat,status,wall_s,segments,segments_per_s,bytes,mb_per_s,tracker_messages,"
+                        "tracker_bytes,tracker_messages_per_s,tracker_sent,tracker_sent_per_file,local_share\n");
+
+    // Argumentele tema2, cu loc pentru --data-dir, --segment-size, --trackers, --transport si
+    // --ranks-per-node
+    int tema2_argc = argc - optind;
+    char **tema2_args = (char **)malloc((tema2_argc + 10) * sizeof(char *));
+    char size_text[32], trackers_text[32];
+    static char data_dir_option[] = "--data-dir", data_dir[] = ".", size_option[] = "--segment-size";
+    static char trackers_option[] = "--trackers", transport_option[] = "--transport";
+    static char per_node_option[] = "--ranks-per-node";
+    memcpy(tema2_args, argv + optind, tema2_argc * sizeof(char *));
+
+    int run_index = 0, failures = 0;
+    for (int a = 0; a < ranks.count; a++)
+    for (int b = 0; b < files.count; b++)
+    for (int c = 0; c < segments.count; c++)
+    for (int d = 0; d < ratios.count; d++)
+    for (int e = 0; e < zipfs.count; e++)
+    for (int g = 0; g < wanteds.count; g++)
+    for (int h = 0; h < sizes.count; h++)
+    for (int t = 0; t < trackers.count; t++)
+    for (int x = 0; x < transports.count; x++)
+    for (int q = 0; q < per_node.count; q++)
+    for (int r = 0; r < repeat; r++)
+    {
+        SwarmShape shape = {atoi(ranks.values[a]), atoi(files.values[b]), 0, 0,
+                            atof(ratios.values[d]), atof(zipfs.values[e]), atoi(wanteds.values[g]), seed + r,
+                            strtoul(sizes.values[h], NULL, 10), atoi(trackers.values[t])};
+        int shards = swarm_first_peer(&shape);
+        if (swarm_parse_range(segments.values[c], &shape.segments_min, &shape.segments_max) != 0 ||
+            swarm_check_shape(&shape) != 0)
+        {
+            fprintf(stderr, "Skipping invalid shape (ranks %s, files %s, segments %s)\n",
+                    ranks.values[a], files.values[b], segments.values[c]);
+            continue;
+        }
+
+        char dir[PATH_MAX];
+        snprintf(dir, sizeof(dir), "%s/run%d", workdir, run_index++);
+        SwarmSummary summary;
+        if (prepare_dir(dir) != 0 || swarm_generate(&shape, dir, &summary) != 0)
+        {
+            fprintf(stderr, "Cannot prepare %s\n", dir);
+            return 1;
+        }
+
+        int run_argc = tema2_argc;
+        if (shape.segment_size > 0)
+        {
+            snprintf(size_text, sizeof(size_text), "%u", shape.segment_size);
+            tema2_args[run_argc++] = data_dir_option;
+            tema2_args[run_argc++] = data_dir;
+            tema2_args[run_argc++] = size_option;
+            tema2_args[run_argc++] = size_text;
+        }
+        if (shards > 1)
+        {
+            snprintf(trackers_text, sizeof(trackers_text), "%d", shards);
+            tema2_args[run_argc++] = trackers_option;
+            tema2_args[run_argc++] = trackers_text;
+        }
+        tema2_args[run_argc++] = transport_option;
+        tema2_args[run_argc++] = transports.values[x];
+        tema2_args[run_argc++] = per_node_option;
+        tema2_args[run_argc++] = per_node.values[q];
+
+        RunResult result;
+        run_swarm(mpirun, tema2_path, tema2_args, run_argc, shape.ranks, shards, dir, timeout, &result);
+        if (result.status == RUN_OK && verify_outputs(&shape, dir) != 0)
+            result.status = RUN_BAD_OUTPUT;
+        failures += result.status != RUN_OK;
+
+        double rate = result.status == RUN_OK ? summary.segments / result.wall : 0;
+        double mb_rate = result.status == RUN_OK ? summary.bytes / 1e6 / result.wall : 0;
+        double tracker_rate = result.status == RUN_OK ? result.tracker_messages / result.wall : 0;
+        // Fiecare cerere (leech, fisier) este un fisier descarcat complet
+        double sent_per_file = result.status == RUN_OK && summary.requests > 0
+                                   ? (double)result.tracker_sent / summary.requests : 0;
+        if (json)
+            fprintf(report, "%s\n  {\"ranks\": %d, \"files\": %d, \"segments_min\": %d, \"segments_max\": %d, "
+                            "\"seed_ratio\": %g, \"zipf\": %g, \"wanted\": %d, \"segment_size\": %u, \"trackers\": %d, "
+                            "\"transport\": \"%s\", \"ranks_per_node\": %s, \"repeat\": %d, "
+                            "\"status\": \"%s\", \"wall_s\": %.3f, \"segments\": %ld, \"segments_per_s\": %.1f, "
+                            "\"bytes\": %llu, \"mb_per_s\": %.2f, \"tracker_messages\": %ld, \"tracker_bytes\": %ld, "
+                            "\"tracker_messages_per_s\": %.1f, \"tracker_sent\": %ld, \"tracker_sent_per_file\": %.0f, "
+                            "\"local_share\": %.3f}",
+                    run_index > 1 ? "," : "", shape.ranks, shape.files, shape.segments_min, shape.segments_max,
+                    shape.seed_ratio, shape.zipf, shape.wanted, shape.segment_size, shards, transports.values[x],
+                    per_node.values[q], r, status_names[result.status], result.wall, summary.segments, rate,
+                    (unsigned long long)summary.bytes, mb_rate, result.tracker_messages, result.tracker_bytes,
+                    tracker_rate, result.tracker_sent, sent_per_file, result.local_share);
+        else
+            fprintf(report, "%d,%d,%d,%d,%g,%g,%d,%u,%d,%s,%s,%d,%s,%.3f,%ld,%.1f,%llu,%.2f,%ld,%ld,%.1f,%ld,%.0f,%.3f\n",
+                    shape.ranks, shape.files, shape.segments_min, shape.segments_max, shape.seed_ratio,
+                    shape.zipf, shape.wanted, shape.segment_size, shards, transports.values[x], per_node.values[q],
+                    r, status_names[result.status],
+                    result.wall, summary.segments, rate, (unsigned long long)summary.bytes, mb_rate,
+                    result.tracker_messages, result.tracker_bytes, tracker_rate, result.tracker_sent, sent_per_file,
+                    result.local_share);
+        fflush(report);
+    }
+
+    if (json)
+        fprintf(report, "\n]\n");
+    if (output)
+        fclose(report);
+    free(tema2_args);
+    return failures ? 2 : 0;
+}
@@ -0,0 +1,156 @@
+// Benchmark pentru catalogul trackerului: reda milioane de cereri sintetice
+// (LIST_PEERS, RECEIVED_SEGMENT, FINISH_DOWNLOAD) asupra catalogului indexat
+// si asupra vechii cautari liniare cu strcmp.
+//
+//   ./bench_tracker [fisiere] [cereri] [peers]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "catalog.h"
+
+#define BASELINE_MAX_PEERS 1024
+
+// Vechiul layout: vector de fisiere si cate un slot pentru fiecare rank
+typedef struct
+{
+    char filename[MAX_FILENAME];
+    int clients_with_file[BASELINE_MAX_PEERS];
+} BaselineFile;
+
+typedef struct
+{
+    int type; // 0 = LIST_PEERS, 1 = RECEIVED_SEGMENT, 2 = FINISH_DOWNLOAD
+    int file;
+    int rank;
+} Request;
+
+static volatile long sink;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Tracker-ul primeste direct file_id in cereri
+static double replay_catalog(Catalog *catalog, const uint32_t *file_ids,
+                             const Request *requests, int request_count)
+{
+    int32_t *peer_list = (int32_t *)malloc(BASELINE_MAX_PEERS * sizeof(int32_t));
+    double start = now_s();
+    for (int r = 0; r < request_count; r++)
+    {
+        const Request *request = &requests[r];
+        int file_index = catalog_find(catalog, file_ids[request->file]);
+        TrackerFile *file = &catalog->files[file_index];
+
+        if (request->type == 0)
+        {
+            memcpy(peer_list, file->holders, file->holder_count * sizeof(int32_t));
+            sink += peer_list[file->holder_count - 1];
+        }
+        else
+        {
+            catalog_add_holder(file, request->rank);
+        }
+    }
+    double elapsed = now_s() - start;
+    free(peer_list);
+    return elapsed;
+}
+
+static double replay_baseline(BaselineFile *files, int file_count, char (*names)[MAX_FILENAME],
+                              const Request *requests, int request_count)
+{
+    int32_t *peer_list = (int32_t *)malloc(BASELINE_MAX_PEERS * sizeof(int32_t));
+    double start = now_s();
+    for (int r = 0; r < request_count; r++)
+    {
+        const Request *request = &requests[r];
+        int file_index = -1;
+        for (int i = 0; i < file_count; i++)
+        {
+            if (strcmp(files[i].filename, names[request->file]) == 0)
+            {
+                file_index = i;
+                break;
+            }
+        }
+
+        if (request->type == 0)
+        {
+            int count = 0;
+            for (int j = 0; j < BASELINE_MAX_PEERS; j++)
+            {
+                if (files[file_index].clients_with_file[j])
+                    peer_list[count++] = j;
+            }
+            sink += peer_list[count - 1];
+        }
+        else
+        {
+            files[file_index].clients_with_file[request->rank] = 1;
+        }
+    }
+    double elapsed = now_s() - start;
+    free(peer_list);
+    return elapsed;
+}
+
+int main(int argc, char *argv[])
+{
+    int file_count = argc > 1 ? atoi(argv[1]) : 1000;
+    int request_count = argc > 2 ? atoi(argv[2]) : 5000000;
+    int peer_count = argc > 3 ? atoi(argv[3]) : 256;
+    if (peer_count > BASELINE_MAX_PEERS)
+        peer_count = BASELINE_MAX_PEERS;
+
+    char (*names)[MAX_FILENAME] = malloc((size_t)file_count * MAX_FILENAME);
+    uint32_t *file_ids = (uint32_t *)malloc(file_count * sizeof(uint32_t));
+    Catalog catalog;
+    catalog_init(&catalog);
+    BaselineFile *baseline = (BaselineFile *)calloc(file_count, sizeof(BaselineFile));
+
+    // Fiecare fisier porneste cu un seed
+    for (int i = 0; i < file_count; i++)
+    {
+        snprintf(names[i], MAX_FILENAME, "file_%06d.bin", i);
+        file_ids[i] = proto_file_id(names[i]);
+        int index = catalog_add_file(&catalog, file_ids[i], names[i]);
+        catalog_add_holder(&catalog.files[index], 1 + i % peer_count);
+        strcpy(baseline[i].filename, names[i]);
+        baseline[i].clients_with_file[1 + i % peer_count] = 1;
+    }
+
+    Request *requests = (Request *)malloc((size_t)request_count * sizeof(Request));
+    srand(42);
+    for (int r = 0; r < request_count; r++)
+    {
+        int dice = rand() % 10;
+        requests[r].type = dice < 6 ? 0 : (dice < 9 ? 1 : 2);
+        requests[r].file = rand() % file_count;
+        requests[r].rank = 1 + rand() % peer_count;
+    }
+
+    printf("%d files, %d peers, %d requests\n", file_count, peer_count, request_count);
+
+    double elapsed = replay_catalog(&catalog, file_ids, requests, request_count);
+    printf("catalog (hash index):   %8.3f s  %12.0f requests/s\n",
+           elapsed, request_count / elapsed);
+
+    // Cautarea liniara este O(fisiere); se reda doar o parte din cereri
+    int baseline_count = request_count / 10;
+    elapsed = replay_baseline(baseline, file_count, names, requests, baseline_count);
+    printf("baseline (linear scan): %8.3f s  %12.0f requests/s  (%d requests)\n",
+           elapsed, baseline_count / elapsed, baseline_count);
+
+    catalog_destroy(&catalog);
+    free(baseline);
+    free(requests);
+    free(names);
+    free(file_ids);
+    return sink == 42 ? 1 : 0;
+}
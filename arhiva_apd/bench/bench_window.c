@@ -0,0 +1,167 @@
+// Benchmark: debitul de segmente in functie de adancimea ferestrei de cereri.
+// Rank-ul 0 descarca, celelalte rank-uri raspund fiecarei cereri dupa o
+// latenta fixa, ca sa emuleze timpul unui drum dus-intors prin retea.
+//
+//   mpirun -np 4 ./bench_window [latenta_us] [segmente]
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "protocol.h"
+
+#define MAX_WINDOW 64
+#define QUEUE_SIZE 4096
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// Raspunde cererilor in ordinea sosirii, fiecare dupa latency_us
+static void serve(double latency_us)
+{
+    static FileMsg queue[QUEUE_SIZE];
+    static int sources[QUEUE_SIZE];
+    static double due[QUEUE_SIZE];
+    int head = 0, tail = 0;
+    SegmentHashMsg response;
+
+    while (1)
+    {
+        int flag;
+        MPI_Status status;
+        MPI_Iprobe(MPI_ANY_SOURCE, MSG_DOWNLOAD_REQUEST, MPI_COMM_WORLD, &flag, &status);
+        if (flag)
+        {
+            FileMsg *request = &queue[tail % QUEUE_SIZE];
+            MPI_Recv(request, sizeof(*request), MPI_BYTE, status.MPI_SOURCE,
+                     MSG_DOWNLOAD_REQUEST, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+            if (request->hdr.flags & MSG_FLAG_TERMINATE)
+                return;
+            sources[tail % QUEUE_SIZE] = status.MPI_SOURCE;
+            due[tail % QUEUE_SIZE] = now_us() + latency_us;
+            tail++;
+        }
+
+        while (head < tail && due[head % QUEUE_SIZE] <= now_us())
+        {
+            FileMsg *request = &queue[head % QUEUE_SIZE];
+            proto_header_init(&response.hdr, MSG_DOWNLOAD_RESPONSE, 0);
+            response.file_id = request->file_id;
+            response.segment_index = request->segment_index;
+            memset(response.digest, 'a', HASH_SIZE);
+            MPI_Send(&response, sizeof(response), MPI_BYTE, sources[head % QUEUE_SIZE],
+                     MSG_DOWNLOAD_RESPONSE, MPI_COMM_WORLD);
+            head++;
+        }
+    }
+}
+
+// Descarca `segments` segmente cu cel mult `depth` cereri in zbor,
+// impartite circular intre servere
+static double download(int depth, int segments, int servers)
+{
+    FileMsg requests[MAX_WINDOW];
+    MPI_Request send_requests[MAX_WINDOW];
+    int slot_segment[MAX_WINDOW];
+    SegmentHashMsg responses[MAX_WINDOW];
+    MPI_Request recv_requests[MAX_WINDOW];
+
+    for (int i = 0; i < depth; i++)
+    {
+        slot_segment[i] = -1;
+        MPI_Irecv(&responses[i], sizeof(SegmentHashMsg), MPI_BYTE, MPI_ANY_SOURCE,
+                  MSG_DOWNLOAD_RESPONSE, MPI_COMM_WORLD, &recv_requests[i]);
+    }
+
+    double start = now_us();
+    int next_segment = 0, in_flight = 0, done = 0;
+    while (done < segments)
+    {
+        for (int i = 0; i < depth && in_flight < depth && next_segment < segments; i++)
+        {
+            if (slot_segment[i] != -1)
+                continue;
+            slot_segment[i] = next_segment;
+            proto_header_init(&requests[i].hdr, MSG_DOWNLOAD_REQUEST, 0);
+            requests[i].file_id = 1;
+            requests[i].segment_index = next_segment;
+            MPI_Isend(&requests[i], sizeof(FileMsg), MPI_BYTE, 1 + next_segment % servers,
+                      MSG_DOWNLOAD_REQUEST, MPI_COMM_WORLD, &send_requests[i]);
+            next_segment++;
+            in_flight++;
+        }
+
+        int index;
+        MPI_Waitany(depth, recv_requests, &index, MPI_STATUS_IGNORE);
+        for (int i = 0; i < depth; i++)
+        {
+            if (slot_segment[i] == (int)responses[index].segment_index)
+            {
+                MPI_Wait(&send_requests[i], MPI_STATUS_IGNORE);
+                slot_segment[i] = -1;
+                in_flight--;
+                done++;
+                break;
+            }
+        }
+        MPI_Irecv(&responses[index], sizeof(SegmentHashMsg), MPI_BYTE, MPI_ANY_SOURCE,
+                  MSG_DOWNLOAD_RESPONSE, MPI_COMM_WORLD, &recv_requests[index]);
+    }
+    double elapsed = now_us() - start;
+
+    for (int i = 0; i < depth; i++)
+    {
+        MPI_Cancel(&recv_requests[i]);
+        MPI_Wait(&recv_requests[i], MPI_STATUS_IGNORE);
+    }
+    return elapsed;
+}
+
+int main(int argc, char *argv[])
+{
+    int numtasks, rank;
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD, &numtasks);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    double latency_us = argc > 1 ? atof(argv[1]) : 200.0;
+    int segments = argc > 2 ? atoi(argv[2]) : 2000;
+
+    if (numtasks < 2)
+    {
+        fprintf(stderr, "bench_window needs at least 2 ranks\n");
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+
+    if (rank != 0)
+    {
+        serve(latency_us);
+    }
+    else
+    {
+        printf("%d segments, %d servers, %.0f us latency per request\n",
+               segments, numtasks - 1, latency_us);
+        for (int depth = 1; depth <= MAX_WINDOW; depth *= 2)
+        {
+            double elapsed = download(depth, segments, numtasks - 1);
+            printf("window %3d: %10.0f segments/s  (%.1f ms)\n",
+                   depth, segments / (elapsed / 1e6), elapsed / 1e3);
+        }
+
+        FileMsg terminate;
+        proto_header_init(&terminate.hdr, MSG_DOWNLOAD_REQUEST, MSG_FLAG_TERMINATE);
+        for (int p = 1; p < numtasks; p++)
+        {
+            MPI_Send(&terminate, sizeof(terminate), MPI_BYTE, p,
+                     MSG_DOWNLOAD_REQUEST, MPI_COMM_WORLD);
+        }
+    }
+
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,253 @@
+#include "swarm.h"
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sha256.h"
+
+// Toate valorile se deriva din (seed, tip, a, b), fara stare, ca generatorul
+// si verificarea sa obtina aceleasi hash-uri si aceleasi cereri
+static uint64_t mix(uint64_t seed, uint64_t kind, uint64_t a, uint64_t b)
+{
+    uint64_t x = seed ^ (kind * 0x9e3779b97f4a7c15ULL) ^ (a * 0xbf58476d1ce4e5b9ULL) ^ (b * 0x94d049bb133111ebULL);
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+int swarm_first_peer(const SwarmShape *shape)
+{
+    return shape->trackers > 1 ? shape->trackers : 1;
+}
+
+static int seed_count(const SwarmShape *shape)
+{
+    int peers = shape->ranks - swarm_first_peer(shape);
+    int seeds = (int)lround(shape->seed_ratio * peers);
+    if (seeds < 1)
+        seeds = 1;
+    if (seeds > peers)
+        seeds = peers;
+    return seeds;
+}
+
+int swarm_check_shape(const SwarmShape *shape)
+{
+    if (shape->ranks < swarm_first_peer(shape) + 1 || shape->files < 1 || shape->segments_min < 1 ||
+        shape->segments_max < shape->segments_min || shape->wanted < 0 ||
+        shape->seed_ratio < 0 || shape->zipf < 0)
+        return -1;
+    return 0;
+}
+
+int swarm_parse_range(const char *text, int *low, int *high)
+{
+    char *end;
+    *low = (int)strtol(text, &end, 10);
+    *high = *end == '-' ? (int)strtol(end + 1, &end, 10) : *low;
+    return *end == '\0' && end != text ? 0 : -1;
+}
+
+int swarm_file_segments(const SwarmShape *shape, int file)
+{
+    int span = shape->segments_max - shape->segments_min + 1;
+    return shape->segments_min + (int)(mix(shape->seed, 1, file, 0) % span);
+}
+
+uint64_t swarm_file_size(const SwarmShape *shape, int file)
+{
+    if (shape->segment_size == 0)
+        return 0;
+    uint64_t full = (uint64_t)(swarm_file_segments(shape, file) - 1) * shape->segment_size;
+    return full + 1 + mix(shape->seed, 4, file, 0) % shape->segment_size;
+}
+
+// Fiecare cuvant de 8 octeti se deriva din pozitia lui, deci orice interval
+// se poate regenera pentru verificare
+void swarm_fill_payload(const SwarmShape *shape, int file, uint64_t offset, uint8_t *buf, size_t length)
+{
+    for (size_t i = 0; i < length;)
+    {
+        uint64_t position = offset + i;
+        uint64_t word = mix(shape->seed, 5, file, position / 8);
+        for (int b = position % 8; b < 8 && i < length; b++, i++)
+            buf[i] = (uint8_t)(word >> (8 * b));
+    }
+}
+
+// Scrie continutul unui fisier in dir/file<N>
+static int write_payload(const SwarmShape *shape, const char *dir, int file)
+{
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/file%d", dir, file);
+    FILE *output = fopen(path, "wb");
+    if (!output)
+        return -1;
+
+    uint8_t buf[1 << 16];
+    uint64_t size = swarm_file_size(shape, file);
+    for (uint64_t offset = 0; offset < size; offset += sizeof(buf))
+    {
+        size_t length = size - offset < sizeof(buf) ? size - offset : sizeof(buf);
+        swarm_fill_payload(shape, file, offset, buf, length);
+        fwrite(buf, 1, length, output);
+    }
+    return fclose(output);
+}
+
+// Cu continut, hash-ul este cel verificat de tema2: primii 16 octeti
+// SHA-256 ai segmentului, in hex
+static void content_hash(const SwarmShape *shape, int file, int segment, char *hash)
+{
+    uint64_t size = swarm_file_size(shape, file);
+    uint64_t offset = (uint64_t)segment * shape->segment_size;
+    size_t length = size - offset < shape->segment_size ? size - offset : shape->segment_size;
+    uint8_t *data = (uint8_t *)malloc(length + 1), digest[SHA256_DIGEST_SIZE];
+    if (!data)
+    {
+        fprintf(stderr, "Swarm: Memory allocation failed\n");
+        exit(1);
+    }
+
+    swarm_fill_payload(shape, file, offset, data, length);
+    sha256(data, length, digest);
+    sha256_to_hex(digest, hash, HASH_SIZE);
+    hash[HASH_SIZE] = '\0';
+    free(data);
+}
+
+void swarm_segment_hash(const SwarmShape *shape, int file, int segment, char *hash)
+{
+    if (shape->segment_size > 0)
+    {
+        content_hash(shape, file, segment, hash);
+        return;
+    }
+
+    uint64_t high = mix(shape->seed, 2, file, 2 * (uint64_t)segment);
+    uint64_t low = mix(shape->seed, 2, file, 2 * (uint64_t)segment + 1);
+    snprintf(hash, HASH_SIZE + 1, "%016llx%016llx", (unsigned long long)high, (unsigned long long)low);
+}
+
+// Fisierele cerute se trag fara intoarcere dupa distributia Zipf:
+// fisierul i are ponderea 1 / i^zipf
+int swarm_wanted_files(const SwarmShape *shape, int rank, int *files)
+{
+    int peer = rank - swarm_first_peer(shape) + 1;
+    if (peer <= seed_count(shape))
+        return 0;
+
+    int count = shape->wanted < shape->files ? shape->wanted : shape->files;
+    double *cumulative = (double *)malloc(shape->files * sizeof(double));
+    char *taken = (char *)calloc(shape->files + 1, 1);
+    if (!cumulative || !taken)
+    {
+        fprintf(stderr, "Swarm: Memory allocation failed\n");
+        exit(1);
+    }
+
+    double total = 0;
+    for (int i = 0; i < shape->files; i++)
+    {
+        total += 1.0 / pow(i + 1, shape->zipf);
+        cumulative[i] = total;
+    }
+
+    uint64_t draw = 0;
+    for (int chosen = 0; chosen < count;)
+    {
+        double target = (mix(shape->seed, 3, peer, draw++) >> 11) * 0x1.0p-53 * total;
+        int low = 0, high = shape->files - 1;
+        while (low < high)
+        {
+            int middle = (low + high) / 2;
+            if (cumulative[middle] <= target)
+                low = middle + 1;
+            else
+                high = middle;
+        }
+        int file = low + 1;
+        if (!taken[file])
+        {
+            taken[file] = 1;
+            files[chosen++] = file;
+        }
+    }
+
+    free(cumulative);
+    free(taken);
+    return count;
+}
+
+int swarm_generate(const SwarmShape *shape, const char *dir, SwarmSummary *summary)
+{
+    if (swarm_check_shape(shape) != 0)
+        return -1;
+
+    int seeds = seed_count(shape);
+    int *wanted = (int *)malloc(shape->files * sizeof(int));
+    if (!wanted)
+        return -1;
+    memset(summary, 0, sizeof(*summary));
+    summary->seeds = seeds;
+    summary->leeches = shape->ranks - swarm_first_peer(shape) - seeds;
+
+    for (int rank = swarm_first_peer(shape); rank < shape->ranks; rank++)
+    {
+        int peer = rank - swarm_first_peer(shape) + 1;
+        char path[4096];
+        snprintf(path, sizeof(path), "%s/in%d.txt", dir, rank);
+        FILE *file = fopen(path, "w");
+        if (!file)
+        {
+            free(wanted);
+            return -1;
+        }
+
+        // Seed-ul s detine fisierele s, s + seeds, s + 2 * seeds, ...
+        int owned = peer <= seeds ? (shape->files - peer) / seeds + 1 : 0;
+        if (peer > shape->files)
+            owned = 0;
+        fprintf(file, "%d\n", owned);
+        for (int f = peer; owned && f <= shape->files; f += seeds)
+        {
+            int segments = swarm_file_segments(shape, f);
+            fprintf(file, "file%d %d\n", f, segments);
+            for (int s = 0; s < segments; s++)
+            {
+                char hash[HASH_SIZE + 1];
+                swarm_segment_hash(shape, f, s, hash);
+                fprintf(file, "%s\n", hash);
+            }
+        }
+
+        int count = swarm_wanted_files(shape, rank, wanted);
+        fprintf(file, "%d\n", count);
+        for (int i = 0; i < count; i++)
+        {
+            fprintf(file, "file%d\n", wanted[i]);
+            summary->segments += swarm_file_segments(shape, wanted[i]);
+            summary->bytes += swarm_file_size(shape, wanted[i]);
+        }
+        summary->requests += count;
+        fclose(file);
+    }
+
+    for (int f = 1; shape->segment_size > 0 && f <= shape->files; f++)
+    {
+        if (write_payload(shape, dir, f) != 0)
+        {
+            free(wanted);
+            return -1;
+        }
+    }
+
+    free(wanted);
+    return 0;
+}
@@ -0,0 +1,66 @@
+#ifndef SWARM_H
+#define SWARM_H
+
+#include <stdint.h>
+
+#include "protocol.h"
+
+// Forma unui swarm sintetic. Primele `trackers` rank-uri sunt shard-urile
+// trackerului; dintre peers, primii seed_ratio * peers pornesc cu fisiere
+// (seed-uri), ceilalti cer cate
+// `wanted` fisiere (leech-uri), alese dupa o popularitate Zipf. Cu
+// segment_size > 0, fisierele au si continut (file<N> langa in<rank>.txt).
+typedef struct
+{
+    int ranks; // inclusiv trackerul
+    int files;
+    int segments_min;
+    int segments_max;
+    double seed_ratio;
+    double zipf; // exponentul Zipf; 0 = toate fisierele la fel de populare
+    int wanted;
+    unsigned long seed;
+    uint32_t segment_size; // 0 = doar hash-uri
+    int trackers;          // shard-uri de tracker (tema2 --trackers); 0 inseamna 1
+} SwarmShape;
+
+typedef struct
+{
+    int seeds;
+    int leeches;
+    int requests;  // perechi (leech, fisier cerut)
+    long segments; // segmente de descarcat in tot swarm-ul
+    uint64_t bytes; // continut de descarcat in tot swarm-ul
+} SwarmSummary;
+
+// Primul rank care este peer
+int swarm_first_peer(const SwarmShape *shape);
+
+// Scrie in<rank>.txt pentru fiecare peer in directorul dir. Fisierele si
+// cererile depind doar de pozitia peer-ului, nu si de numarul de shard-uri.
+// Intoarce 0 la succes.
+int swarm_generate(const SwarmShape *shape, const char *dir, SwarmSummary *summary);
+
+// Numarul de segmente al fisierului file (numerotat de la 1)
+int swarm_file_segments(const SwarmShape *shape, int file);
+
+// Dimensiunea continutului unui fisier; ultimul segment este incomplet
+uint64_t swarm_file_size(const SwarmShape *shape, int file);
+
+// Continutul determinist al fisierului file, de la offset, in buf
+void swarm_fill_payload(const SwarmShape *shape, int file, uint64_t offset, uint8_t *buf, size_t length);
+
+// Hash-ul determinist al unui segment, HASH_SIZE caractere hex + '\0'; cu
+// continut, hash-ul continutului segmentului
+void swarm_segment_hash(const SwarmShape *shape, int file, int segment, char *hash);
+
+// Fisierele cerute de un rank; intoarce numarul lor (0 pentru seed-uri)
+int swarm_wanted_files(const SwarmShape *shape, int rank, int *files);
+
+// Citeste "A" sau "A-B"; intoarce 0 la succes
+int swarm_parse_range(const char *text, int *low, int *high);
+
+// Valideaza forma; intoarce 0 daca este folosibila
+int swarm_check_shape(const SwarmShape *shape);
+
+#endif
@@ -0,0 +1,103 @@
+// Generator de swarm-uri sintetice: scrie in<rank>.txt pentru o forma data.
+//
+//   ./swarmgen --ranks N --files F --segments MIN[-MAX] [--seed-ratio R]
+//              [--zipf S] [--wanted K] [--rng SEED] [--segment-size BYTES]
+//              [--trackers K] [--output DIR]
+//
+// Apoi: cd DIR && mpirun -np N ../tema2 (cu --segment-size:
+// ../tema2 --data-dir . --segment-size BYTES; cu --trackers K, si
+// ../tema2 --trackers K)
+#include <errno.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+
+#include "swarm.h"
+
+int main(int argc, char *argv[])
+{
+    SwarmShape shape = {4, 3, 10, 30, 0.25, 0.0, 3, 42, 0, 1};
+    const char *dir = ".";
+    static struct option long_options[] = {
+        {"ranks", required_argument, NULL, 'n'},
+        {"files", required_argument, NULL, 'f'},
+        {"segments", required_argument, NULL, 's'},
+        {"seed-ratio", required_argument, NULL, 'r'},
+        {"zipf", required_argument, NULL, 'z'},
+        {"wanted", required_argument, NULL, 'w'},
+        {"rng", required_argument, NULL, 'R'},
+        {"segment-size", required_argument, NULL, 'S'},
+        {"trackers", required_argument, NULL, 'T'},
+        {"output", required_argument, NULL, 'o'},
+        {NULL, 0, NULL, 0}};
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "n:f:s:r:z:w:R:S:T:o:", long_options, NULL)) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            shape.ranks = atoi(optarg);
+            break;
+        case 'f':
+            shape.files = atoi(optarg);
+            break;
+        case 's':
+            if (swarm_parse_range(optarg, &shape.segments_min, &shape.segments_max) != 0)
+                shape.segments_min = 0;
+            break;
+        case 'r':
+            shape.seed_ratio = atof(optarg);
+            break;
+        case 'z':
+            shape.zipf = atof(optarg);
+            break;
+        case 'w':
+            shape.wanted = atoi(optarg);
+            break;
+        case 'R':
+            shape.seed = strtoul(optarg, NULL, 10);
+            break;
+        case 'S':
+            shape.segment_size = strtoul(optarg, NULL, 10);
+            break;
+        case 'T':
+            shape.trackers = atoi(optarg);
+            break;
+        case 'o':
+            dir = optarg;
+            break;
+        default:
+            fprintf(stderr, "Usage: %s --ranks N --files F --segments MIN[-MAX] [--seed-ratio R] "
+                            "[--zipf S] [--wanted K] [--rng SEED] [--segment-size BYTES] [--trackers K] [--output DIR]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (swarm_check_shape(&shape) != 0)
+    {
+        fprintf(stderr, "Invalid swarm shape\n");
+        return 1;
+    }
+
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST)
+    {
+        fprintf(stderr, "Cannot create %s\n", dir);
+        return 1;
+    }
+
+    SwarmSummary summary;
+    if (swarm_generate(&shape, dir, &summary) != 0)
+    {
+        fprintf(stderr, "Cannot write input files in %s\n", dir);
+        return 1;
+    }
+
+    printf("%d ranks: %d seeds, %d leeches, %d requested files, %ld segments to download",
+           shape.ranks, summary.seeds, summary.leeches, summary.requests, summary.segments);
+    if (shape.segment_size > 0)
+        printf(" (%.2f MB)", summary.bytes / 1e6);
+    printf("\n");
+    return 0;
+}
@@ -0,0 +1,40 @@
+#ifndef BITFIELD_H
+#define BITFIELD_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Bitfield de segmente: bitul i (octetul i / 8, bitul i % 8) arata daca
+// segmentul i este detinut
+
+static inline size_t bitfield_bytes(int count)
+{
+    return ((size_t)count + 7) / 8;
+}
+
+static inline int bitfield_test(const uint8_t *bits, int index)
+{
+    return (bits[index / 8] >> (index % 8)) & 1;
+}
+
+static inline void bitfield_set(uint8_t *bits, int index)
+{
+    bits[index / 8] |= (uint8_t)(1 << (index % 8));
+}
+
+// Marcheaza primele count segmente; bitii de dupa ele raman zero
+static inline void bitfield_set_all(uint8_t *bits, int count)
+{
+    memset(bits, 0xff, (size_t)count / 8);
+    if (count % 8)
+        bits[count / 8] |= (uint8_t)((1 << (count % 8)) - 1);
+}
+
+static inline void bitfield_merge(uint8_t *bits, const uint8_t *other, size_t bytes)
+{
+    for (size_t i = 0; i < bytes; i++)
+        bits[i] |= other[i];
+}
+
+#endif
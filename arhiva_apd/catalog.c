@@ -0,0 +1,220 @@
+#include "catalog.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CATALOG_INITIAL_SLOTS 16
+#define CATALOG_INITIAL_FILES 8
+
+static void *checked_realloc(void *ptr, size_t size)
+{
+    void *result = realloc(ptr, size);
+    if (!result)
+    {
+        fprintf(stderr, "Catalog: Memory allocation failed\n");
+        abort();
+    }
+    return result;
+}
+
+// file_id este deja un hash FNV-1a; amestecarea Fibonacci imprastie si
+// bitii superiori in indexul slotului
+static uint32_t slot_of(uint32_t file_id, uint32_t mask)
+{
+    return (file_id * 2654435769u) & mask;
+}
+
+static void insert_slot(CatalogSlot *slots, uint32_t mask, uint32_t file_id, int file_index)
+{
+    uint32_t i = slot_of(file_id, mask);
+    while (slots[i].file_index != -1)
+    {
+        i = (i + 1) & mask;
+    }
+    slots[i].file_id = file_id;
+    slots[i].file_index = file_index;
+}
+
+static void alloc_slots(Catalog *catalog, uint32_t slot_count)
+{
+    catalog->slots = (CatalogSlot *)checked_realloc(NULL, slot_count * sizeof(CatalogSlot));
+    catalog->slot_mask = slot_count - 1;
+    for (uint32_t i = 0; i < slot_count; i++)
+    {
+        catalog->slots[i].file_index = -1;
+    }
+}
+
+// Dubleaza tabela cand factorul de incarcare depaseste 1/2
+static void grow_slots(Catalog *catalog)
+{
+    CatalogSlot *old_slots = catalog->slots;
+    uint32_t old_count = catalog->slot_mask + 1;
+
+    alloc_slots(catalog, old_count * 2);
+    for (uint32_t i = 0; i < old_count; i++)
+    {
+        if (old_slots[i].file_index != -1)
+        {
+            insert_slot(catalog->slots, catalog->slot_mask,
+                        old_slots[i].file_id, old_slots[i].file_index);
+        }
+    }
+    free(old_slots);
+}
+
+void catalog_init(Catalog *catalog)
+{
+    memset(catalog, 0, sizeof(*catalog));
+    alloc_slots(catalog, CATALOG_INITIAL_SLOTS);
+}
+
+void catalog_destroy(Catalog *catalog)
+{
+    for (int i = 0; i < catalog->file_count; i++)
+    {
+        free(catalog->files[i].segment_hashes);
+        free(catalog->files[i].holders);
+        free(catalog->files[i].holder_bits);
+        free(catalog->files[i].holder_versions);
+    }
+    free(catalog->files);
+    free(catalog->slots);
+    memset(catalog, 0, sizeof(*catalog));
+}
+
+int catalog_find(const Catalog *catalog, uint32_t file_id)
+{
+    uint32_t i = slot_of(file_id, catalog->slot_mask);
+    while (catalog->slots[i].file_index != -1)
+    {
+        if (catalog->slots[i].file_id == file_id)
+        {
+            return catalog->slots[i].file_index;
+        }
+        i = (i + 1) & catalog->slot_mask;
+    }
+    return -1;
+}
+
+int catalog_add_file(Catalog *catalog, uint32_t file_id, const char *filename)
+{
+    int file_index = catalog_find(catalog, file_id);
+    if (file_index != -1)
+    {
+        return strcmp(catalog->files[file_index].filename, filename) == 0 ? file_index : -1;
+    }
+
+    if (catalog->file_count == catalog->file_capacity)
+    {
+        catalog->file_capacity = catalog->file_capacity ? catalog->file_capacity * 2 : CATALOG_INITIAL_FILES;
+        catalog->files = (TrackerFile *)checked_realloc(catalog->files,
+                                                        catalog->file_capacity * sizeof(TrackerFile));
+    }
+
+    if ((uint32_t)(catalog->file_count + 1) * 2 > catalog->slot_mask + 1)
+    {
+        grow_slots(catalog);
+    }
+
+    file_index = catalog->file_count++;
+    TrackerFile *file = &catalog->files[file_index];
+    memset(file, 0, sizeof(*file));
+    strncpy(file->filename, filename, MAX_FILENAME - 1);
+    file->file_id = file_id;
+    file->version = 1; // 0 inseamna un client fara manifest
+
+    insert_slot(catalog->slots, catalog->slot_mask, file_id, file_index);
+    return file_index;
+}
+
+void catalog_set_segments(TrackerFile *file, int total_segments)
+{
+    if (total_segments <= file->total_segments)
+    {
+        return;
+    }
+
+    file->segment_hashes = (uint8_t *)checked_realloc(file->segment_hashes,
+                                                      (size_t)total_segments * HASH_SIZE);
+    memset(file->segment_hashes + (size_t)file->total_segments * HASH_SIZE, 0,
+           (size_t)(total_segments - file->total_segments) * HASH_SIZE);
+    file->total_segments = total_segments;
+
+    // Randurile de bitfield se largesc pe loc, de la ultimul la primul
+    int old_bytes = file->bitfield_bytes;
+    int new_bytes = bitfield_bytes(total_segments);
+    if (new_bytes != old_bytes && file->holder_capacity > 0)
+    {
+        file->holder_bits = (uint8_t *)checked_realloc(file->holder_bits,
+                                                       (size_t)file->holder_capacity * new_bytes);
+        for (int h = file->holder_count - 1; h >= 0; h--)
+        {
+            memmove(file->holder_bits + (size_t)h * new_bytes,
+                    file->holder_bits + (size_t)h * old_bytes, old_bytes);
+            memset(file->holder_bits + (size_t)h * new_bytes + old_bytes, 0, new_bytes - old_bytes);
+        }
+    }
+    file->bitfield_bytes = new_bytes;
+}
+
+// Cautare binara a pozitiei rank-ului in vectorul sortat
+static int holder_position(const TrackerFile *file, int rank)
+{
+    int low = 0, high = file->holder_count;
+    while (low < high)
+    {
+        int mid = (low + high) / 2;
+        if (file->holders[mid] < rank)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+int catalog_add_holder(TrackerFile *file, int rank)
+{
+    int low = holder_position(file, rank);
+    if (low < file->holder_count && file->holders[low] == rank)
+    {
+        return 0;
+    }
+
+    size_t row = file->bitfield_bytes;
+    if (file->holder_count == file->holder_capacity)
+    {
+        file->holder_capacity = file->holder_capacity ? file->holder_capacity * 2 : 4;
+        file->holders = (int *)checked_realloc(file->holders, file->holder_capacity * sizeof(int));
+        file->holder_versions = (uint32_t *)checked_realloc(file->holder_versions,
+                                                            file->holder_capacity * sizeof(uint32_t));
+        if (row > 0)
+        {
+            file->holder_bits = (uint8_t *)checked_realloc(file->holder_bits, file->holder_capacity * row);
+        }
+    }
+
+    memmove(&file->holders[low + 1], &file->holders[low],
+            (file->holder_count - low) * sizeof(int));
+    file->holders[low] = rank;
+    memmove(&file->holder_versions[low + 1], &file->holder_versions[low],
+            (file->holder_count - low) * sizeof(uint32_t));
+    file->holder_versions[low] = ++file->version;
+    if (row > 0)
+    {
+        memmove(file->holder_bits + (low + 1) * row, file->holder_bits + low * row,
+                (file->holder_count - low) * row);
+        memset(file->holder_bits + low * row, 0, row);
+    }
+    file->holder_count++;
+    return 1;
+}
+
+uint8_t *catalog_holder_bits(TrackerFile *file, int rank)
+{
+    catalog_add_holder(file, rank);
+    int position = holder_position(file, rank);
+    file->holder_versions[position] = ++file->version;
+    return file->holder_bits + (size_t)position * file->bitfield_bytes;
+}
@@ -0,0 +1,66 @@
+#ifndef CATALOG_H
+#define CATALOG_H
+
+#include <stdint.h>
+
+#include "bitfield.h"
+#include "protocol.h"
+
+// Structura detaliilor despre fisierele trackerului
+typedef struct
+{
+    char filename[MAX_FILENAME];
+    uint32_t file_id;
+    int total_segments;
+    uint64_t file_size; // 0 daca seed-urile nu au trimis continut
+    uint8_t *segment_hashes; // total_segments * HASH_SIZE octeti, contigui
+    int *holders; // Rank-urile clientilor care detin fisierul, sortate crescator
+    int holder_count;
+    int holder_capacity;
+    uint8_t *holder_bits; // cate un bitfield de segmente pentru fiecare detinator, in ordinea din holders
+    int bitfield_bytes;
+    uint32_t version;          // creste la fiecare detinator nou sau bitfield modificat; incepe de la 1
+    uint32_t *holder_versions; // versiunea ultimei schimbari a fiecarui detinator, in ordinea din holders
+    int manifest_complete; // un seed a trimis toate hash-urile
+} TrackerFile;
+
+// Intrare in tabela de dispersie: file_id -> index in vectorul de fisiere
+typedef struct
+{
+    uint32_t file_id;
+    int32_t file_index; // -1 pentru un slot liber
+} CatalogSlot;
+
+// Catalogul trackerului: fisierele intr-un vector contiguu, indexate printr-o
+// tabela cu adresare deschisa (sondare liniara) dupa file_id
+typedef struct
+{
+    TrackerFile *files;
+    int file_count;
+    int file_capacity;
+    CatalogSlot *slots;
+    uint32_t slot_mask; // numarul de sloturi - 1 (putere a lui 2)
+} Catalog;
+
+void catalog_init(Catalog *catalog);
+void catalog_destroy(Catalog *catalog);
+
+// Intoarce indexul fisierului sau -1 daca nu exista
+int catalog_find(const Catalog *catalog, uint32_t file_id);
+
+// Intoarce indexul fisierului, adaugandu-l daca lipseste. Intoarce -1 daca
+// file_id apartine deja unui fisier cu alt nume.
+int catalog_add_file(Catalog *catalog, uint32_t file_id, const char *filename);
+
+// Mareste blocul de hash-uri la total_segments segmente; hash-urile noi sunt zero
+void catalog_set_segments(TrackerFile *file, int total_segments);
+
+// Marcheaza rank-ul ca detinator al fisierului. Intoarce 1 daca este nou.
+// Un detinator nou nu are niciun segment marcat.
+int catalog_add_holder(TrackerFile *file, int rank);
+
+// Bitfield-ul de segmente al unui detinator, adaugat daca lipseste, pentru
+// modificare: randul lui intra in urmatoarea versiune a fisierului
+uint8_t *catalog_holder_bits(TrackerFile *file, int rank);
+
+#endif
@@ -0,0 +1,291 @@
+#include "log.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define LOG_RING_SIZE (64 * 1024) // putere a lui 2
+#define LOG_LINE_MAX 1024
+#define LOG_DRAIN_INTERVAL_NS 10000000L
+
+// Antetul fiecarei linii din buffer: numarul ei de ordine global si lungimea
+typedef struct
+{
+    uint64_t sequence;
+    uint32_t length;
+} LogRecord;
+
+// Buffer-ul circular al unui fir. Firul respectiv este singurul care avanseaza
+// head; tail avanseaza doar cine goleste, sub drain_lock. Pozitiile cresc
+// monoton, iar indicele in data este pozitia modulo LOG_RING_SIZE.
+typedef struct LogRing
+{
+    struct LogRing *next;
+    atomic_size_t head;
+    atomic_size_t tail;
+    size_t drain_head; // head citit la inceputul golirii, sub drain_lock
+    char data[LOG_RING_SIZE];
+} LogRing;
+
+int log_runtime_level = LOG_LEVEL_INFO;
+
+static struct
+{
+    FILE *file;
+    pthread_mutex_t drain_lock; // lista de buffere si golirea lor
+    pthread_mutex_t wake_lock;
+    pthread_cond_t wake;
+    LogRing *rings;
+    int stop;
+    int running;
+    pthread_t writer;
+} logger = {NULL, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL, 0, 0};
+
+static __thread LogRing *thread_ring;
+
+// Urmatorul numar de ordine; liniile tuturor firelor se scriu in ordinea lui
+static atomic_uint_least64_t log_sequence;
+
+static const char *level_names[] = {"error", "warn", "info", "debug"};
+
+static void ring_read(const LogRing *ring, size_t position, void *out, size_t length)
+{
+    size_t start = position & (LOG_RING_SIZE - 1);
+    size_t first = LOG_RING_SIZE - start < length ? LOG_RING_SIZE - start : length;
+    memcpy(out, ring->data + start, first);
+    if (length > first)
+        memcpy((char *)out + first, ring->data, length - first);
+}
+
+static void ring_write(LogRing *ring, size_t position, const void *in, size_t length)
+{
+    size_t start = position & (LOG_RING_SIZE - 1);
+    size_t first = LOG_RING_SIZE - start < length ? LOG_RING_SIZE - start : length;
+    memcpy(ring->data + start, in, first);
+    if (length > first)
+        memcpy(ring->data, (const char *)in + first, length - first);
+}
+
+// Scrie in fisier tot ce s-a adunat, interclasand firele dupa numarul de
+// ordine; se apeleaza cu drain_lock tinut. Se scriu doar liniile numerotate
+// inainte de inceputul golirii: o linie care o precede cauzal pe una scrisa
+// acum a fost deja publicata, deci nu mai poate aparea dupa ea.
+static size_t drain_rings(void)
+{
+    uint64_t limit = atomic_load(&log_sequence);
+    for (LogRing *ring = logger.rings; ring; ring = ring->next)
+    {
+        ring->drain_head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    }
+
+    size_t written = 0;
+    char line[LOG_LINE_MAX];
+    while (1)
+    {
+        LogRing *next = NULL;
+        LogRecord next_record = {0, 0};
+        for (LogRing *ring = logger.rings; ring; ring = ring->next)
+        {
+            size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+            if (tail == ring->drain_head)
+                continue;
+
+            LogRecord record;
+            ring_read(ring, tail, &record, sizeof(record));
+            if (record.sequence < limit && (!next || record.sequence < next_record.sequence))
+            {
+                next = ring;
+                next_record = record;
+            }
+        }
+        if (!next)
+            break;
+
+        size_t tail = atomic_load_explicit(&next->tail, memory_order_relaxed);
+        ring_read(next, tail + sizeof(next_record), line, next_record.length);
+        fwrite(line, 1, next_record.length, logger.file);
+        atomic_store_explicit(&next->tail, tail + sizeof(next_record) + next_record.length, memory_order_release);
+        written += next_record.length;
+    }
+    return written;
+}
+
+static void *writer_func(void *arg)
+{
+    (void)arg;
+    pthread_mutex_lock(&logger.wake_lock);
+    while (1)
+    {
+        int stop = logger.stop;
+        pthread_mutex_unlock(&logger.wake_lock);
+
+        pthread_mutex_lock(&logger.drain_lock);
+        if (drain_rings())
+            fflush(logger.file);
+        pthread_mutex_unlock(&logger.drain_lock);
+
+        pthread_mutex_lock(&logger.wake_lock);
+        // Golirea de dupa cererea de oprire este ultima
+        if (stop)
+            break;
+        if (!logger.stop)
+        {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += LOG_DRAIN_INTERVAL_NS;
+            if (deadline.tv_nsec >= 1000000000L)
+            {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&logger.wake, &logger.wake_lock, &deadline);
+        }
+    }
+    pthread_mutex_unlock(&logger.wake_lock);
+    return NULL;
+}
+
+static LogRing *register_ring(void)
+{
+    LogRing *ring = (LogRing *)malloc(sizeof(LogRing));
+    if (!ring)
+    {
+        fprintf(stderr, "Log: Memory allocation failed\n");
+        abort();
+    }
+    ring->next = NULL;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    ring->drain_head = 0;
+
+    pthread_mutex_lock(&logger.drain_lock);
+    ring->next = logger.rings;
+    logger.rings = ring;
+    pthread_mutex_unlock(&logger.drain_lock);
+
+    thread_ring = ring;
+    return ring;
+}
+
+int log_open(const char *path, int level)
+{
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if (fd < 0)
+        return -1;
+    // Append: alte scrieri in acelasi fisier nu sunt suprascrise
+    logger.file = fdopen(fd, "a");
+    if (!logger.file)
+        return -1;
+
+    log_runtime_level = level;
+    logger.stop = 0;
+    if (pthread_create(&logger.writer, NULL, writer_func, NULL))
+    {
+        fclose(logger.file);
+        logger.file = NULL;
+        return -1;
+    }
+    logger.running = 1;
+    return 0;
+}
+
+void log_close(void)
+{
+    if (!logger.running)
+        return;
+
+    pthread_mutex_lock(&logger.wake_lock);
+    logger.stop = 1;
+    pthread_cond_signal(&logger.wake);
+    pthread_mutex_unlock(&logger.wake_lock);
+    pthread_join(logger.writer, NULL);
+    logger.running = 0;
+
+    // Firele care au scris s-au terminat; ramane doar cel curent
+    LogRing *ring = logger.rings;
+    while (ring)
+    {
+        LogRing *next = ring->next;
+        free(ring);
+        ring = next;
+    }
+    logger.rings = NULL;
+    thread_ring = NULL;
+
+    fclose(logger.file);
+    logger.file = NULL;
+}
+
+void log_flush(void)
+{
+    if (!logger.running)
+        return;
+
+    pthread_mutex_lock(&logger.drain_lock);
+    drain_rings();
+    fflush(logger.file);
+    pthread_mutex_unlock(&logger.drain_lock);
+}
+
+int log_level_from_name(const char *name)
+{
+    for (int i = 0; i < (int)(sizeof(level_names) / sizeof(level_names[0])); i++)
+    {
+        if (strcmp(name, level_names[i]) == 0)
+            return i;
+    }
+    return -1;
+}
+
+void log_write(int level, const char *format, ...)
+{
+    char line[LOG_LINE_MAX];
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (length < 0)
+        return;
+    if (length >= LOG_LINE_MAX)
+    {
+        // Linia trunchiata se termina tot cu newline
+        length = LOG_LINE_MAX - 1;
+        line[length - 1] = '\n';
+    }
+
+    if (!logger.running)
+    {
+        fputs(line, stderr);
+        return;
+    }
+
+    LogRing *ring = thread_ring ? thread_ring : register_ring();
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t size = sizeof(LogRecord) + length;
+
+    // Buffer plin: firul de scriere este trezit, iar producatorul cedeaza
+    // procesorul pana se elibereaza loc
+    while (head + size - atomic_load_explicit(&ring->tail, memory_order_acquire) > LOG_RING_SIZE)
+    {
+        pthread_cond_signal(&logger.wake);
+        sched_yield();
+    }
+
+    // Numarul se ia chiar inainte de publicare, ca liniile unui fir sa ramana
+    // crescatoare in buffer-ul lui
+    LogRecord record = {atomic_fetch_add(&log_sequence, 1), (uint32_t)length};
+    ring_write(ring, head, &record, sizeof(record));
+    ring_write(ring, head + sizeof(record), line, length);
+    atomic_store_explicit(&ring->head, head + size, memory_order_release);
+
+    // Erorile preced de obicei un MPI_Abort si nu trebuie pierdute
+    if (level == LOG_LEVEL_ERROR)
+        log_flush();
+}
@@ -0,0 +1,63 @@
+#ifndef LOG_H
+#define LOG_H
+
+// Logger asincron: fiecare fir scrie liniile formatate intr-un buffer
+// circular propriu, fara lock, iar un fir de fundal le goleste in fisier.
+// Fiecare linie primeste un numar de ordine global, iar liniile tuturor
+// firelor ajung in fisier in ordinea acestuia.
+
+#define LOG_LEVEL_ERROR 0
+#define LOG_LEVEL_WARN 1
+#define LOG_LEVEL_INFO 2
+#define LOG_LEVEL_DEBUG 3
+
+// Nivelul maxim compilat; apelurile peste el dispar complet din binar
+// (make build LOG_MAX_LEVEL=2 scoate LOG_DEBUG)
+#ifndef LOG_MAX_LEVEL
+#define LOG_MAX_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+// Nivelul ales la rulare; se seteaza inainte de pornirea firelor
+extern int log_runtime_level;
+
+// Deschide fisierul (trunchiat, apoi scris in mod append) si porneste firul
+// de scriere. Intoarce 0 la succes.
+int log_open(const char *path, int level);
+
+// Goleste toate buffer-ele, opreste firul de scriere si inchide fisierul
+void log_close(void);
+
+// Scrie sincron tot ce este in buffere; folosit inainte de MPI_Abort
+void log_flush(void);
+
+// Nivelul cu numele dat ("error", "warn", "info", "debug") sau -1
+int log_level_from_name(const char *name);
+
+void log_write(int level, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+// Pentru liniile care cer pregatire inainte de scriere
+#define LOG_ENABLED(level) ((level) <= LOG_MAX_LEVEL && (level) <= log_runtime_level)
+
+#define LOG_AT(level, ...)                                                 \
+    do                                                                     \
+    {                                                                      \
+        if ((level) <= log_runtime_level)                                  \
+            log_write((level), __VA_ARGS__);                               \
+    } while (0)
+
+#define LOG_ERROR(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+#define LOG_WARN(...) LOG_AT(LOG_LEVEL_WARN, __VA_ARGS__)
+
+#if LOG_MAX_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(...) LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) ((void)0)
+#endif
+
+#if LOG_MAX_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,359 @@
+#include "metrics.h"
+
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Metricile se pun intr-un layout plat, ca sa poata fi adunate intre
+// rank-uri cu doua MPI_Reduce (SUM si MAX; minimul circula negat).
+//   sums:  contoare | pentru fiecare histograma: count, sum, buckets | pentru fiecare peer: count, sum
+//   maxes: pentru fiecare histograma: ~min, max | pentru fiecare peer: max
+#define HIST_SUM_FIELDS (2 + HIST_BUCKETS)
+#define SUM_HIST(h) (METRIC_COUNTER_COUNT + (h) * HIST_SUM_FIELDS)
+#define SUM_PEER(p) (SUM_HIST(HIST_COUNT) + 2 * (p))
+#define SUM_SIZE(peers) SUM_PEER(peers)
+#define MAX_HIST(h) (2 * (h))
+#define MAX_PEER(p) (MAX_HIST(HIST_COUNT) + (p))
+#define MAX_SIZE(peers) MAX_PEER(peers)
+
+typedef struct
+{
+    _Atomic uint64_t count;
+    _Atomic uint64_t sum;
+    _Atomic uint64_t max;
+} PeerRtt;
+
+static struct
+{
+    int rank;
+    int peer_count;
+    _Atomic uint64_t counters[METRIC_COUNTER_COUNT];
+    Histogram histograms[HIST_COUNT];
+    PeerRtt *peers;
+} metrics;
+
+static const char *counter_names[METRIC_COUNTER_COUNT] = {
+    "segment_requests", "nacks", "bytes_sent", "bytes_received",
+    "messages_sent", "messages_received", "bootstrap_us", "barrier_us",
+    "payload_bytes", "verify_failures", "tracker_allocations", "rma_reads",
+    "local_requests", "node_reads"};
+
+static const char *tag_names[METRICS_TAG_COUNT] = {
+    NULL, "INIT", "UPLOAD", "ACK", "LIST_PEERS", "PEER_LIST", "DOWNLOAD_REQUEST",
+    "DOWNLOAD_RESPONSE", "FINISH_DOWNLOAD", "FINALIZE_ALL", "END_UPLOAD", "START_DOWNLOAD",
+    "RECEIVED_SEGMENT", "SEGMENT_BITFIELD", "HAVE", "PEER_BITFIELD", "GOSSIP"};
+
+static int bucket_index(uint64_t value)
+{
+    if (value < HIST_SUB_COUNT)
+        return (int)value;
+    int bits = 63 - __builtin_clzll(value);
+    if (bits >= HIST_MAX_BITS)
+        return HIST_BUCKETS - 1;
+    int sub = (int)(value >> (bits - HIST_SUB_BITS)) & (HIST_SUB_COUNT - 1);
+    return HIST_SUB_COUNT * (bits - HIST_SUB_BITS + 1) + sub;
+}
+
+// Cea mai mare valoare care ajunge in bucket
+static uint64_t bucket_upper(int index)
+{
+    if (index < HIST_SUB_COUNT)
+        return (uint64_t)index;
+    int bits = index / HIST_SUB_COUNT + HIST_SUB_BITS - 1;
+    int sub = index % HIST_SUB_COUNT;
+    uint64_t width = (uint64_t)1 << (bits - HIST_SUB_BITS);
+    return ((uint64_t)(HIST_SUB_COUNT + sub) << (bits - HIST_SUB_BITS)) + width - 1;
+}
+
+static void atomic_max(_Atomic uint64_t *target, uint64_t value)
+{
+    uint64_t current = atomic_load_explicit(target, memory_order_relaxed);
+    while (current < value &&
+           !atomic_compare_exchange_weak_explicit(target, &current, value,
+                                                  memory_order_relaxed, memory_order_relaxed))
+        ;
+}
+
+static void atomic_min(_Atomic uint64_t *target, uint64_t value)
+{
+    uint64_t current = atomic_load_explicit(target, memory_order_relaxed);
+    while (current > value &&
+           !atomic_compare_exchange_weak_explicit(target, &current, value,
+                                                  memory_order_relaxed, memory_order_relaxed))
+        ;
+}
+
+static uint64_t to_ns(double seconds)
+{
+    return seconds > 0 ? (uint64_t)(seconds * 1e9) : 0;
+}
+
+static void histogram_record(Histogram *histogram, uint64_t value)
+{
+    atomic_fetch_add_explicit(&histogram->count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->sum, value, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->buckets[bucket_index(value)], 1, memory_order_relaxed);
+    atomic_min(&histogram->min, value);
+    atomic_max(&histogram->max, value);
+}
+
+void metrics_init(int rank, int peer_count)
+{
+    metrics.rank = rank;
+    metrics.peer_count = peer_count;
+    for (int h = 0; h < HIST_COUNT; h++)
+        atomic_store(&metrics.histograms[h].min, UINT64_MAX);
+    metrics.peers = (PeerRtt *)calloc(peer_count, sizeof(PeerRtt));
+    if (!metrics.peers)
+    {
+        fprintf(stderr, "Metrics: Memory allocation failed\n");
+        abort();
+    }
+}
+
+void metrics_destroy(void)
+{
+    free(metrics.peers);
+    metrics.peers = NULL;
+}
+
+void metrics_add(MetricCounter counter, uint64_t value)
+{
+    atomic_fetch_add_explicit(&metrics.counters[counter], value, memory_order_relaxed);
+}
+
+void metrics_record(MetricHistogram histogram, double seconds)
+{
+    histogram_record(&metrics.histograms[histogram], to_ns(seconds));
+}
+
+void metrics_record_tag(int tag, double seconds)
+{
+    if (tag < 0 || tag >= METRICS_TAG_COUNT)
+        tag = METRICS_TAG_COUNT - 1;
+    histogram_record(&metrics.histograms[HIST_TRACKER_SERVICE + tag], to_ns(seconds));
+}
+
+void metrics_record_rtt(int peer, double seconds)
+{
+    uint64_t value = to_ns(seconds);
+    histogram_record(&metrics.histograms[HIST_SEGMENT_RTT], value);
+    if (peer < 0 || peer >= metrics.peer_count)
+        return;
+    atomic_fetch_add_explicit(&metrics.peers[peer].count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&metrics.peers[peer].sum, value, memory_order_relaxed);
+    atomic_max(&metrics.peers[peer].max, value);
+}
+
+// Copiaza metricile curente in layout-ul plat
+static void snapshot(uint64_t *sums, uint64_t *maxes)
+{
+    for (int c = 0; c < METRIC_COUNTER_COUNT; c++)
+        sums[c] = atomic_load(&metrics.counters[c]);
+
+    for (int h = 0; h < HIST_COUNT; h++)
+    {
+        Histogram *histogram = &metrics.histograms[h];
+        uint64_t *out = &sums[SUM_HIST(h)];
+        out[0] = atomic_load(&histogram->count);
+        out[1] = atomic_load(&histogram->sum);
+        for (int b = 0; b < HIST_BUCKETS; b++)
+            out[2 + b] = atomic_load(&histogram->buckets[b]);
+        maxes[MAX_HIST(h)] = ~atomic_load(&histogram->min);
+        maxes[MAX_HIST(h) + 1] = atomic_load(&histogram->max);
+    }
+
+    for (int p = 0; p < metrics.peer_count; p++)
+    {
+        sums[SUM_PEER(p)] = atomic_load(&metrics.peers[p].count);
+        sums[SUM_PEER(p) + 1] = atomic_load(&metrics.peers[p].sum);
+        maxes[MAX_PEER(p)] = atomic_load(&metrics.peers[p].max);
+    }
+}
+
+static uint64_t percentile(const uint64_t *buckets, uint64_t count, uint64_t max, double fraction)
+{
+    uint64_t target = (uint64_t)(fraction * count + 0.5);
+    if (target < 1)
+        target = 1;
+    uint64_t seen = 0;
+    for (int b = 0; b < HIST_BUCKETS; b++)
+    {
+        seen += buckets[b];
+        if (seen >= target)
+        {
+            uint64_t upper = bucket_upper(b);
+            return upper < max ? upper : max;
+        }
+    }
+    return max;
+}
+
+static void write_histogram(FILE *file, const uint64_t *sums, const uint64_t *maxes, int h)
+{
+    const uint64_t *data = &sums[SUM_HIST(h)];
+    uint64_t count = data[0];
+    uint64_t min = count ? ~maxes[MAX_HIST(h)] : 0;
+    uint64_t max = maxes[MAX_HIST(h) + 1];
+
+    fprintf(file, "{\"count\": %llu, \"mean_us\": %.3f, \"min_us\": %.3f, \"p50_us\": %.3f, "
+                  "\"p90_us\": %.3f, \"p99_us\": %.3f, \"max_us\": %.3f}",
+            (unsigned long long)count, count ? data[1] / 1e3 / count : 0.0, min / 1e3,
+            percentile(data + 2, count, max, 0.50) / 1e3, percentile(data + 2, count, max, 0.90) / 1e3,
+            percentile(data + 2, count, max, 0.99) / 1e3, max / 1e3);
+}
+
+static int write_report(const char *path, const char *scope, int rank_count,
+                        const uint64_t *sums, const uint64_t *maxes)
+{
+    FILE *file = fopen(path, "w");
+    if (!file)
+        return -1;
+
+    fprintf(file, "{\n  %s,\n  \"ranks\": %d,\n  \"counters\": {", scope, rank_count);
+    for (int c = 0; c < METRIC_COUNTER_COUNT; c++)
+    {
+        uint64_t value = sums[c];
+        // Duratele se pastreaza in ns si se afiseaza in us
+        if (c == METRIC_BOOTSTRAP_NS || c == METRIC_BARRIER_NS)
+            value /= 1000;
+        fprintf(file, "%s\n    \"%s\": %llu", c ? "," : "", counter_names[c], (unsigned long long)value);
+    }
+    uint64_t requests = sums[METRIC_SEGMENT_REQUESTS];
+    fprintf(file, ",\n    \"nack_rate\": %.4f\n  },\n",
+            requests ? (double)sums[METRIC_NACKS] / requests : 0.0);
+
+    fprintf(file, "  \"segment_rtt\": ");
+    write_histogram(file, sums, maxes, HIST_SEGMENT_RTT);
+    fprintf(file, ",\n  \"upload_queue_wait\": ");
+    write_histogram(file, sums, maxes, HIST_UPLOAD_WAIT);
+    fprintf(file, ",\n  \"peer_list_rtt\": ");
+    write_histogram(file, sums, maxes, HIST_PEER_LIST_RTT);
+    fprintf(file, ",\n  \"registration\": ");
+    write_histogram(file, sums, maxes, HIST_REGISTRATION);
+    fprintf(file, ",\n  \"first_segment\": ");
+    write_histogram(file, sums, maxes, HIST_FIRST_SEGMENT);
+
+    fprintf(file, ",\n  \"tracker_service\": {");
+    int first = 1;
+    for (int tag = 0; tag < METRICS_TAG_COUNT; tag++)
+    {
+        if (sums[SUM_HIST(HIST_TRACKER_SERVICE + tag)] == 0)
+            continue;
+        fprintf(file, "%s\n    \"%s\": ", first ? "" : ",", tag_names[tag] ? tag_names[tag] : "OTHER");
+        write_histogram(file, sums, maxes, HIST_TRACKER_SERVICE + tag);
+        first = 0;
+    }
+
+    fprintf(file, "%s},\n  \"peer_rtt\": [", first ? "" : "\n  ");
+    first = 1;
+    for (int p = 0; p < metrics.peer_count; p++)
+    {
+        uint64_t count = sums[SUM_PEER(p)];
+        if (count == 0)
+            continue;
+        fprintf(file, "%s\n    {\"peer\": %d, \"requests\": %llu, \"mean_us\": %.3f, \"max_us\": %.3f}",
+                first ? "" : ",", p, (unsigned long long)count,
+                sums[SUM_PEER(p) + 1] / 1e3 / count, maxes[MAX_PEER(p)] / 1e3);
+        first = 0;
+    }
+    fprintf(file, "%s]\n}\n", first ? "" : "\n  ");
+
+    fclose(file);
+    return 0;
+}
+
+static int allocate_layout(uint64_t **sums, uint64_t **maxes)
+{
+    *sums = (uint64_t *)calloc(SUM_SIZE(metrics.peer_count), sizeof(uint64_t));
+    *maxes = (uint64_t *)calloc(MAX_SIZE(metrics.peer_count), sizeof(uint64_t));
+    if (!*sums || !*maxes)
+    {
+        free(*sums);
+        free(*maxes);
+        return -1;
+    }
+    return 0;
+}
+
+int metrics_write_json(const char *path)
+{
+    uint64_t *sums, *maxes;
+    if (allocate_layout(&sums, &maxes) != 0)
+        return -1;
+
+    snapshot(sums, maxes);
+    char scope[32];
+    snprintf(scope, sizeof(scope), "\"rank\": %d", metrics.rank);
+    int result = write_report(path, scope, 1, sums, maxes);
+
+    free(sums);
+    free(maxes);
+    return result;
+}
+
+int metrics_reduce_json(int root, const char *path)
+{
+    uint64_t *sums, *maxes, *total_sums = NULL, *total_maxes = NULL;
+    if (allocate_layout(&sums, &maxes) != 0)
+        return -1;
+    if (metrics.rank == root && allocate_layout(&total_sums, &total_maxes) != 0)
+    {
+        free(sums);
+        free(maxes);
+        return -1;
+    }
+
+    snapshot(sums, maxes);
+    MPI_Reduce(sums, total_sums, SUM_SIZE(metrics.peer_count), MPI_UINT64_T, MPI_SUM, root, MPI_COMM_WORLD);
+    MPI_Reduce(maxes, total_maxes, MAX_SIZE(metrics.peer_count), MPI_UINT64_T, MPI_MAX, root, MPI_COMM_WORLD);
+
+    int result = 0;
+    if (metrics.rank == root)
+    {
+        result = write_report(path, "\"scope\": \"swarm\"", metrics.peer_count, total_sums, total_maxes);
+        free(total_sums);
+        free(total_maxes);
+    }
+    free(sums);
+    free(maxes);
+    return result;
+}
+
+// Octetii trimisi si primiti se numara prin interfata de profiling MPI,
+// fara modificari la locurile de apel. Receptiile pre-postate (MPI_Irecv)
+// se numara explicit la terminarea lor.
+static void count_message(MetricCounter bytes, MetricCounter messages, int count, MPI_Datatype datatype)
+{
+    int size;
+    PMPI_Type_size(datatype, &size);
+    metrics_add(bytes, (uint64_t)count * size);
+    metrics_add(messages, 1);
+}
+
+int MPI_Send(const void *buf, int count, MPI_Datatype datatype, int dest, int tag, MPI_Comm comm)
+{
+    count_message(METRIC_BYTES_SENT, METRIC_MESSAGES_SENT, count, datatype);
+    return PMPI_Send(buf, count, datatype, dest, tag, comm);
+}
+
+int MPI_Isend(const void *buf, int count, MPI_Datatype datatype, int dest, int tag,
+              MPI_Comm comm, MPI_Request *request)
+{
+    count_message(METRIC_BYTES_SENT, METRIC_MESSAGES_SENT, count, datatype);
+    return PMPI_Isend(buf, count, datatype, dest, tag, comm, request);
+}
+
+int MPI_Recv(void *buf, int count, MPI_Datatype datatype, int source, int tag,
+             MPI_Comm comm, MPI_Status *status)
+{
+    MPI_Status local;
+    if (status == MPI_STATUS_IGNORE)
+        status = &local;
+    int result = PMPI_Recv(buf, count, datatype, source, tag, comm, status);
+    int received;
+    PMPI_Get_count(status, datatype, &received);
+    count_message(METRIC_BYTES_RECEIVED, METRIC_MESSAGES_RECEIVED, received, datatype);
+    return result;
+}
@@ -0,0 +1,84 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "protocol.h"
+
+// Histograma log-liniara in stilul HDR: valorile (nanosecunde) sub
+// 2^HIST_SUB_BITS au cate un bucket; peste, fiecare putere a lui 2 se
+// imparte in 2^HIST_SUB_BITS bucket-uri egale, deci eroarea relativa este
+// sub 1 / 2^HIST_SUB_BITS. Valorile peste 2^HIST_MAX_BITS ns ajung in
+// ultimul bucket.
+#define HIST_SUB_BITS 4
+#define HIST_SUB_COUNT (1 << HIST_SUB_BITS)
+#define HIST_MAX_BITS 40
+#define HIST_BUCKETS (HIST_SUB_COUNT * (HIST_MAX_BITS - HIST_SUB_BITS + 1))
+
+// Etichetele MSG_* sunt mici; tot ce este peste ajunge pe ultima pozitie
+#define METRICS_TAG_COUNT (MSG_GOSSIP + 1)
+
+typedef struct
+{
+    _Atomic uint64_t count;
+    _Atomic uint64_t sum;
+    _Atomic uint64_t min;
+    _Atomic uint64_t max;
+    _Atomic uint64_t buckets[HIST_BUCKETS];
+} Histogram;
+
+typedef enum
+{
+    METRIC_SEGMENT_REQUESTS,
+    METRIC_NACKS,
+    METRIC_BYTES_SENT,
+    METRIC_BYTES_RECEIVED,
+    METRIC_MESSAGES_SENT,
+    METRIC_MESSAGES_RECEIVED,
+    METRIC_BOOTSTRAP_NS,   // tracker: de la pornire pana la prelucrarea tuturor inregistrarilor
+    METRIC_BARRIER_NS,     // tracker: asteptarea barierei de pornire (MPI_Ibarrier)
+    METRIC_PAYLOAD_BYTES,  // continut de segmente descarcat si acceptat
+    METRIC_VERIFY_FAILURES, // continut care nu corespunde hash-ului din lista trackerului
+    METRIC_TRACKER_ALLOCATIONS, // tracker: buffere alocate pentru mesaje, dupa inregistrare
+    METRIC_RMA_READS,      // citiri MPI_Rget din fereastra altui peer (--transport rma)
+    METRIC_LOCAL_REQUESTS, // cereri de segmente catre peers de pe acelasi nod
+    METRIC_NODE_READS,     // segmente copiate din pool-ul unui vecin de nod (--shared-memory)
+    METRIC_COUNTER_COUNT
+} MetricCounter;
+
+typedef enum
+{
+    HIST_SEGMENT_RTT,  // cerere de segment -> raspuns
+    HIST_UPLOAD_WAIT,  // asteptarea unei cereri in coada workerului de upload
+    HIST_PEER_LIST_RTT, // LIST_PEERS -> PEER_LIST, vazut de peer
+    HIST_REGISTRATION, // peer: inceputul inregistrarii -> toti peers inregistrati
+    HIST_FIRST_SEGMENT, // peer: inceputul inregistrarii -> primul segment acceptat
+    HIST_TRACKER_SERVICE, // primele METRICS_TAG_COUNT: cate una pe eticheta
+    HIST_COUNT = HIST_TRACKER_SERVICE + METRICS_TAG_COUNT
+} MetricHistogram;
+
+// Pregateste metricile pentru un rank; peer_count = numarul de rank-uri
+void metrics_init(int rank, int peer_count);
+
+void metrics_add(MetricCounter counter, uint64_t value);
+
+// Valoare in secunde (ca diferentele de MPI_Wtime)
+void metrics_record(MetricHistogram histogram, double seconds);
+
+// Timpul de serviciu al trackerului pentru un mesaj cu eticheta tag
+void metrics_record_tag(int tag, double seconds);
+
+// Durata unei cereri de segment catre peer; intra si in HIST_SEGMENT_RTT
+void metrics_record_rtt(int peer, double seconds);
+
+// Scrie metricile rank-ului in path, ca JSON. Intoarce 0 la succes.
+int metrics_write_json(const char *path);
+
+// Colectiv: toate rank-urile trebuie sa o apeleze. Rank-ul root scrie in
+// path suma metricilor din tot swarm-ul.
+int metrics_reduce_json(int root, const char *path);
+
+void metrics_destroy(void);
+
+#endif
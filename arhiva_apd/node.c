@@ -0,0 +1,227 @@
+#include "node.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NODE_ALIGN 16
+#define NODE_PATH_MAX 256
+#define NODE_POOL_HEADER 64 // capul listei, pe linia lui de cache
+
+// O intrare din lista de fisiere expuse a unui pool. Deplasamentele sunt
+// fata de inceputul pool-ului, pentru ca fiecare rank il vede la alta adresa.
+typedef struct
+{
+    uint64_t next; // intrarea urmatoare, 0 la sfarsit
+    uint32_t file_id;
+    uint32_t total_segments;
+    uint64_t metadata;
+    uint64_t payload_size;
+    char path[NODE_PATH_MAX]; // "" fara continut
+} NodeEntry;
+
+static struct
+{
+    MPI_Comm comm;
+    MPI_Win win;
+    int *local;      // rank din MPI_COMM_WORLD -> pozitia in comm sau -1
+    uint8_t **pools; // pozitia in comm -> pool-ul acelui rank, NULL fara
+    uint8_t *pool;   // pool-ul propriu
+    size_t pool_size;
+    size_t used;
+    int self;
+    pthread_mutex_t lock; // protejeaza used si lista proprie
+} node = {MPI_COMM_NULL, MPI_WIN_NULL, NULL, NULL, NULL, 0, 0, -1, PTHREAD_MUTEX_INITIALIZER};
+
+static _Atomic uint64_t *pool_head(uint8_t *pool)
+{
+    return (_Atomic uint64_t *)pool;
+}
+
+int node_init(int ranks_per_node, size_t pool_size)
+{
+    int rank, rank_count;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &rank_count);
+
+    MPI_Comm shared;
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &shared);
+    if (ranks_per_node > 0)
+    {
+        int local_rank;
+        MPI_Comm_rank(shared, &local_rank);
+        MPI_Comm_split(shared, local_rank / ranks_per_node, local_rank, &node.comm);
+        MPI_Comm_free(&shared);
+    }
+    else
+    {
+        node.comm = shared;
+    }
+
+    int size;
+    MPI_Comm_size(node.comm, &size);
+    MPI_Comm_rank(node.comm, &node.self);
+    int *members = (int *)malloc(size * sizeof(int));
+    node.local = (int *)malloc(rank_count * sizeof(int));
+    node.pools = (uint8_t **)calloc(size, sizeof(uint8_t *));
+    if (!members || !node.local || !node.pools)
+        return -1;
+    MPI_Allgather(&rank, 1, MPI_INT, members, 1, MPI_INT, node.comm);
+    for (int r = 0; r < rank_count; r++)
+    {
+        node.local[r] = -1;
+    }
+    for (int i = 0; i < size; i++)
+    {
+        node.local[members[i]] = i;
+    }
+    free(members);
+
+    // Fereastra exista doar daca vreun rank de pe nod are pool
+    unsigned long requested = pool_size > 0 ? pool_size + NODE_POOL_HEADER : 0, largest;
+    MPI_Allreduce(&requested, &largest, 1, MPI_UNSIGNED_LONG, MPI_MAX, node.comm);
+    if (largest == 0)
+        return 0;
+
+    // Fiecare pool pe paginile lui, nu lipit de al vecinului
+    MPI_Info info;
+    MPI_Info_create(&info);
+    MPI_Info_set(info, "alloc_shared_noncontig", "true");
+    int result = MPI_Win_allocate_shared((MPI_Aint)requested, 1, info, node.comm, &node.pool, &node.win);
+    MPI_Info_free(&info);
+    if (result != MPI_SUCCESS)
+        return -1;
+
+    if (requested > 0)
+    {
+        atomic_init(pool_head(node.pool), 0);
+        node.pool_size = requested;
+        node.used = NODE_POOL_HEADER;
+    }
+    else
+    {
+        node.pool = NULL;
+    }
+    for (int i = 0; i < size; i++)
+    {
+        MPI_Aint bytes;
+        int unit;
+        uint8_t *base;
+        MPI_Win_shared_query(node.win, i, &bytes, &unit, &base);
+        node.pools[i] = bytes > 0 ? base : NULL;
+    }
+    // Capetele listelor sunt initializate inainte ca vreun vecin sa le citeasca
+    MPI_Barrier(node.comm);
+    return 0;
+}
+
+void node_finalize(void)
+{
+    if (node.win != MPI_WIN_NULL)
+        MPI_Win_free(&node.win);
+    if (node.comm != MPI_COMM_NULL)
+        MPI_Comm_free(&node.comm);
+    free(node.local);
+    free(node.pools);
+    node.local = NULL;
+    node.pools = NULL;
+    node.pool = NULL;
+    node.pool_size = node.used = 0;
+}
+
+int node_is_local(int rank)
+{
+    return node.local && node.local[rank] != -1 && node.local[rank] != node.self;
+}
+
+// Se apeleaza cu lock tinut
+static void *pool_take(size_t size)
+{
+    size = (size + NODE_ALIGN - 1) & ~(size_t)(NODE_ALIGN - 1);
+    if (!node.pool || size > node.pool_size - node.used)
+        return NULL;
+    void *result = node.pool + node.used;
+    node.used += size;
+    memset(result, 0, size);
+    return result;
+}
+
+void *node_alloc(size_t size)
+{
+    pthread_mutex_lock(&node.lock);
+    void *result = pool_take(size);
+    pthread_mutex_unlock(&node.lock);
+    return result;
+}
+
+int node_publish(const FileDetails *file, const char *path)
+{
+    const uint8_t *metadata = file->digests;
+    if (!node.pool || metadata < node.pool || metadata >= node.pool + node.pool_size ||
+        (path && strlen(path) >= NODE_PATH_MAX))
+        return -1;
+
+    pthread_mutex_lock(&node.lock);
+    _Atomic uint64_t *head = pool_head(node.pool);
+    uint64_t first = atomic_load_explicit(head, memory_order_relaxed);
+    for (uint64_t offset = first; offset != 0;)
+    {
+        const NodeEntry *entry = (const NodeEntry *)(node.pool + offset);
+        if (entry->file_id == file->file_id)
+        {
+            pthread_mutex_unlock(&node.lock);
+            return 0;
+        }
+        offset = entry->next;
+    }
+
+    NodeEntry *entry = (NodeEntry *)pool_take(sizeof(NodeEntry));
+    if (entry)
+    {
+        entry->next = first;
+        entry->file_id = file->file_id;
+        entry->total_segments = file->total_segments;
+        entry->metadata = (uint64_t)(metadata - node.pool);
+        entry->payload_size = file->payload ? file->payload_size : 0;
+        if (path)
+            strcpy(entry->path, path);
+        // Intrarea este completa inainte sa apara in lista
+        atomic_store_explicit(head, (uint64_t)((uint8_t *)entry - node.pool), memory_order_release);
+    }
+    pthread_mutex_unlock(&node.lock);
+    return entry ? 0 : -1;
+}
+
+int node_open(int rank, uint32_t file_id, NodeFile *file)
+{
+    memset(file, 0, sizeof(*file));
+    if (!node_is_local(rank) || !node.pools[node.local[rank]])
+        return -1;
+
+    uint8_t *pool = node.pools[node.local[rank]];
+    uint64_t offset = atomic_load_explicit(pool_head(pool), memory_order_acquire);
+    while (offset != 0)
+    {
+        const NodeEntry *entry = (const NodeEntry *)(pool + offset);
+        if (entry->file_id == file_id)
+        {
+            if (entry->path[0] != '\0' &&
+                (payload_map_source(&file->payload, entry->path) != 0 || file->payload.size != entry->payload_size))
+            {
+                node_close(file);
+                return -1;
+            }
+            file->total_segments = entry->total_segments;
+            file->metadata = pool + entry->metadata;
+            return 0;
+        }
+        offset = entry->next;
+    }
+    return -1;
+}
+
+void node_close(NodeFile *file)
+{
+    payload_unmap(&file->payload);
+    file->metadata = NULL;
+}
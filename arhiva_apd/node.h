@@ -0,0 +1,67 @@
+#ifndef NODE_H
+#define NODE_H
+
+#include <mpi.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "payload.h"
+#include "store.h"
+
+// Rank-urile de pe acelasi nod (MPI_Comm_split_type cu MPI_COMM_TYPE_SHARED).
+// Cu --shared-memory fiecare peer are un pool intr-o fereastra
+// MPI_Win_allocate_shared a nodului: store-ul ii aloca acolo hash-urile si
+// bitii fisierelor, iar fisierele expuse se inlantuie intr-o lista din
+// acelasi pool. Vecinii de nod citesc bitii si hash-urile direct din pool,
+// iar continutul il mapeaza din fisierul proprietarului, deci un segment
+// luat de la ei este o copiere in memorie, fara mesaje si fara MPI.
+
+// Un fisier expus de un vecin de nod, deschis pentru citire
+typedef struct
+{
+    uint32_t total_segments;
+    const uint8_t *metadata; // hash-urile, urmate de biti, in pool-ul vecinului
+    PayloadMap payload;      // continutul mapat doar pentru citire; data NULL fara
+} NodeFile;
+
+// Colectiv pe MPI_COMM_WORLD. ranks_per_node > 0 imparte nodul in grupuri de
+// atatea rank-uri consecutive (noduri simulate pe o singura masina).
+// pool_size = octetii din pool ai acestui rank; 0 fara pool. Intoarce 0 la
+// succes.
+int node_init(int ranks_per_node, size_t pool_size);
+
+// Colectiv; se apeleaza dupa ce niciun rank nu mai citeste din pool-uri
+void node_finalize(void);
+
+// 1 daca rank-ul este pe acelasi nod, altul decat cel curent
+int node_is_local(int rank);
+
+// size octeti initializati cu zero din pool-ul propriu sau NULL daca nu mai
+// are loc; alocatorul de metadate al store-ului
+void *node_alloc(size_t size);
+
+// Expune vecinilor de nod un fisier ale carui hash-uri sunt in pool; path
+// este fisierul cu continutul sau NULL. Al doilea apel pentru acelasi fisier
+// nu face nimic. Intoarce 0 daca fisierul este expus.
+int node_publish(const FileDetails *file, const char *path);
+
+// Deschide fisierul expus de rank, de pe acelasi nod. Intoarce 0 daca l-a
+// gasit; node_close il inchide.
+int node_open(int rank, uint32_t file_id, NodeFile *file);
+void node_close(NodeFile *file);
+
+static inline int node_has_segment(const NodeFile *file, int segment)
+{
+    const _Atomic uint8_t *present =
+        (const _Atomic uint8_t *)(file->metadata + (size_t)file->total_segments * HASH_SIZE);
+    uint8_t byte = atomic_load_explicit(&present[segment / 8], memory_order_acquire);
+    return (byte >> (segment % 8)) & 1;
+}
+
+// Valid doar dupa ce node_has_segment a intors 1 pentru segment
+static inline const uint8_t *node_digest(const NodeFile *file, int segment)
+{
+    return file->metadata + (size_t)segment * HASH_SIZE;
+}
+
+#endif
@@ -0,0 +1,107 @@
+#include "payload.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+int payload_map_source(PayloadMap *map, const char *path)
+{
+    map->data = NULL;
+    map->size = 0;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    map->size = info.st_size;
+    if (map->size > 0)
+    {
+        // Partajata, ca maparea fisierului unui vecin de nod (node.h) sa vada
+        // segmentele scrise de el dupa mapare
+        void *data = mmap(NULL, map->size, PROT_READ, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            close(fd);
+            return -1;
+        }
+        // Fisierul sursa se serveste de obicei intreg, dar in ordinea ceruta de
+        // peers; se incarca de la inceput, ca prima cerere pentru un segment
+        // sa nu astepte discul
+        madvise(data, map->size, MADV_WILLNEED);
+        map->data = (uint8_t *)data;
+    }
+
+    // Maparea ramane valida si dupa inchiderea descriptorului
+    close(fd);
+    return 0;
+}
+
+// Mapeaza pentru scriere fisierul deschis cu flags, la size octeti
+static int map_writable(PayloadMap *map, const char *path, uint64_t size, int flags)
+{
+    map->data = NULL;
+    map->size = size;
+
+    int fd = open(path, O_RDWR | O_CREAT | flags, 0644);
+    if (fd < 0)
+        return -1;
+
+    if (ftruncate(fd, size) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    // Blocurile rezervate acum nu mai sunt alocate la prima scriere in
+    // fiecare pagina; fara suport, fisierul ramane rar
+    if (size > 0)
+        posix_fallocate(fd, 0, size);
+
+    if (size > 0)
+    {
+        void *data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (data == MAP_FAILED)
+        {
+            close(fd);
+            return -1;
+        }
+        map->data = (uint8_t *)data;
+    }
+
+    close(fd);
+    return 0;
+}
+
+int payload_map_destination(PayloadMap *map, const char *path, uint64_t size)
+{
+    return map_writable(map, path, size, O_TRUNC);
+}
+
+int payload_map_existing(PayloadMap *map, const char *path, uint64_t size)
+{
+    return map_writable(map, path, size, 0);
+}
+
+int payload_sync(const PayloadMap *map)
+{
+    if (!map->data)
+        return 0;
+    return msync(map->data, map->size, MS_SYNC);
+}
+
+void payload_unmap(PayloadMap *map)
+{
+    if (map->data)
+    {
+        munmap(map->data, map->size);
+    }
+    map->data = NULL;
+    map->size = 0;
+}
@@ -0,0 +1,51 @@
+#ifndef PAYLOAD_H
+#define PAYLOAD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Continutul unui fisier mapat in memorie. Segmentele se trimit direct din
+// mapare si se primesc direct in ea, fara buffere intermediare.
+typedef struct
+{
+    uint8_t *data; // NULL pentru un fisier gol
+    uint64_t size;
+} PayloadMap;
+
+// Mapeaza un fisier existent doar pentru citire; scrierile altui proces in
+// fisier raman vizibile. Intoarce 0 la succes.
+int payload_map_source(PayloadMap *map, const char *path);
+
+// Creeaza (sau trunchiaza) fisierul la size octeti, cu blocurile rezervate
+// dinainte, si il mapeaza pentru scriere. Intoarce 0 la succes.
+int payload_map_destination(PayloadMap *map, const char *path, uint64_t size);
+
+// Ca payload_map_destination, dar continutul existent se pastreaza (reluarea
+// unei descarcari intrerupte)
+int payload_map_existing(PayloadMap *map, const char *path, uint64_t size);
+
+// Scrie pe disc paginile modificate ale unei mapari de destinatie
+int payload_sync(const PayloadMap *map);
+
+void payload_unmap(PayloadMap *map);
+
+static inline int payload_segment_count(uint64_t size, uint32_t segment_size)
+{
+    return (int)((size + segment_size - 1) / segment_size);
+}
+
+static inline uint64_t payload_segment_offset(int segment, uint32_t segment_size)
+{
+    return (uint64_t)segment * segment_size;
+}
+
+// Ultimul segment poate fi mai scurt
+static inline uint32_t payload_segment_length(uint64_t size, int segment, uint32_t segment_size)
+{
+    uint64_t offset = payload_segment_offset(segment, segment_size);
+    if (offset >= size)
+        return 0;
+    return size - offset < segment_size ? (uint32_t)(size - offset) : segment_size;
+}
+
+#endif
@@ -0,0 +1,155 @@
+#include "protocol.h"
+
+#include <string.h>
+
+#include "bitfield.h"
+
+uint32_t proto_file_id(const char *filename)
+{
+    uint32_t hash = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)filename; *p; p++)
+    {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void proto_header_init(MsgHeader *hdr, int type, int flags)
+{
+    hdr->version = PROTO_VERSION;
+    hdr->flags = (uint8_t)flags;
+    hdr->type = (uint16_t)type;
+}
+
+static int check_header(const void *buf, int size, int type)
+{
+    const MsgHeader *hdr = (const MsgHeader *)buf;
+
+    if (size < (int)sizeof(MsgHeader))
+        return -1;
+    if (hdr->version != PROTO_VERSION || hdr->type != type)
+        return -1;
+    return 0;
+}
+
+int proto_check(const void *buf, int size, int type, size_t expected_size)
+{
+    if (check_header(buf, size, type) != 0)
+        return -1;
+    return (size_t)size == expected_size ? 0 : -1;
+}
+
+int proto_reply_tag(const FileMsg *msg, int default_tag)
+{
+    return msg->reply_tag >= MSG_WORKER_TAG_BASE ? msg->reply_tag : default_tag;
+}
+
+size_t proto_init_size(uint32_t file_count)
+{
+    return sizeof(InitMsg) + (size_t)file_count * sizeof(FileEntry);
+}
+
+int proto_check_init(const void *buf, int size)
+{
+    if (check_header(buf, size, MSG_INIT) != 0 || size < (int)sizeof(InitMsg))
+        return -1;
+
+    const InitMsg *msg = (const InitMsg *)buf;
+    if ((size_t)size != proto_init_size(msg->file_count))
+        return -1;
+
+    for (uint32_t i = 0; i < msg->file_count; i++)
+    {
+        if (memchr(msg->files[i].filename, '\0', MAX_FILENAME) == NULL)
+            return -1;
+    }
+    return 0;
+}
+
+size_t proto_upload_size(uint32_t hash_count)
+{
+    return sizeof(UploadMsg) + (size_t)hash_count * HASH_SIZE;
+}
+
+int proto_check_upload(const void *buf, int size)
+{
+    if (check_header(buf, size, MSG_UPLOAD) != 0 || size < (int)sizeof(UploadMsg))
+        return -1;
+
+    const UploadMsg *msg = (const UploadMsg *)buf;
+    return (size_t)size == proto_upload_size(msg->hash_count) ? 0 : -1;
+}
+
+size_t proto_peer_list_size(uint32_t peer_count, uint32_t hash_count, uint32_t bitfield_bytes)
+{
+    return sizeof(PeerListMsg) + (size_t)peer_count * sizeof(int32_t) +
+           (size_t)hash_count * HASH_SIZE + (size_t)peer_count * bitfield_bytes;
+}
+
+int proto_check_peer_list(const void *buf, int size)
+{
+    if (check_header(buf, size, MSG_PEER_LIST) != 0 || size < (int)sizeof(PeerListMsg))
+        return -1;
+
+    const PeerListMsg *msg = (const PeerListMsg *)buf;
+    if (msg->hash_count > msg->total_segments ||
+        (msg->bitfield_bytes != 0 && msg->bitfield_bytes != bitfield_bytes(msg->total_segments)))
+        return -1;
+    return (size_t)size == proto_peer_list_size(msg->peer_count, msg->hash_count, msg->bitfield_bytes) ? 0 : -1;
+}
+
+uint8_t *proto_peer_list_digests(PeerListMsg *msg)
+{
+    return (uint8_t *)&msg->peers[msg->peer_count];
+}
+
+uint8_t *proto_peer_list_bitfields(PeerListMsg *msg)
+{
+    return proto_peer_list_digests(msg) + (size_t)msg->hash_count * HASH_SIZE;
+}
+
+size_t proto_bitfield_size(uint32_t segment_count)
+{
+    return sizeof(BitfieldMsg) + bitfield_bytes(segment_count);
+}
+
+int proto_check_bitfield(const void *buf, int size, int type)
+{
+    if (check_header(buf, size, type) != 0 || size < (int)sizeof(BitfieldMsg))
+        return -1;
+
+    const BitfieldMsg *msg = (const BitfieldMsg *)buf;
+    return (size_t)size == proto_bitfield_size(msg->segment_count) ? 0 : -1;
+}
+
+size_t proto_record_size(size_t size)
+{
+    return (sizeof(RecordHeader) + size + RECORD_ALIGN - 1) / RECORD_ALIGN * RECORD_ALIGN;
+}
+
+const void *proto_next_record(const void *block, size_t block_size, size_t *offset, int *tag, int *size)
+{
+    if (*offset + sizeof(RecordHeader) > block_size)
+        return NULL;
+
+    const RecordHeader *record = (const RecordHeader *)((const uint8_t *)block + *offset);
+    if (record->size > block_size - *offset - sizeof(RecordHeader))
+        return NULL;
+
+    *tag = (int)record->tag;
+    *size = (int)record->size;
+    *offset += proto_record_size(record->size);
+    return record + 1;
+}
+
+void proto_digest_from_str(uint8_t *digest, const char *hash)
+{
+    strncpy((char *)digest, hash, HASH_SIZE);
+}
+
+void proto_digest_to_str(char *hash, const uint8_t *digest)
+{
+    memcpy(hash, digest, HASH_SIZE);
+    hash[HASH_SIZE] = '\0';
+}
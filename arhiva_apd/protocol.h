@@ -0,0 +1,206 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define PROTO_VERSION 10
+#define MAX_FILENAME 50
+#define HASH_SIZE 32
+
+// Definirea etichetelor de mesaje
+#define MSG_INIT 1
+#define MSG_UPLOAD 2
+#define MSG_ACK 3 // nefolosit: inregistrarea se incheie cu MPI_Ibarrier
+#define MSG_LIST_PEERS 4
+#define MSG_PEER_LIST 5
+#define MSG_DOWNLOAD_REQUEST 6
+#define MSG_DOWNLOAD_RESPONSE 7
+#define MSG_FINISH_DOWNLOAD 8
+#define MSG_FINALIZE_ALL 9
+#define MSG_END_UPLOAD 10
+#define MSG_START_DOWNLOAD 11
+#define MSG_RECEIVED_SEGMENT 12
+#define MSG_SEGMENT_BITFIELD 13
+#define MSG_HAVE 14
+#define MSG_PEER_BITFIELD 15
+
+// Mesajele de gossip intre peers (HAVE, PEER_BITFIELD) circula pe aceeasi
+// eticheta; tipul se afla din antet
+#define MSG_GOSSIP 16
+
+// Raspunsurile la LIST_PEERS si DOWNLOAD_REQUEST pleaca pe eticheta ceruta
+// de expeditor. Fiecare worker de download are propria pereche de etichete,
+// ca raspunsurile sa nu fie preluate de alt fir.
+#define MSG_WORKER_TAG_BASE 100
+#define WORKER_RESPONSE_TAG(w) (MSG_WORKER_TAG_BASE + 2 * (w))
+#define WORKER_PEER_LIST_TAG(w) (MSG_WORKER_TAG_BASE + 2 * (w) + 1)
+
+// Continutul unui segment pleaca separat de raspuns, pe eticheta slotului din
+// fereastra care l-a cerut, si ajunge direct in fisierul mapat al acestuia
+#define MSG_PAYLOAD_TAG_BASE 1000
+#define MAX_REQUEST_WINDOW 256
+#define WORKER_PAYLOAD_TAG(w, slot) (MSG_PAYLOAD_TAG_BASE + (w) * MAX_REQUEST_WINDOW + (slot))
+
+// Flag-uri din antetul mesajelor
+#define MSG_FLAG_TERMINATE 0x01 // DOWNLOAD_REQUEST: oprirea firului de upload
+#define MSG_FLAG_NACK 0x02      // DOWNLOAD_RESPONSE: segmentul nu este detinut; PEER_LIST: fisierul nu are manifest
+#define MSG_FLAG_LAST 0x04      // UPLOAD: ultimul mesaj din inregistrarea unui peer
+#define MSG_FLAG_INTERESTED 0x08 // PEER_BITFIELD: expeditorul descarca fisierul si vrea HAVE-uri
+#define MSG_FLAG_REPLY 0x10      // PEER_BITFIELD: raspuns, nu se mai raspunde la el
+
+// Toate mesajele circula ca MPI_BYTE si incep cu acest antet de dimensiune fixa.
+// Layout-ul este cel nativ al masinii (toate rank-urile ruleaza acelasi binar).
+typedef struct
+{
+    uint8_t version;
+    uint8_t flags;
+    uint16_t type; // eticheta MSG_* pentru care a fost construit mesajul
+} MsgHeader;
+
+// ACK, FINALIZE_ALL, END_UPLOAD, START_DOWNLOAD
+typedef struct
+{
+    MsgHeader hdr;
+    int32_t rank;
+} ControlMsg;
+
+// LIST_PEERS, DOWNLOAD_REQUEST, FINISH_DOWNLOAD, RECEIVED_SEGMENT, HAVE
+typedef struct
+{
+    MsgHeader hdr;
+    uint32_t file_id;
+    uint32_t segment_index; // LIST_PEERS: versiunea listei detinute de client; 0 = fara manifest
+    int32_t reply_tag;   // eticheta raspunsului (LIST_PEERS, DOWNLOAD_REQUEST)
+    int32_t payload_tag; // DOWNLOAD_REQUEST: eticheta continutului; 0 = doar hash-ul
+} FileMsg;
+
+// DOWNLOAD_RESPONSE
+typedef struct
+{
+    MsgHeader hdr;
+    uint32_t file_id;
+    uint32_t segment_index;
+    uint8_t digest[HASH_SIZE]; // textul hash-ului, fara terminator
+} SegmentHashMsg;
+
+// Flag-uri din FileEntry
+#define FILE_ENTRY_PARTIAL 0x01 // descarcare reluata: segmentele detinute sosesc intr-un SEGMENT_BITFIELD
+
+// Descrierea unui fisier din mesajul INIT
+typedef struct
+{
+    uint32_t file_id;
+    uint32_t total_segments;
+    uint64_t file_size; // octetii continutului; 0 fara continut
+    uint32_t flags;     // FILE_ENTRY_*
+    char filename[MAX_FILENAME];
+} FileEntry;
+
+// UPLOAD: toate hash-urile unui fisier detinut de un peer, in ordinea
+// segmentelor (hash_count digest-uri de HASH_SIZE octeti)
+typedef struct
+{
+    MsgHeader hdr;
+    uint32_t file_id;
+    uint32_t hash_count;
+    uint8_t digests[];
+} UploadMsg;
+
+// INIT: lista fisierelor detinute de un peer
+typedef struct
+{
+    MsgHeader hdr;
+    uint32_t file_count;
+    FileEntry files[];
+} InitMsg;
+
+// PEER_LIST: manifestul unui fisier intr-un singur mesaj. Dupa cei
+// peer_count detinatori urmeaza hash_count digest-uri de HASH_SIZE octeti,
+// in ordinea segmentelor, apoi cate un bitfield de bitfield_bytes octeti
+// pentru fiecare detinator, in ordinea din peers. Raspunsul la o cerere cu
+// o versiune cunoscuta nu are hash-uri si contine doar detinatorii schimbati
+// de atunci; clientul retine version pentru urmatoarea cerere.
+typedef struct
+{
+    MsgHeader hdr;
+    uint32_t file_id;
+    uint64_t file_size;
+    uint32_t total_segments;
+    uint32_t peer_count;
+    uint32_t hash_count;
+    uint32_t bitfield_bytes; // 0 daca mesajul nu contine bitfield-uri
+    uint32_t version;
+    int32_t peers[];
+} PeerListMsg;
+
+// SEGMENT_BITFIELD, PEER_BITFIELD: segmentele detinute de expeditor dintr-un
+// fisier (bitfield_bytes(segment_count) octeti)
+typedef struct
+{
+    MsgHeader hdr;
+    uint32_t file_id;
+    uint32_t segment_count;
+    uint8_t bits[];
+} BitfieldMsg;
+
+// Inregistrarea unui peer la un shard ajunge la tracker printr-un singur
+// MPI_Gatherv: mesajele INIT, SEGMENT_BITFIELD si UPLOAD puse unul dupa
+// altul, fiecare precedat de acest antet si aliniat la 8 octeti
+typedef struct
+{
+    uint32_t size; // octetii mesajului, fara antet si padding
+    uint32_t tag;  // eticheta MSG_* cu care ar fi fost trimis
+} RecordHeader;
+
+#define RECORD_ALIGN 8
+
+// INIT cu --early-start: fiecare peer isi trimite singur inregistrarea.
+// Mesajul anunta blocul de size octeti, care urmeaza pe eticheta MSG_UPLOAD.
+typedef struct
+{
+    MsgHeader hdr;
+    uint32_t size;
+} RegisterMsg;
+
+// Identificatorul unui fisier este derivat din nume (FNV-1a pe 32 de biti),
+// astfel incat tracker-ul si peers il calculeaza independent.
+uint32_t proto_file_id(const char *filename);
+
+void proto_header_init(MsgHeader *hdr, int type, int flags);
+
+// Verifica versiunea, tipul si dimensiunea unui mesaj de lungime fixa
+int proto_check(const void *buf, int size, int type, size_t expected_size);
+
+// Eticheta pe care trebuie trimis raspunsul la o cerere FileMsg
+int proto_reply_tag(const FileMsg *msg, int default_tag);
+
+size_t proto_init_size(uint32_t file_count);
+int proto_check_init(const void *buf, int size);
+
+size_t proto_upload_size(uint32_t hash_count);
+int proto_check_upload(const void *buf, int size);
+
+size_t proto_peer_list_size(uint32_t peer_count, uint32_t hash_count, uint32_t bitfield_bytes);
+int proto_check_peer_list(const void *buf, int size);
+uint8_t *proto_peer_list_digests(PeerListMsg *msg);
+uint8_t *proto_peer_list_bitfields(PeerListMsg *msg);
+
+size_t proto_bitfield_size(uint32_t segment_count);
+int proto_check_bitfield(const void *buf, int size, int type);
+
+// Spatiul ocupat in bloc de un mesaj de size octeti
+size_t proto_record_size(size_t size);
+
+// Urmatorul mesaj din blocul de inregistrare, incepand de la *offset, pe care
+// il avanseaza. Intoarce mesajul, NULL la sfarsitul blocului sau daca
+// inregistrarea este trunchiata (atunci *offset ramane neschimbat).
+const void *proto_next_record(const void *block, size_t block_size, size_t *offset, int *tag, int *size);
+
+// Conversii intre hash-ul ca sir (HASH_SIZE + 1, cu terminator) si forma de
+// pe fir: aceleasi HASH_SIZE caractere, fara terminator. Hash-urile din
+// intrari nu sunt neaparat hex, deci nu se decodeaza.
+void proto_digest_from_str(uint8_t *digest, const char *hash);
+void proto_digest_to_str(char *hash, const uint8_t *digest);
+
+#endif
@@ -0,0 +1,101 @@
+#include "resume.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "bitfield.h"
+
+static size_t state_size(uint32_t total_segments)
+{
+    return sizeof(ResumeHeader) + (size_t)total_segments * HASH_SIZE + bitfield_bytes(total_segments);
+}
+
+static int map_state(ResumeState *state, int fd, uint32_t total_segments)
+{
+    size_t size = state_size(total_segments);
+    void *data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED)
+    {
+        return -1;
+    }
+
+    state->header = (ResumeHeader *)data;
+    state->digests = (uint8_t *)data + sizeof(ResumeHeader);
+    state->bits = (_Atomic uint8_t *)(state->digests + (size_t)total_segments * HASH_SIZE);
+    state->size = size;
+    return 0;
+}
+
+int resume_load(ResumeState *state, const char *path)
+{
+    memset(state, 0, sizeof(*state));
+
+    int fd = open(path, O_RDWR);
+    if (fd < 0)
+        return -1;
+
+    struct stat info;
+    ResumeHeader header;
+    if (fstat(fd, &info) != 0 || pread(fd, &header, sizeof(header), 0) != sizeof(header) ||
+        header.magic != RESUME_MAGIC || (size_t)info.st_size != state_size(header.total_segments))
+    {
+        close(fd);
+        return -1;
+    }
+
+    int result = map_state(state, fd, header.total_segments);
+    close(fd);
+    return result;
+}
+
+int resume_open(ResumeState *state, const char *path, const ResumeHeader *expected, const uint8_t *digests)
+{
+    size_t manifest_size = (size_t)expected->total_segments * HASH_SIZE;
+
+    if (resume_load(state, path) == 0)
+    {
+        const ResumeHeader *header = state->header;
+        if (header->file_id == expected->file_id && header->total_segments == expected->total_segments &&
+            header->segment_size == expected->segment_size && header->file_size == expected->file_size &&
+            memcmp(state->digests, digests, manifest_size) == 0)
+        {
+            return 1;
+        }
+        resume_close(state);
+    }
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return -1;
+
+    if (ftruncate(fd, state_size(expected->total_segments)) != 0 ||
+        map_state(state, fd, expected->total_segments) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    close(fd);
+
+    // Antetul se scrie ultimul, ca o stare scrisa pe jumatate sa nu fie acceptata
+    memcpy(state->digests, digests, manifest_size);
+    state->header->file_id = expected->file_id;
+    state->header->total_segments = expected->total_segments;
+    state->header->segment_size = expected->segment_size;
+    state->header->file_size = expected->file_size;
+    atomic_thread_fence(memory_order_release);
+    state->header->magic = RESUME_MAGIC;
+    return 0;
+}
+
+void resume_close(ResumeState *state)
+{
+    if (state->header)
+    {
+        msync(state->header, state->size, MS_ASYNC);
+        munmap(state->header, state->size);
+    }
+    memset(state, 0, sizeof(*state));
+}
@@ -0,0 +1,61 @@
+#ifndef RESUME_H
+#define RESUME_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "protocol.h"
+
+// Starea persistata a unei descarcari (client<rank>_<nume>.state), mapata in
+// memorie: antetul, manifestul primit de la tracker si un bit pentru fiecare
+// segment verificat si scris. Bitii se scriu direct in pagina mapata, deci
+// supravietuiesc opririi brusce a procesului; la repornire peer-ul verifica
+// din nou segmentele marcate si le anunta tracker-ului ca detinute.
+#define RESUME_MAGIC 0x31545352 // "RST1"
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t file_id;
+    uint32_t total_segments;
+    uint32_t segment_size; // 0 fara continut
+    uint64_t file_size;
+} ResumeHeader;
+
+typedef struct
+{
+    ResumeHeader *header; // NULL daca descarcarea nu are stare
+    uint8_t *digests;     // total_segments * HASH_SIZE octeti
+    _Atomic uint8_t *bits;
+    size_t size;
+} ResumeState;
+
+// Mapeaza o stare existenta si ii verifica dimensiunea. Intoarce 0 la succes.
+int resume_load(ResumeState *state, const char *path);
+
+// Mapeaza starea pentru manifestul dat. O stare existenta pentru acelasi
+// manifest isi pastreaza bitii; altfel fisierul se rescrie fara niciun
+// segment. Intoarce 1 daca s-a pastrat, 0 daca s-a rescris, -1 la eroare.
+int resume_open(ResumeState *state, const char *path, const ResumeHeader *expected, const uint8_t *digests);
+
+void resume_close(ResumeState *state);
+
+// Marcheaza un segment deja scris pe disc; apelabila din mai multe fire
+static inline void resume_mark(ResumeState *state, int segment)
+{
+    atomic_fetch_or_explicit(&state->bits[segment / 8], (uint8_t)(1 << (segment % 8)), memory_order_release);
+}
+
+static inline void resume_clear(ResumeState *state, int segment)
+{
+    atomic_fetch_and_explicit(&state->bits[segment / 8], (uint8_t)~(1 << (segment % 8)), memory_order_relaxed);
+}
+
+static inline int resume_has(const ResumeState *state, int segment)
+{
+    uint8_t byte = atomic_load_explicit(&state->bits[segment / 8], memory_order_acquire);
+    return (byte >> (segment % 8)) & 1;
+}
+
+#endif
@@ -0,0 +1,231 @@
+#include "rma.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "metrics.h"
+
+// Limita implicita a regiunilor atasate (cea mai mica din versiunile Open MPI)
+#define RMA_DEFAULT_MAX_REGIONS 32
+
+// Directorul unui rank, atasat la fereastra la rma_init. Intrarile se
+// completeaza inainte ca count sa le faca vizibile.
+typedef struct
+{
+    _Atomic uint32_t count;
+    uint32_t capacity;
+    RmaFile files[];
+} RmaDirectory;
+
+// Adresa si dimensiunea directorului unui rank
+typedef struct
+{
+    MPI_Aint address;
+    MPI_Aint size;
+} RmaRemote;
+
+static struct
+{
+    MPI_Win win;
+    int active;
+    pthread_mutex_t lock; // protejeaza directorul local si regiunile atasate
+    RmaDirectory *directory;
+    RmaRemote *remotes; // rank -> directorul lui
+    void **regions;     // regiunile atasate, detasate la rma_finalize
+    int region_count;
+    int region_capacity;
+    int max_regions;
+} rma = {MPI_WIN_NULL, 0, PTHREAD_MUTEX_INITIALIZER, NULL, NULL, NULL, 0, 0, 0};
+
+static size_t directory_size(int capacity)
+{
+    return sizeof(RmaDirectory) + (size_t)capacity * sizeof(RmaFile);
+}
+
+// Cate regiuni accepta o fereastra dinamica. In Open MPI o atasare peste
+// limita (osc_rdma_max_attach) lasa fereastra blocata pentru citiri, deci
+// nu se incearca niciodata. Limita vine din mediu, unde o pune si
+// `mpirun --mca`; interogarea prin MPI_T costa sute de ms la pornire.
+static int max_regions(void)
+{
+    const char *text = getenv("OMPI_MCA_osc_rdma_max_attach");
+    int value = text ? atoi(text) : 0;
+    return value > 0 ? value : RMA_DEFAULT_MAX_REGIONS;
+}
+
+// Ataseaza o regiune la fereastra; se apeleaza cu lock tinut
+static int attach_region(void *base, size_t size)
+{
+    if (rma.region_count == rma.max_regions)
+        return -1;
+    if (rma.region_count == rma.region_capacity)
+    {
+        int capacity = rma.region_capacity ? rma.region_capacity * 2 : 8;
+        void **regions = (void **)realloc(rma.regions, capacity * sizeof(void *));
+        if (!regions)
+            return -1;
+        rma.regions = regions;
+        rma.region_capacity = capacity;
+    }
+
+    if (MPI_Win_attach(rma.win, base, size) != MPI_SUCCESS)
+        return -1;
+    rma.regions[rma.region_count++] = base;
+    return 0;
+}
+
+int rma_init(int capacity)
+{
+    int rank_count;
+    MPI_Comm_size(MPI_COMM_WORLD, &rank_count);
+
+    rma.directory = (RmaDirectory *)calloc(1, directory_size(capacity));
+    rma.remotes = (RmaRemote *)malloc(rank_count * sizeof(RmaRemote));
+    if (!rma.directory || !rma.remotes)
+        return -1;
+    rma.directory->capacity = capacity;
+    rma.max_regions = max_regions();
+
+    MPI_Win_create_dynamic(MPI_INFO_NULL, MPI_COMM_WORLD, &rma.win);
+    // O citire esuata se trateaza ca un segment lipsa
+    MPI_Win_set_errhandler(rma.win, MPI_ERRORS_RETURN);
+    if (attach_region(rma.directory, directory_size(capacity)) != 0)
+        return -1;
+
+    RmaRemote local;
+    MPI_Get_address(rma.directory, &local.address);
+    local.size = directory_size(capacity);
+    MPI_Allgather(&local, 2, MPI_AINT, rma.remotes, 2, MPI_AINT, MPI_COMM_WORLD);
+
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, rma.win);
+    rma.active = 1;
+    return 0;
+}
+
+void rma_finalize(void)
+{
+    if (rma.win == MPI_WIN_NULL)
+        return;
+
+    if (rma.active)
+        MPI_Win_unlock_all(rma.win);
+    for (int i = 0; i < rma.region_count; i++)
+    {
+        MPI_Win_detach(rma.win, rma.regions[i]);
+    }
+    MPI_Win_free(&rma.win);
+
+    free(rma.regions);
+    free(rma.directory);
+    free(rma.remotes);
+    rma.regions = NULL;
+    rma.directory = NULL;
+    rma.remotes = NULL;
+    rma.region_count = rma.region_capacity = 0;
+    rma.active = 0;
+}
+
+int rma_publish(const FileDetails *file)
+{
+    if (!rma.active || file->total_segments == 0)
+        return -1;
+
+    pthread_mutex_lock(&rma.lock);
+    RmaDirectory *directory = rma.directory;
+    uint32_t count = atomic_load_explicit(&directory->count, memory_order_relaxed);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (directory->files[i].file_id == file->file_id)
+        {
+            pthread_mutex_unlock(&rma.lock);
+            return 0;
+        }
+    }
+
+    int result = -1;
+    if (count < directory->capacity &&
+        attach_region(file->digests, store_metadata_size(file->total_segments)) == 0)
+    {
+        if (!file->payload || attach_region(file->payload, file->payload_size) == 0)
+        {
+            RmaFile *entry = &directory->files[count];
+            entry->file_id = file->file_id;
+            entry->total_segments = file->total_segments;
+            entry->payload_size = file->payload ? file->payload_size : 0;
+            MPI_Get_address(file->digests, &entry->metadata);
+            entry->payload = 0;
+            if (file->payload)
+                MPI_Get_address(file->payload, &entry->payload);
+            atomic_store_explicit(&directory->count, count + 1, memory_order_release);
+            result = 0;
+        }
+        else
+        {
+            MPI_Win_detach(rma.win, file->digests);
+            rma.region_count--;
+        }
+    }
+    pthread_mutex_unlock(&rma.lock);
+    return result;
+}
+
+// Octetii cititi se numara la pornirea citirii
+static int read_remote(int rank, MPI_Aint address, void *data, size_t length, MPI_Request *request)
+{
+    if (MPI_Rget(data, (int)length, MPI_BYTE, rank, address, (int)length, MPI_BYTE, rma.win, request) !=
+        MPI_SUCCESS)
+        return -1;
+    metrics_add(METRIC_RMA_READS, 1);
+    metrics_add(METRIC_BYTES_RECEIVED, length);
+    return 0;
+}
+
+int rma_lookup(int rank, uint32_t file_id, RmaFile *file)
+{
+    if (!rma.active)
+        return -1;
+
+    RmaRemote *remote = &rma.remotes[rank];
+    RmaDirectory *copy = (RmaDirectory *)malloc(remote->size);
+    if (!copy)
+        return -1;
+
+    MPI_Request request;
+    int result = -1;
+    if (read_remote(rank, remote->address, copy, remote->size, &request) == 0 &&
+        MPI_Wait(&request, MPI_STATUS_IGNORE) == MPI_SUCCESS)
+    {
+        uint32_t count = atomic_load_explicit(&copy->count, memory_order_relaxed);
+        for (uint32_t i = 0; i < count && i < copy->capacity; i++)
+        {
+            if (copy->files[i].file_id == file_id)
+            {
+                *file = copy->files[i];
+                result = 0;
+                break;
+            }
+        }
+    }
+    free(copy);
+    return result;
+}
+
+int rma_read_present(int rank, const RmaFile *file, int segment, uint8_t *byte, MPI_Request *request)
+{
+    MPI_Aint bits = file->metadata + (MPI_Aint)file->total_segments * HASH_SIZE;
+    return read_remote(rank, bits + segment / 8, byte, 1, request);
+}
+
+int rma_read_digest(int rank, const RmaFile *file, int segment, uint8_t *digest, MPI_Request *request)
+{
+    return read_remote(rank, file->metadata + (MPI_Aint)segment * HASH_SIZE, digest, HASH_SIZE, request);
+}
+
+int rma_read_payload(int rank, const RmaFile *file, uint64_t offset, uint32_t length, uint8_t *data,
+                     MPI_Request *request)
+{
+    if (!file->payload || offset + length > file->payload_size)
+        return -1;
+    return read_remote(rank, file->payload + (MPI_Aint)offset, data, length, request);
+}
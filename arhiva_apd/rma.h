@@ -0,0 +1,54 @@
+#ifndef RMA_H
+#define RMA_H
+
+#include <mpi.h>
+#include <stdint.h>
+
+#include "store.h"
+
+// Transportul one-sided (--transport rma): fiecare rank expune fisierele din
+// store intr-o fereastra MPI dinamica, iar cine descarca citeste hash-urile,
+// bitii si continutul direct cu MPI_Rget, fara firul de upload al celuilalt.
+// Fereastra are un director per rank (adresele lui se afla la rma_init) cu
+// cate o intrare pentru fiecare fisier expus; regiunile unui fisier sunt
+// hash-urile urmate de biti (store_metadata_size) si continutul mapat.
+// Toate rank-urile tin un acces pasiv (MPI_Win_lock_all) intre rma_init si
+// rma_finalize.
+
+// Un fisier expus, asa cum apare in directorul rank-ului care il detine
+typedef struct
+{
+    uint32_t file_id;
+    uint32_t total_segments;
+    uint64_t payload_size;
+    MPI_Aint metadata; // hash-urile, urmate de bitii segmentelor detinute
+    MPI_Aint payload;  // 0 fara continut
+} RmaFile;
+
+// Colectiv pe MPI_COMM_WORLD: creeaza fereastra, cu loc in director pentru
+// capacity fisiere, si afla directoarele celorlalte rank-uri. Intoarce 0 la
+// succes.
+int rma_init(int capacity);
+
+// Colectiv: se apeleaza dupa ce niciun rank nu mai citeste din fereastra
+void rma_finalize(void);
+
+// Expune un fisier din store. Bitii si continutul trebuie sa existe deja
+// (fisierul nu se mai muta); al doilea apel pentru acelasi fisier nu face
+// nimic. Intoarce 0 daca fisierul este expus, -1 daca nu (director plin,
+// prea multe regiuni atasate); atunci ceilalti il cer prin mesaje.
+int rma_publish(const FileDetails *file);
+
+// Cauta fisierul in directorul lui rank; citire sincrona. Intoarce 0 daca
+// l-a gasit. Un fisier este expus inainte ca rank-ul sa anunte vreun segment
+// din el, deci un fisier aflat de la tracker sau din gossip se gaseste.
+int rma_lookup(int rank, uint32_t file_id, RmaFile *file);
+
+// Citiri neblocante din fisierul expus de rank; se termina prin request.
+// Intorc 0 daca citirea a pornit.
+int rma_read_present(int rank, const RmaFile *file, int segment, uint8_t *byte, MPI_Request *request);
+int rma_read_digest(int rank, const RmaFile *file, int segment, uint8_t *digest, MPI_Request *request);
+int rma_read_payload(int rank, const RmaFile *file, uint64_t offset, uint32_t length, uint8_t *data,
+                     MPI_Request *request);
+
+#endif
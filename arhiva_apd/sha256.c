@@ -0,0 +1,399 @@
+#include "sha256.h"
+
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SHA256_X86 1
+#endif
+
+static const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+static const uint32_t H0[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                               0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+static inline uint32_t load_be32(const uint8_t *p)
+{
+    return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+static inline void store_be32(uint8_t *p, uint32_t value)
+{
+    p[0] = value >> 24;
+    p[1] = value >> 16;
+    p[2] = value >> 8;
+    p[3] = value;
+}
+
+// Blocurile unui mesaj: cele complete se citesc direct din mesaj, iar
+// restul, impreuna cu padding-ul si lungimea, din tail (1 sau 2 blocuri)
+typedef struct
+{
+    const uint8_t *data;
+    size_t full_blocks;
+    size_t total_blocks;
+    uint8_t tail[128];
+} MessageBlocks;
+
+static void blocks_init(MessageBlocks *blocks, const uint8_t *data, size_t length)
+{
+    size_t rest = length % 64;
+    blocks->data = data;
+    blocks->full_blocks = length / 64;
+
+    memset(blocks->tail, 0, sizeof(blocks->tail));
+    if (rest)
+        memcpy(blocks->tail, data + blocks->full_blocks * 64, rest);
+    blocks->tail[rest] = 0x80;
+
+    size_t tail_blocks = rest + 9 > 64 ? 2 : 1;
+    uint64_t bits = (uint64_t)length * 8;
+    store_be32(blocks->tail + tail_blocks * 64 - 8, (uint32_t)(bits >> 32));
+    store_be32(blocks->tail + tail_blocks * 64 - 4, (uint32_t)bits);
+    blocks->total_blocks = blocks->full_blocks + tail_blocks;
+}
+
+static inline const uint8_t *block_at(const MessageBlocks *blocks, size_t index)
+{
+    if (index < blocks->full_blocks)
+        return blocks->data + index * 64;
+    return blocks->tail + (index - blocks->full_blocks) * 64;
+}
+
+// ---------------- Scalar ---------------
+
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void compress_scalar(uint32_t *state, const uint8_t *block)
+{
+    uint32_t w[64];
+    for (int t = 0; t < 16; t++)
+        w[t] = load_be32(block + 4 * t);
+    for (int t = 16; t < 64; t++)
+    {
+        uint32_t s0 = ROTR(w[t - 15], 7) ^ ROTR(w[t - 15], 18) ^ (w[t - 15] >> 3);
+        uint32_t s1 = ROTR(w[t - 2], 17) ^ ROTR(w[t - 2], 19) ^ (w[t - 2] >> 10);
+        w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+    }
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int t = 0; t < 64; t++)
+    {
+        uint32_t t1 = h + (ROTR(e, 6) ^ ROTR(e, 11) ^ ROTR(e, 25)) + ((e & f) ^ (~e & g)) + K[t] + w[t];
+        uint32_t t2 = (ROTR(a, 2) ^ ROTR(a, 13) ^ ROTR(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+void sha256(const void *data, size_t length, uint8_t *digest)
+{
+    MessageBlocks blocks;
+    uint32_t state[8];
+    blocks_init(&blocks, (const uint8_t *)data, length);
+    memcpy(state, H0, sizeof(state));
+    for (size_t i = 0; i < blocks.total_blocks; i++)
+        compress_scalar(state, block_at(&blocks, i));
+    for (int j = 0; j < 8; j++)
+        store_be32(digest + 4 * j, state[j]);
+}
+
+static void many_scalar(Sha256Job *jobs, int count)
+{
+    for (int i = 0; i < count; i++)
+        sha256(jobs[i].data, jobs[i].length, jobs[i].digest);
+}
+
+// ---------------- Multi-buffer SIMD ---------------
+// Fiecare banda a unui registru vectorial tine cuvantul de stare al altui
+// mesaj. Benzile ale caror mesaje s-au terminat mai devreme primesc tot
+// blocuri, dar rezultatul lor se mascheaza la adunarea in stare.
+
+#ifdef SHA256_X86
+
+#define SSE_ROTR(x, n) _mm_or_si128(_mm_srli_epi32(x, n), _mm_slli_epi32(x, 32 - (n)))
+
+static void many_sse2(Sha256Job *jobs, int count)
+{
+    MessageBlocks blocks[4];
+    __m128i state[8];
+    size_t max_blocks = 0;
+
+    for (int l = 0; l < 4; l++)
+    {
+        // Benzile fara mesaj repeta primul mesaj; rezultatul lor se ignora
+        Sha256Job *job = &jobs[l < count ? l : 0];
+        blocks_init(&blocks[l], job->data, job->length);
+        if (blocks[l].total_blocks > max_blocks)
+            max_blocks = blocks[l].total_blocks;
+    }
+    for (int j = 0; j < 8; j++)
+        state[j] = _mm_set1_epi32((int)H0[j]);
+
+    for (size_t i = 0; i < max_blocks; i++)
+    {
+        const uint8_t *p[4];
+        uint32_t active[4];
+        for (int l = 0; l < 4; l++)
+        {
+            active[l] = i < blocks[l].total_blocks ? 0xffffffffu : 0;
+            p[l] = block_at(&blocks[l], active[l] ? i : blocks[l].total_blocks - 1);
+        }
+        __m128i mask = _mm_set_epi32((int)active[3], (int)active[2], (int)active[1], (int)active[0]);
+
+        __m128i w[64];
+        for (int t = 0; t < 16; t++)
+            w[t] = _mm_set_epi32((int)load_be32(p[3] + 4 * t), (int)load_be32(p[2] + 4 * t),
+                                 (int)load_be32(p[1] + 4 * t), (int)load_be32(p[0] + 4 * t));
+        for (int t = 16; t < 64; t++)
+        {
+            __m128i s0 = _mm_xor_si128(_mm_xor_si128(SSE_ROTR(w[t - 15], 7), SSE_ROTR(w[t - 15], 18)),
+                                       _mm_srli_epi32(w[t - 15], 3));
+            __m128i s1 = _mm_xor_si128(_mm_xor_si128(SSE_ROTR(w[t - 2], 17), SSE_ROTR(w[t - 2], 19)),
+                                       _mm_srli_epi32(w[t - 2], 10));
+            w[t] = _mm_add_epi32(_mm_add_epi32(w[t - 16], s0), _mm_add_epi32(w[t - 7], s1));
+        }
+
+        __m128i a = state[0], b = state[1], c = state[2], d = state[3];
+        __m128i e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int t = 0; t < 64; t++)
+        {
+            __m128i s1 = _mm_xor_si128(_mm_xor_si128(SSE_ROTR(e, 6), SSE_ROTR(e, 11)), SSE_ROTR(e, 25));
+            __m128i ch = _mm_xor_si128(_mm_and_si128(e, f), _mm_andnot_si128(e, g));
+            __m128i t1 = _mm_add_epi32(_mm_add_epi32(h, s1),
+                                       _mm_add_epi32(ch, _mm_add_epi32(_mm_set1_epi32((int)K[t]), w[t])));
+            __m128i s0 = _mm_xor_si128(_mm_xor_si128(SSE_ROTR(a, 2), SSE_ROTR(a, 13)), SSE_ROTR(a, 22));
+            __m128i maj = _mm_xor_si128(_mm_xor_si128(_mm_and_si128(a, b), _mm_and_si128(a, c)),
+                                        _mm_and_si128(b, c));
+            __m128i t2 = _mm_add_epi32(s0, maj);
+            h = g;
+            g = f;
+            f = e;
+            e = _mm_add_epi32(d, t1);
+            d = c;
+            c = b;
+            b = a;
+            a = _mm_add_epi32(t1, t2);
+        }
+
+        __m128i result[8] = {a, b, c, d, e, f, g, h};
+        for (int j = 0; j < 8; j++)
+            state[j] = _mm_add_epi32(state[j], _mm_and_si128(mask, result[j]));
+    }
+
+    uint32_t words[8][4];
+    for (int j = 0; j < 8; j++)
+        _mm_storeu_si128((__m128i *)words[j], state[j]);
+    for (int l = 0; l < count && l < 4; l++)
+        for (int j = 0; j < 8; j++)
+            store_be32(jobs[l].digest + 4 * j, words[j][l]);
+}
+
+#define AVX_ROTR(x, n) _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - (n)))
+
+__attribute__((target("avx2"))) static void many_avx2(Sha256Job *jobs, int count)
+{
+    MessageBlocks blocks[8];
+    __m256i state[8];
+    size_t max_blocks = 0;
+
+    for (int l = 0; l < 8; l++)
+    {
+        Sha256Job *job = &jobs[l < count ? l : 0];
+        blocks_init(&blocks[l], job->data, job->length);
+        if (blocks[l].total_blocks > max_blocks)
+            max_blocks = blocks[l].total_blocks;
+    }
+    for (int j = 0; j < 8; j++)
+        state[j] = _mm256_set1_epi32((int)H0[j]);
+
+    // Octetii fiecarui cuvant se inverseaza in registru (big-endian)
+    const __m256i swap = _mm256_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+                                         12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+
+    for (size_t i = 0; i < max_blocks; i++)
+    {
+        const uint8_t *p[8];
+        int active[8];
+        for (int l = 0; l < 8; l++)
+        {
+            active[l] = i < blocks[l].total_blocks ? -1 : 0;
+            p[l] = block_at(&blocks[l], active[l] ? i : blocks[l].total_blocks - 1);
+        }
+        __m256i mask = _mm256_set_epi32(active[7], active[6], active[5], active[4],
+                                        active[3], active[2], active[1], active[0]);
+
+        // Transpunere: cuvantul t al fiecarei benzi, cate 4 cuvinte deodata
+        __m256i w[64];
+        for (int t = 0; t < 16; t += 4)
+        {
+            __m128i r[8];
+            for (int l = 0; l < 8; l++)
+                r[l] = _mm_loadu_si128((const __m128i *)(p[l] + 4 * t));
+            __m256i x0 = _mm256_set_m128i(r[4], r[0]), x1 = _mm256_set_m128i(r[5], r[1]);
+            __m256i x2 = _mm256_set_m128i(r[6], r[2]), x3 = _mm256_set_m128i(r[7], r[3]);
+            __m256i y0 = _mm256_unpacklo_epi32(x0, x1), y1 = _mm256_unpackhi_epi32(x0, x1);
+            __m256i y2 = _mm256_unpacklo_epi32(x2, x3), y3 = _mm256_unpackhi_epi32(x2, x3);
+            w[t] = _mm256_shuffle_epi8(_mm256_unpacklo_epi64(y0, y2), swap);
+            w[t + 1] = _mm256_shuffle_epi8(_mm256_unpackhi_epi64(y0, y2), swap);
+            w[t + 2] = _mm256_shuffle_epi8(_mm256_unpacklo_epi64(y1, y3), swap);
+            w[t + 3] = _mm256_shuffle_epi8(_mm256_unpackhi_epi64(y1, y3), swap);
+        }
+        for (int t = 16; t < 64; t++)
+        {
+            __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(AVX_ROTR(w[t - 15], 7), AVX_ROTR(w[t - 15], 18)),
+                                          _mm256_srli_epi32(w[t - 15], 3));
+            __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(AVX_ROTR(w[t - 2], 17), AVX_ROTR(w[t - 2], 19)),
+                                          _mm256_srli_epi32(w[t - 2], 10));
+            w[t] = _mm256_add_epi32(_mm256_add_epi32(w[t - 16], s0), _mm256_add_epi32(w[t - 7], s1));
+        }
+
+        __m256i a = state[0], b = state[1], c = state[2], d = state[3];
+        __m256i e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int t = 0; t < 64; t++)
+        {
+            __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(AVX_ROTR(e, 6), AVX_ROTR(e, 11)), AVX_ROTR(e, 25));
+            __m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+            __m256i t1 = _mm256_add_epi32(_mm256_add_epi32(h, s1),
+                                          _mm256_add_epi32(ch, _mm256_add_epi32(_mm256_set1_epi32((int)K[t]), w[t])));
+            __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(AVX_ROTR(a, 2), AVX_ROTR(a, 13)), AVX_ROTR(a, 22));
+            __m256i maj = _mm256_xor_si256(_mm256_and_si256(a, _mm256_xor_si256(b, c)), _mm256_and_si256(b, c));
+            __m256i t2 = _mm256_add_epi32(s0, maj);
+            h = g;
+            g = f;
+            f = e;
+            e = _mm256_add_epi32(d, t1);
+            d = c;
+            c = b;
+            b = a;
+            a = _mm256_add_epi32(t1, t2);
+        }
+
+        __m256i result[8] = {a, b, c, d, e, f, g, h};
+        for (int j = 0; j < 8; j++)
+            state[j] = _mm256_add_epi32(state[j], _mm256_and_si256(mask, result[j]));
+    }
+
+    uint32_t words[8][8];
+    for (int j = 0; j < 8; j++)
+        _mm256_storeu_si256((__m256i *)words[j], state[j]);
+    for (int l = 0; l < count && l < 8; l++)
+        for (int j = 0; j < 8; j++)
+            store_be32(jobs[l].digest + 4 * j, words[j][l]);
+}
+
+#endif
+
+// ---------------- Alegerea motorului ---------------
+
+typedef struct
+{
+    const char *name;
+    int lanes;
+    void (*many)(Sha256Job *jobs, int count); // cel mult lanes mesaje
+} Sha256Engine;
+
+static const Sha256Engine engines[] = {
+#ifdef SHA256_X86
+    {"avx2", 8, many_avx2},
+    {"sse2", 4, many_sse2},
+#endif
+    {"scalar", 1, many_scalar},
+};
+
+#define ENGINE_COUNT (int)(sizeof(engines) / sizeof(engines[0]))
+
+static const Sha256Engine *current;
+
+static int engine_supported(const Sha256Engine *engine)
+{
+#ifdef SHA256_X86
+    __builtin_cpu_init();
+    if (strcmp(engine->name, "avx2") == 0)
+        return __builtin_cpu_supports("avx2");
+    if (strcmp(engine->name, "sse2") == 0)
+        return __builtin_cpu_supports("sse2");
+#endif
+    return 1;
+}
+
+int sha256_use_engine(const char *name)
+{
+    for (int i = 0; i < ENGINE_COUNT; i++)
+    {
+        int wanted = strcmp(name, "auto") == 0 || strcmp(name, engines[i].name) == 0;
+        if (wanted && engine_supported(&engines[i]))
+        {
+            // Aceeasi valoare din orice fir, deci scrierea concurenta nu strica nimic
+            __atomic_store_n(&current, &engines[i], __ATOMIC_RELEASE);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static const Sha256Engine *engine(void)
+{
+    const Sha256Engine *selected = __atomic_load_n(&current, __ATOMIC_ACQUIRE);
+    if (!selected)
+    {
+        sha256_use_engine("auto");
+        selected = __atomic_load_n(&current, __ATOMIC_ACQUIRE);
+    }
+    return selected;
+}
+
+const char *sha256_engine(void)
+{
+    return engine()->name;
+}
+
+int sha256_lanes(void)
+{
+    return engine()->lanes;
+}
+
+void sha256_many(Sha256Job *jobs, int count)
+{
+    const Sha256Engine *selected = engine();
+    for (int i = 0; i < count; i += selected->lanes)
+    {
+        int batch = count - i < selected->lanes ? count - i : selected->lanes;
+        // Un mesaj singur nu castiga nimic din benzi
+        if (batch == 1)
+            sha256(jobs[i].data, jobs[i].length, jobs[i].digest);
+        else
+            selected->many(jobs + i, batch);
+    }
+}
+
+void sha256_to_hex(const uint8_t *digest, char *text, size_t chars)
+{
+    static const char hex[] = "0123456789abcdef";
+    for (size_t i = 0; i < chars; i++)
+        text[i] = hex[(digest[i / 2] >> (i % 2 ? 0 : 4)) & 0xf];
+}
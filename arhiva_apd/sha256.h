@@ -0,0 +1,36 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SHA256_DIGEST_SIZE 32
+#define SHA256_MAX_LANES 8
+
+// Un mesaj de hash-uit independent de celelalte
+typedef struct
+{
+    const uint8_t *data;
+    size_t length;
+    uint8_t *digest; // SHA256_DIGEST_SIZE octeti
+} Sha256Job;
+
+void sha256(const void *data, size_t length, uint8_t *digest);
+
+// Hash-uieste count mesaje. Motorul SIMD proceseaza pana la sha256_lanes()
+// mesaje deodata, cate unul pe fiecare banda; mesajele de lungimi apropiate
+// se potrivesc cel mai bine in acelasi lot.
+void sha256_many(Sha256Job *jobs, int count);
+
+// Motorul ales la prima folosire: avx2 (8 benzi), sse2 (4 benzi) sau scalar
+const char *sha256_engine(void);
+int sha256_lanes(void);
+
+// Forteaza un motor ("auto", "scalar", "sse2", "avx2"). Intoarce -1 daca
+// procesorul nu il suporta.
+int sha256_use_engine(const char *name);
+
+// Primii chars / 2 octeti ai digest-ului, in hex, fara terminator
+void sha256_to_hex(const uint8_t *digest, char *text, size_t chars);
+
+#endif
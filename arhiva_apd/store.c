@@ -0,0 +1,124 @@
+#include "store.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define STORE_INITIAL_FILES 8
+
+void store_init(SegmentStore *store, Arena *arena)
+{
+    store->arena = arena;
+    pthread_mutex_init(&store->write_lock, NULL);
+    atomic_init(&store->table, NULL);
+    store->metadata_alloc = NULL;
+}
+
+void store_destroy(SegmentStore *store)
+{
+    // Fisierele si toate tabelele, inclusiv cele retrase, apartin arenei
+    pthread_mutex_destroy(&store->write_lock);
+    atomic_store_explicit(&store->table, NULL, memory_order_relaxed);
+}
+
+FileDetails *store_find(const SegmentStore *store, uint32_t file_id)
+{
+    FileTable *table = atomic_load_explicit(&store->table, memory_order_acquire);
+    if (!table)
+    {
+        return NULL;
+    }
+
+    int count = atomic_load_explicit(&table->count, memory_order_acquire);
+    for (int i = 0; i < count; i++)
+    {
+        if (table->files[i]->file_id == file_id)
+        {
+            return table->files[i];
+        }
+    }
+    return NULL;
+}
+
+// Adauga un fisier la tabela; se apeleaza cu write_lock tinut
+static void publish_file(SegmentStore *store, FileDetails *file)
+{
+    FileTable *table = atomic_load_explicit(&store->table, memory_order_relaxed);
+    int count = table ? atomic_load_explicit(&table->count, memory_order_relaxed) : 0;
+
+    if (table && count < table->capacity)
+    {
+        table->files[count] = file;
+        atomic_store_explicit(&table->count, count + 1, memory_order_release);
+        return;
+    }
+
+    // Tabela plina: se publica o copie de doua ori mai mare
+    int capacity = table ? table->capacity * 2 : STORE_INITIAL_FILES;
+    FileTable *grown = (FileTable *)arena_alloc(store->arena, sizeof(FileTable) + capacity * sizeof(FileDetails *));
+    grown->capacity = capacity;
+    for (int i = 0; i < count; i++)
+    {
+        grown->files[i] = table->files[i];
+    }
+    grown->files[count] = file;
+    atomic_init(&grown->count, count + 1);
+    atomic_store_explicit(&store->table, grown, memory_order_release);
+}
+
+FileDetails *store_add_file(SegmentStore *store, const char *filename, int total_segments)
+{
+    uint32_t file_id = proto_file_id(filename);
+    FileDetails *file = store_find(store, file_id);
+    if (file)
+    {
+        return file;
+    }
+
+    pthread_mutex_lock(&store->write_lock);
+    // Alt scriitor l-a putut adauga intre timp
+    file = store_find(store, file_id);
+    if (!file)
+    {
+        file = (FileDetails *)arena_alloc(store->arena, sizeof(FileDetails));
+        strncpy(file->filename, filename, MAX_FILENAME - 1);
+        file->file_id = file_id;
+        file->total_segments = total_segments;
+        atomic_init(&file->segment_count, 0);
+        // Hash-urile si bitii intr-o singura alocare, expusa ca o singura regiune (rma.h, node.h)
+        size_t size = store_metadata_size(total_segments);
+        file->digests = store->metadata_alloc ? (uint8_t *)store->metadata_alloc(size) : NULL;
+        if (!file->digests)
+            file->digests = (uint8_t *)arena_alloc(store->arena, size);
+        file->present = (_Atomic uint8_t *)(file->digests + (size_t)total_segments * HASH_SIZE);
+        publish_file(store, file);
+    }
+    pthread_mutex_unlock(&store->write_lock);
+    return file;
+}
+
+void store_put_segment(FileDetails *file, int segment, const uint8_t *digest)
+{
+    if (store_has_segment(file, segment))
+    {
+        return;
+    }
+
+    // Hash-ul se scrie inainte ca bitul sa-l faca vizibil cititorilor
+    memcpy(file->digests + (size_t)segment * HASH_SIZE, digest, HASH_SIZE);
+    uint8_t mask = (uint8_t)(1 << (segment % 8));
+    uint8_t old = atomic_fetch_or_explicit(&file->present[segment / 8], mask, memory_order_release);
+    if (!(old & mask))
+    {
+        atomic_fetch_add_explicit(&file->segment_count, 1, memory_order_relaxed);
+    }
+}
+
+void store_copy_bitfield(const FileDetails *file, uint8_t *bits)
+{
+    size_t bytes = bitfield_bytes(file->total_segments);
+    for (size_t i = 0; i < bytes; i++)
+    {
+        bits[i] = atomic_load_explicit(&file->present[i], memory_order_relaxed);
+    }
+}
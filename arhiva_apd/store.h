@@ -0,0 +1,101 @@
+#ifndef STORE_H
+#define STORE_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "arena.h"
+#include "bitfield.h"
+#include "protocol.h"
+
+// Structura informatiilor despre un fisier detinut (complet sau partial).
+// Numele, file_id si total_segments nu se mai schimba dupa publicare;
+// segmentele se publica pe rand prin bitii din `present`.
+typedef struct
+{
+    char filename[MAX_FILENAME];
+    uint32_t file_id;
+    int total_segments;
+    atomic_int segment_count; // segmente detinute
+    uint8_t *digests;         // total_segments * HASH_SIZE octeti, contigui
+    _Atomic uint8_t *present; // cate un bit pentru fiecare segment detinut, imediat dupa digests
+    uint8_t *payload;         // continutul mapat (payload.h) sau NULL; fixat inaintea primului segment
+    uint64_t payload_size;
+} FileDetails;
+
+// Tabela de fisiere publicata cititorilor. Se adauga doar la sfarsit; cand
+// se umple, scriitorul publica o copie mai mare, iar cea veche ramane in
+// arena pana la store_destroy, ca cititorii care o folosesc inca sa nu
+// observe nimic.
+typedef struct
+{
+    atomic_int count;
+    int capacity;
+    FileDetails *files[];
+} FileTable;
+
+// Fisierele detinute de un peer. Cititorii (firele de upload si gossip) nu
+// iau niciun lock: incarca tabela si bitii cu acquire. Scriitorii (firele
+// de download) adauga fisiere sub write_lock si publica segmentele cu
+// release, dupa ce au scris hash-ul.
+typedef struct
+{
+    Arena *arena;
+    pthread_mutex_t write_lock;
+    _Atomic(FileTable *) table;
+    // Memoria initializata cu zero pentru hash-urile si bitii unui fisier
+    // nou sau NULL cand nu mai are; atunci, ca si fara alocator, din arena
+    void *(*metadata_alloc)(size_t size);
+} SegmentStore;
+
+// Octetii de la digests pana la sfarsitul bitilor present
+static inline size_t store_metadata_size(int total_segments)
+{
+    return (size_t)total_segments * HASH_SIZE + bitfield_bytes(total_segments);
+}
+
+void store_init(SegmentStore *store, Arena *arena);
+void store_destroy(SegmentStore *store);
+
+// Intoarce fisierul sau NULL daca nu exista; fara lock
+FileDetails *store_find(const SegmentStore *store, uint32_t file_id);
+
+// Intoarce fisierul, adaugandu-l fara niciun segment daca lipseste
+FileDetails *store_add_file(SegmentStore *store, const char *filename, int total_segments);
+
+// Salveaza hash-ul unui segment si il marcheaza ca detinut. Un segment are
+// un singur scriitor; a doua publicare a lui nu mai schimba nimic.
+void store_put_segment(FileDetails *file, int segment, const uint8_t *digest);
+
+// Copiaza bitii segmentelor detinute in `bits` (bitfield_bytes octeti)
+void store_copy_bitfield(const FileDetails *file, uint8_t *bits);
+
+static inline int store_file_count(const SegmentStore *store)
+{
+    FileTable *table = atomic_load_explicit(&store->table, memory_order_acquire);
+    return table ? atomic_load_explicit(&table->count, memory_order_acquire) : 0;
+}
+
+// Fisierul de pe pozitia index < store_file_count()
+static inline FileDetails *store_file_at(const SegmentStore *store, int index)
+{
+    FileTable *table = atomic_load_explicit(&store->table, memory_order_acquire);
+    return table->files[index];
+}
+
+static inline int store_has_segment(const FileDetails *file, int segment)
+{
+    if (segment < 0 || segment >= file->total_segments)
+        return 0;
+    uint8_t byte = atomic_load_explicit(&file->present[segment / 8], memory_order_acquire);
+    return (byte >> (segment % 8)) & 1;
+}
+
+// Valid doar dupa ce store_has_segment a intors 1 pentru segment
+static inline const uint8_t *store_digest(const FileDetails *file, int segment)
+{
+    return file->digests + (size_t)segment * HASH_SIZE;
+}
+
+#endif
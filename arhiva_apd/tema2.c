@@ -1,56 +1,102 @@
+#include <fcntl.h>
+#include <getopt.h>
+#include <limits.h>
 #include <mpi.h>
 #include <pthread.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
+#include "catalog.h"
+#include "log.h"
+#include "metrics.h"
+#include "node.h"
+#include "payload.h"
+#include "protocol.h"
+#include "resume.h"
+#include "rma.h"
+#include "store.h"
+#include "verify.h"
+
 #define TRACKER_RANK 0
-#define MAX_FILES 10
-#define MAX_FILENAME 50
-#define HASH_SIZE 32
-#define MAX_CHUNKS 100
-#define MAX_PEERS 100
 #define SEGMENT_REQUEST_BATCH 10
+#define DEFAULT_REQUEST_WINDOW 8
+#define MAX_DOWNLOAD_WORKERS 16
+#define DEFAULT_UPLOAD_WORKERS 2
+#define UPLOAD_BUFFERS_PER_WORKER 4
+#define UPLOAD_QUEUE_SIZE 64
+#define DEFAULT_PIECE_PICKER "rarest"
+#define DEFAULT_LOG_LEVEL LOG_LEVEL_INFO
+#define GOSSIP_REQUEST_BATCH 40
+#define DEFAULT_SEGMENT_SIZE (256 * 1024)
+#define DEFAULT_VERIFY_THREADS 2
+#define HASH_LINE_SIZE (HASH_SIZE + 1) // o linie din fisierul de iesire
+#define MAX_SEGMENT_SIZE (1 << 30)
+#define TRACKER_RECV_SLOTS 8 // receptii pre-postate ale trackerului pentru fiecare eticheta
+#define NODE_POOL_SIZE (4 << 20) // hash-urile si bitii expusi vecinilor de nod, cu --shared-memory
+// Eticheta manifestelor cerute la pornire de firul de download; nu se
+// suprapune cu etichetele workerilor
+#define MANIFEST_TAG WORKER_PEER_LIST_TAG(MAX_DOWNLOAD_WORKERS)
+
+// Starea unui vecin in gossip-ul unui fisier
+#define NEIGHBOR_GREETED 0x01    // si-au schimbat bitfield-urile
+#define NEIGHBOR_INTERESTED 0x02 // descarca si el fisierul si primeste HAVE-uri
+
+// Transportul segmentelor intre peers
+#define TRANSPORT_TWO_SIDED 0 // cerere catre firul de upload, raspuns prin mesaje
+#define TRANSPORT_RMA 1       // citire directa din fereastra RMA a peer-ului (rma.h)
+
+// Etapa unei citiri RMA aflate in zbor
+#define RMA_PROBE 1 // bitul segmentului, cand nu se stie ca peer-ul il detine
+#define RMA_FETCH 2 // continutul segmentului sau, fara continut, hash-ul lui
 
-// Definirea etichetelor de mesaje
-#define MSG_INIT 1
-#define MSG_UPLOAD 2
-#define MSG_ACK 3
-#define MSG_LIST_PEERS 4
-#define MSG_PEER_LIST 5
-#define MSG_DOWNLOAD_REQUEST 6
-#define MSG_DOWNLOAD_RESPONSE 7
-#define MSG_FINISH_DOWNLOAD 8
-#define MSG_FINALIZE_ALL 9
-#define MSG_END_UPLOAD 10
-#define MSG_START_DOWNLOAD 11
-#define MSG_RECEIVED_SEGMENT 12
-
-// Structura detaliilor despre fisierele trackerului
-typedef struct
-{
-    char filename[MAX_FILENAME];
-    int total_segments;
-    char segment_hashes[MAX_CHUNKS][HASH_SIZE + 1];
-    int clients_with_file[MAX_PEERS]; // Lista clientilor care detin fisierul
-} TrackerFile;
-
-// Structura informatiilor despre un fisier
+// Structura informatiilor despre descărcare
 typedef struct
 {
     char filename[MAX_FILENAME];
+    uint32_t file_id;
     int total_segments;
-    char segments[MAX_CHUNKS][HASH_SIZE + 1];
-} FileDetails;
+    int segments_downloaded;
+    int segments_finished; // segmente descarcate sau abandonate
+    int segments_total;
+    int *peers;
+    int peer_count;
+    int peer_capacity;
+    int rank_count;
+    int *peer_index;    // rank -> pozitia in peers sau -1
+    int bitfield_bytes;
+    uint8_t *peer_bits; // bitfield-ul de segmente al fiecarui peer, in ordinea din peers
+    uint8_t *neighbor_flags; // rank -> NEIGHBOR_*
+    int *interested;         // vecinii care primesc HAVE-uri; doar se adauga
+    int interested_count;
+    int have_hashes;
+    int unavailable;  // trackerul a raspuns cu NACK: niciun seed nu are fisierul
+    uint8_t *digests; // hash-urile din manifest, segments_total * HASH_SIZE octeti
+    uint64_t file_size;
+    uint8_t *payload; // fisierul mapat in care se primeste continutul sau NULL
+    int output_fd;    // client<rank>_<nume>, scris pe loc cu cate o linie per segment
+    ResumeState resume; // progresul persistat cu --resume; header NULL fara
+    double list_sent;   // trimiterea primului LIST_PEERS, cu --early-start
+    uint32_t list_version; // versiunea listei trackerului deja aplicate
+    RmaFile *remote_files; // rank -> fisierul expus de peer (metadata 0 = necautat), cu --transport rma
+    NodeFile *local_files; // rank -> fisierul deschis al vecinului de nod (metadata NULL = nu), cu --shared-memory
+    pthread_mutex_t lock; // protejeaza peers, vecinii si contoarele de progres
+} DownloadInfo;
 
 // Structura informatiilor pe care le are un peer
 typedef struct
 {
-    FileDetails owned_files[MAX_FILES];
-    int owned_file_count;
-    char requested_files[MAX_FILES][MAX_FILENAME];
+    Arena arena; // memoria fisierelor detinute si a listei de fisiere cerute
+    SegmentStore owned_files; // citit fara lock, vezi store.h
+    int source_count;         // primele fisiere din store, citite din fisierul de intrare
+    char (*requested_files)[MAX_FILENAME];
     int requested_file_count;
+    DownloadInfo *downloads; // publicate pentru firul de gossip, NULL la final
+    int download_count;
+    double start_time;         // inceputul inregistrarii, pentru HIST_FIRST_SEGMENT
+    atomic_int first_segment;  // 1 dupa primul segment acceptat
 } PeerInfo;
 
 // Structura argumentelor pentru firele de upload și download
@@ -58,765 +104,3735 @@ typedef struct
 {
     int rank;
     PeerInfo *peer_info;
-    pthread_mutex_t *peer_info_mutex;
+    pthread_mutex_t *peer_info_mutex; // protejeaza downloads si download_count
 } ThreadArgs;
 
-// Structura informatiilor despre descărcare
+// Un segment de descarcat
 typedef struct
 {
-    char filename[MAX_FILENAME];
-    int total_segments;
-    int segments_downloaded;
-    int segments_total;
-    int peers[MAX_PEERS];
-    int peer_count;
-    char filename_hashes[MAX_CHUNKS][HASH_SIZE + 1];
-} DownloadInfo;
+    DownloadInfo *download;
+    int segment;
+} SegmentTask;
 
-// Variabile globale
-TrackerFile tracker_files[MAX_FILES];
-int tracker_file_count = 0;
+// Coada de segmente a unui worker: proprietarul scoate de la inceput,
+// ceilalti workeri fura de la sfarsit
+typedef struct
+{
+    SegmentTask *tasks;
+    int head;
+    int tail;
+    int capacity;
+    pthread_mutex_t lock;
+} TaskDeque;
+
+// Segmentele se adauga in cozi pe masura ce sosesc manifestele. Cu
+// --early-start, workerii pornesc inainte si asteapta aici cand raman fara
+// segmente, pana nu mai este niciun manifest de asteptat.
+typedef struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t changed;
+    int pending;     // manifeste care nu au sosit inca
+    long generation; // creste la fiecare fisier adaugat in cozi
+} TaskFeed;
 
-PeerInfo global_peer_info;
+// O cerere de segment aflata in zbor
+typedef struct
+{
+    DownloadInfo *download; // NULL daca slotul este liber
+    int segment;
+    int peer;
+    int attempts;
+    int *tried; // peers deja intrebati pentru acest segment
+    int tried_count;
+    int tried_capacity;
+    FileMsg request;
+    MPI_Request send_request;
+    MPI_Request payload_request; // receptia continutului direct in fisierul mapat
+    uint32_t payload_length;
+    VerifyJob verify; // verificarea continutului primit, pe firele din verify.c
+    double sent_time; // pentru durata cererii
+    int rma_phase;    // RMA_* pentru o citire din fereastra peer-ului
+    RmaFile rma_file;
+    uint8_t rma_present;          // octetul cu bitul segmentului, citit la RMA_PROBE
+    SegmentHashMsg rma_response;  // raspunsul construit din ce s-a citit (RMA sau pool-ul nodului)
+} PendingRequest;
+
+// Strategia de alegere a segmentelor si a peers de la care se descarca
+typedef struct
+{
+    const char *name;
+    // Ordinea in care se descarca segmentele unui fisier
+    void (*order_segments)(int rank, DownloadInfo *download, int *segments);
+    // Peer-ul intrebat pentru segmentul din slot sau -1; apelata cu download->lock tinut
+    int (*choose_peer)(int rank, DownloadInfo *download, PendingRequest *slot);
+} PiecePicker;
+
+// Fereastra de cereri a unui worker. Raspunsurile sosesc in buffere de
+// receptie pre-postate si sunt asociate cererii dupa fisier si segment.
+typedef struct
+{
+    int depth;
+    int in_flight;
+    int response_tag;
+    PendingRequest *slots;
+    SegmentHashMsg *responses;
+    // Primele depth: receptiile raspunsurilor; urmatoarele depth: verificarea
+    // continutului din fiecare slot; ultimele depth: citirea RMA a fiecarui
+    // slot. Cele nefolosite sunt MPI_REQUEST_NULL.
+    MPI_Request *recv_requests;
+    int *ready; // sloturi copiate din pool-ul unui vecin de nod, cu raspunsul gata
+    int ready_count;
+} RequestWindow;
+
+// Starea unui worker de download
+typedef struct
+{
+    int id;
+    int rank;
+    int worker_count;
+    TaskDeque *deques; // cozile tuturor workerilor
+    TaskFeed *feed;
+    PeerInfo *peer_info;
+    const PiecePicker *picker;
+    RequestWindow window;
+    long requests; // cereri de segmente trimise
+    long nacks;    // raspunsuri NACK primite
+    long haves_sent;
+    long refreshes; // cereri LIST_PEERS catre tracker
+    uint64_t payload_bytes; // continut primit si acceptat
+    long verify_failures;   // continut care nu corespunde hash-ului
+} DownloadWorker;
+
+// O cerere de segment primita de la alt peer
+typedef struct
+{
+    FileMsg request;
+    int source;
+    double enqueue_time;
+} UploadJob;
 
-// **Log file global**
-FILE *log_file = NULL;
+// Coada de cereri a unui worker de upload, impreuna cu metricile ei
+typedef struct
+{
+    UploadJob jobs[UPLOAD_QUEUE_SIZE];
+    int head;
+    int tail;
+    int count;
+    int stop;
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    long handled;
+    int max_depth;
+    double total_wait; // secunde petrecute de cereri in coada
+} UploadQueue;
+
+// Starea unui worker de upload
+typedef struct
+{
+    int id;
+    int rank;
+    PeerInfo *peer_info;
+    pthread_t thread;
+    UploadQueue queue;
+} UploadWorker;
 
-// Functia trackerului
-void tracker(int numtasks, int rank)
+// Contoarele de gossip ale unui peer. Firul de download asteapta raspunsul
+// la fiecare bitfield trimis inainte de FINALIZE_ALL, ca niciun mesaj de
+// gossip de dimensiune variabila sa nu ramana in zbor la oprire.
+typedef struct
 {
-    tracker_file_count = 0;
-    memset(tracker_files, 0, sizeof(tracker_files));
-    MPI_Status status;
+    pthread_mutex_t lock;
+    pthread_cond_t replied;
+    long hellos_sent;
+    long replies_received;
+    long bitfields_received;
+    long haves_received;
+} GossipState;
+
+// O receptie pre-postata a trackerului; bufferul se refoloseste pentru
+// fiecare mesaj primit pe eticheta ei
+typedef struct
+{
+    int tag;
+    int capacity;
+    char *buffer;
+} TrackerSlot;
+
+// Bucla de evenimente a trackerului dupa inregistrare: receptii pre-postate
+// pentru fiecare eticheta, asteptate cu MPI_Waitsome, si raspunsuri trimise
+// neblocant din buffere refolosite dupa terminarea trimiterii
+typedef struct
+{
+    int slot_count;
+    TrackerSlot *slots;
+    int request_count; // slot_count, plus cate o receptie per peer cu --early-start
+    MPI_Request *requests;
+    int *indices;
+    MPI_Status *statuses;
+    char **replies;
+    size_t *reply_capacity;
+    MPI_Request *reply_requests; // MPI_REQUEST_NULL pentru un buffer liber
+    int reply_count;
+    int bitfield_capacity; // bufferele SEGMENT_BITFIELD, marite cand apar fisiere mai mari
+    int peer_count;
+    int registered; // peers inregistrati; cu --early-start creste in bucla
+    FileMsg *deferred; // LIST_PEERS pentru fisiere fara manifest complet
+    int *deferred_from;
+    int deferred_count;
+    int deferred_capacity;
+    char **registrations; // blocul de inregistrare in curs al fiecarui peer, cu --early-start
+} TrackerLoop;
+
+// Inregistrarea unui peer la un shard, construita intr-un singur bloc
+typedef struct
+{
+    uint8_t *data;
+    size_t size;
+    size_t capacity;
+} Registration;
 
-    int clients_finalized = 0; // numar de clienti care au trimis FINALIZE_ALL
-    int expected_inits = numtasks - 1;
-    int received_inits = 0;
-    int pending_segments[MAX_PEERS] = {0}; // Segmente asteptate de la fiecare peer
+// Optiunile din linia de comanda
+typedef struct
+{
+    int request_window;   // numarul maxim de cereri de segmente in zbor per worker
+    int download_workers; // 0 = cate un worker pentru fiecare procesor
+    int upload_workers;
+    const char *piece_picker; // numele strategiei din piece_pickers
+    int gossip;               // schimb de bitfield-uri si HAVE-uri intre peers
+    int log_level;            // LOG_LEVEL_*; liniile mai detaliate nu se scriu
+    int metrics_report;       // trackerul aduna metricile tuturor rank-urilor
+    const char *data_dir;     // continutul fisierelor; NULL = doar hash-uri
+    int segment_size;         // octeti per segment, acelasi pe toate rank-urile
+    int verify_threads;       // fire care verifica continutul; 0 = in workerul de download
+    int resume;               // progresul descarcarilor se pastreaza in client<rank>_<nume>.state
+    int trackers;             // shard-urile de tracker, rank-urile 0..trackers-1
+    int early_start;          // peers pornesc fara sa astepte inregistrarea tuturor
+    int transport;            // TRANSPORT_*
+    int shared_memory;        // vecinii de nod isi citesc segmentele direct din memorie (node.h)
+    int ranks_per_node;       // grupuri simulate de rank-uri pe nod; 0 = nodul real
+} Options;
 
-    // ---------------- Faza 1: Initializarea fiecarui peer ---------------
-    while (received_inits < expected_inits)
-    {
-        // Asteptam un mesaj
-        MPI_Probe(MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
+// Variabile globale
+Options options = {DEFAULT_REQUEST_WINDOW, 0, DEFAULT_UPLOAD_WORKERS, DEFAULT_PIECE_PICKER, 1, DEFAULT_LOG_LEVEL, 0,
+                   NULL, DEFAULT_SEGMENT_SIZE, DEFAULT_VERIFY_THREADS, 0, 1, 0, TRANSPORT_TWO_SIDED, 0, 0};
 
-        int message_size;
-        MPI_Get_count(&status, MPI_CHAR, &message_size);
+Catalog tracker_catalog;
 
-        char *message = (char *)malloc(message_size + 1);
-        MPI_Recv(message, message_size, MPI_CHAR,
-                 status.MPI_SOURCE, status.MPI_TAG,
-                 MPI_COMM_WORLD, &status);
-        message[message_size] = '\0';
+// Shard-ul de tracker care raspunde de un fisier; file_id este deja un hash
+// al numelui, deci fisierele se impart uniform
+int tracker_for(uint32_t file_id)
+{
+    return (int)(file_id % (uint32_t)options.trackers);
+}
+
+PeerInfo global_peer_info;
 
-        int sender_rank = status.MPI_SOURCE;
-        fprintf(stdout, "Tracker: Received message of size %d from rank %d with tag %d\n",
-                message_size, sender_rank, status.MPI_TAG);
-        fflush(stdout);
+GossipState gossip_state = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, 0, 0, 0};
 
-        if (status.MPI_TAG == MSG_INIT)
+// Un buffer de raspuns liber de cel putin size octeti; intoarce pozitia lui
+int tracker_reply_buffer(TrackerLoop *loop, size_t size)
+{
+    int index = -1;
+    for (int i = 0; i < loop->reply_count && index == -1; i++)
+    {
+        if (loop->reply_requests[i] == MPI_REQUEST_NULL)
+            index = i;
+    }
+    if (index == -1 && loop->reply_count > 0)
+    {
+        int flag;
+        MPI_Testany(loop->reply_count, loop->reply_requests, &index, &flag, MPI_STATUS_IGNORE);
+        if (!flag || index == MPI_UNDEFINED)
+            index = -1;
+    }
+    if (index == -1)
+    {
+        // Toate raspunsurile sunt inca in zbor
+        index = loop->reply_count++;
+        loop->replies = (char **)realloc(loop->replies, loop->reply_count * sizeof(char *));
+        loop->reply_capacity = (size_t *)realloc(loop->reply_capacity, loop->reply_count * sizeof(size_t));
+        loop->reply_requests = (MPI_Request *)realloc(loop->reply_requests, loop->reply_count * sizeof(MPI_Request));
+        if (!loop->replies || !loop->reply_capacity || !loop->reply_requests)
         {
-            // Gestionarea mesajului INIT
+            LOG_ERROR("Tracker: Memory allocation failed\n");
+            MPI_Abort(MPI_COMM_WORLD, -1);
+        }
+        loop->replies[index] = NULL;
+        loop->reply_capacity[index] = 0;
+        loop->reply_requests[index] = MPI_REQUEST_NULL;
+        metrics_add(METRIC_TRACKER_ALLOCATIONS, 1);
+    }
 
-            char *ptr = strtok(message, " "); // "INIT"
-            ptr = strtok(NULL, " ");
-            int num_files = atoi(ptr);
-            int total_segments = 0;
+    if (loop->reply_capacity[index] < size)
+    {
+        loop->replies[index] = (char *)realloc(loop->replies[index], size);
+        if (!loop->replies[index])
+        {
+            LOG_ERROR("Tracker: Memory allocation failed\n");
+            MPI_Abort(MPI_COMM_WORLD, -1);
+        }
+        loop->reply_capacity[index] = size;
+        metrics_add(METRIC_TRACKER_ALLOCATIONS, 1);
+    }
+    return index;
+}
 
-            for (int i = 0; i < num_files; i++)
-            {
-                // Procesam fiecare fisier
-                ptr = strtok(NULL, " ");
-                char filename[MAX_FILENAME];
-                strcpy(filename, ptr);
+// Pastreaza o cerere LIST_PEERS pana cand fisierul poate fi descris
+void tracker_defer(TrackerLoop *loop, const FileMsg *request, int sender_rank)
+{
+    if (loop->deferred_count == loop->deferred_capacity)
+    {
+        loop->deferred_capacity = loop->deferred_capacity ? loop->deferred_capacity * 2 : 16;
+        loop->deferred = (FileMsg *)realloc(loop->deferred, loop->deferred_capacity * sizeof(FileMsg));
+        loop->deferred_from = (int *)realloc(loop->deferred_from, loop->deferred_capacity * sizeof(int));
+        if (!loop->deferred || !loop->deferred_from)
+        {
+            LOG_ERROR("Tracker: Memory allocation failed\n");
+            MPI_Abort(MPI_COMM_WORLD, -1);
+        }
+        metrics_add(METRIC_TRACKER_ALLOCATIONS, 1);
+    }
+    loop->deferred[loop->deferred_count] = *request;
+    loop->deferred_from[loop->deferred_count] = sender_rank;
+    loop->deferred_count++;
+    LOG_DEBUG("Tracker: Deferred peer list for rank %d until its manifest is complete.\n", sender_rank);
+}
 
-                ptr = strtok(NULL, " ");
-                int seg_count = atoi(ptr);
+// Trateaza o cerere primita de tracker dupa inregistrare. Intoarce 1 daca
+// expeditorul si-a terminat toate descarcarile. In faza de inregistrare
+// loop este NULL; atunci vin doar SEGMENT_BITFIELD-uri.
+int handle_tracker_request(TrackerLoop *loop, char *message, int message_size, int tag, int sender_rank)
+{
+    if (tag == MSG_FINALIZE_ALL)
+    {
+        if (proto_check(message, message_size, MSG_FINALIZE_ALL, sizeof(ControlMsg)) != 0)
+        {
+            LOG_WARN("Tracker: Malformed message from rank %d with tag %d\n",
+                    sender_rank, tag);
+            return 0;
+        }
 
-                total_segments += seg_count;
+        LOG_INFO("Tracker: Peer %d has finalized all downloads.\n", sender_rank);
+        return 1;
+    }
 
-                int file_index = -1;
-                for (int j = 0; j < tracker_file_count; j++)
-                {
-                    if (strcmp(tracker_files[j].filename, filename) == 0)
-                    {
-                        file_index = j;
-                        break;
-                    }
-                }
+    if (tag == MSG_SEGMENT_BITFIELD)
+    {
+        if (proto_check_bitfield(message, message_size, MSG_SEGMENT_BITFIELD) != 0)
+        {
+            LOG_WARN("Tracker: Malformed message from rank %d with tag %d\n",
+                    sender_rank, tag);
+            return 0;
+        }
 
-                if (file_index == -1)
-                {
-                    file_index = tracker_file_count++;
-                    strcpy(tracker_files[file_index].filename, filename);
-                    tracker_files[file_index].total_segments = 0;
-                    memset(tracker_files[file_index].clients_with_file, 0,
-                           sizeof(tracker_files[file_index].clients_with_file));
-                }
+        // Segmentele detinute de peer se adauga la cele stiute deja
+        BitfieldMsg *update = (BitfieldMsg *)message;
+        int file_index = catalog_find(&tracker_catalog, update->file_id);
+        if (file_index != -1 && (int)update->segment_count == tracker_catalog.files[file_index].total_segments)
+        {
+            TrackerFile *file = &tracker_catalog.files[file_index];
+            bitfield_merge(catalog_holder_bits(file, sender_rank), update->bits, file->bitfield_bytes);
+        }
+        return 0;
+    }
 
-                tracker_files[file_index].clients_with_file[sender_rank] = 1;
+    if (proto_check(message, message_size, tag, sizeof(FileMsg)) != 0)
+    {
+        LOG_WARN("Tracker: Malformed message from rank %d with tag %d\n",
+                sender_rank, tag);
+        return 0;
+    }
 
-                if (seg_count > tracker_files[file_index].total_segments)
-                {
-                    tracker_files[file_index].total_segments = seg_count;
-                }
-            }
-            if (total_segments == 0)
-            {
-                received_inits += 1;
-            }
-            pending_segments[sender_rank] = total_segments;
+    FileMsg *request = (FileMsg *)message;
+    int file_index = catalog_find(&tracker_catalog, request->file_id);
+    TrackerFile *file = file_index != -1 ? &tracker_catalog.files[file_index] : NULL;
+
+    if (tag == MSG_LIST_PEERS)
+    {
+        // Cu --early-start, cererea asteapta pana soseste manifestul complet
+        // sau pana se inregistreaza toti peers
+        if ((!file || !file->manifest_complete) && loop->registered < loop->peer_count)
+        {
+            tracker_defer(loop, request, sender_rank);
         }
-        else if (status.MPI_TAG == MSG_UPLOAD)
+        else if (!file || !file->manifest_complete)
         {
-            // Gestionarea mesajului UPLOAD
-            char filename[MAX_FILENAME];
-            char hash_value[HASH_SIZE + 1];
-            int segment_index;
-
-            sscanf(message, "UPLOAD %s %d %s", filename, &segment_index, hash_value);
-
-            int file_index = -1;
-            for (int i = 0; i < tracker_file_count; i++)
+            // Niciun seed nu a inregistrat fisierul: lista goala, cu NACK
+            LOG_WARN("Tracker: No complete manifest for file id %u requested by rank %d.\n",
+                    request->file_id, sender_rank);
+            size_t list_size = proto_peer_list_size(0, 0, 0);
+            int reply = tracker_reply_buffer(loop, list_size);
+            PeerListMsg *peer_list = (PeerListMsg *)loop->replies[reply];
+            memset(peer_list, 0, list_size);
+            proto_header_init(&peer_list->hdr, MSG_PEER_LIST, MSG_FLAG_NACK);
+            peer_list->file_id = request->file_id;
+
+            MPI_Isend(peer_list, list_size, MPI_BYTE, sender_rank,
+                      proto_reply_tag(request, MSG_PEER_LIST), MPI_COMM_WORLD, &loop->reply_requests[reply]);
+        }
+        else
+        {
+            // Fara manifest, clientul primeste lista completa si hash-urile
+            // segmentelor; altfel doar detinatorii schimbati dupa versiunea lui
+            uint32_t known = request->segment_index;
+            int hash_count = known == 0 ? file->total_segments : 0;
+            int changed = 0;
+            for (int h = 0; h < file->holder_count; h++)
             {
-                if (strcmp(tracker_files[i].filename, filename) == 0)
-                {
-                    file_index = i;
-                    break;
-                }
+                if (known == 0 || file->holder_versions[h] > known)
+                    changed++;
             }
 
-            if (file_index != -1 && segment_index < tracker_files[file_index].total_segments)
+            size_t row = file->bitfield_bytes;
+            size_t list_size = proto_peer_list_size(changed, hash_count, row);
+            int reply = tracker_reply_buffer(loop, list_size);
+            PeerListMsg *peer_list = (PeerListMsg *)loop->replies[reply];
+
+            proto_header_init(&peer_list->hdr, MSG_PEER_LIST, 0);
+            peer_list->file_id = file->file_id;
+            peer_list->file_size = file->file_size;
+            peer_list->total_segments = file->total_segments;
+            peer_list->hash_count = hash_count;
+            peer_list->peer_count = changed;
+            peer_list->bitfield_bytes = row;
+            peer_list->version = file->version;
+            memcpy(proto_peer_list_digests(peer_list), file->segment_hashes, (size_t)hash_count * HASH_SIZE);
+
+            uint8_t *bitfields = proto_peer_list_bitfields(peer_list);
+            int p = 0;
+            for (int h = 0; h < file->holder_count; h++)
             {
-                strcpy(tracker_files[file_index].segment_hashes[segment_index], hash_value);
-                fprintf(log_file, "Tracker: Stored hash for file %s, segment %d, hash %s.\n",
-                        filename, segment_index, hash_value);
-                fflush(log_file);
+                if (known != 0 && file->holder_versions[h] <= known)
+                    continue;
+                peer_list->peers[p] = file->holders[h];
+                memcpy(bitfields + p * row, file->holder_bits + h * row, row);
+                p++;
             }
 
-            pending_segments[sender_rank]--;
+            MPI_Isend(peer_list, list_size, MPI_BYTE, sender_rank,
+                      proto_reply_tag(request, MSG_PEER_LIST), MPI_COMM_WORLD, &loop->reply_requests[reply]);
+        }
+    }
+    else if (tag == MSG_RECEIVED_SEGMENT)
+    {
+        if (file)
+        {
+            LOG_DEBUG("Tracker: Peer %d received a segment of %s.\n",
+                    sender_rank, file->filename);
 
-            if (pending_segments[sender_rank] == 0)
+            // Marcheaza peer-ul ca avand partial fisierul
+            uint8_t *bits = catalog_holder_bits(file, sender_rank);
+            if ((int)request->segment_index < file->total_segments)
             {
-
-                received_inits += 1;
+                bitfield_set(bits, request->segment_index);
             }
         }
     }
-
-    for (int p = 1; p < numtasks; p++)
+    else if (tag == MSG_FINISH_DOWNLOAD)
     {
-        MPI_Send("ACK", 4, MPI_CHAR, p, MSG_ACK, MPI_COMM_WORLD);
-        fprintf(log_file, "Tracker: Sent ACK to Peer %d for INIT.\n", p);
-        fflush(log_file);
+        if (file)
+        {
+            LOG_INFO("Tracker: Peer %d has finished downloading %s.\n",
+                    sender_rank, file->filename);
+
+            // Marcheaza peer-ul ca avand fisierul full; versiunea creste si cand
+            // peer-ul era deja detinator partial
+            uint8_t *bits = catalog_holder_bits(file, sender_rank);
+            if (file->total_segments > 0)
+                bitfield_set_all(bits, file->total_segments);
+        }
     }
 
-    // ---------------- Faza 2: Asistarea fiecarui peer cu informatii despre fisiere si cu mesaj de finalizare ---------------
+    return 0;
+}
 
-    while (clients_finalized < numtasks - 1)
+// Cea mai mare dimensiune a unui SEGMENT_BITFIELD pentru catalogul curent
+int tracker_bitfield_capacity(void)
+{
+    int max_segments = 0;
+    for (int i = 0; i < tracker_catalog.file_count; i++)
     {
-        MPI_Probe(MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
+        if (tracker_catalog.files[i].total_segments > max_segments)
+            max_segments = tracker_catalog.files[i].total_segments;
+    }
+    return (int)proto_bitfield_size(max_segments);
+}
 
-        int message_size;
-        MPI_Get_count(&status, MPI_CHAR, &message_size);
+// Posteaza receptia slotului, marind intai bufferul unui SEGMENT_BITFIELD
+// daca intre timp au aparut fisiere mai mari
+void tracker_loop_post(TrackerLoop *loop, int index)
+{
+    TrackerSlot *slot = &loop->slots[index];
+    if (slot->tag == MSG_SEGMENT_BITFIELD && slot->capacity < loop->bitfield_capacity)
+    {
+        slot->buffer = (char *)realloc(slot->buffer, loop->bitfield_capacity);
+        if (!slot->buffer)
+        {
+            LOG_ERROR("Tracker: Memory allocation failed\n");
+            MPI_Abort(MPI_COMM_WORLD, -1);
+        }
+        slot->capacity = loop->bitfield_capacity;
+        metrics_add(METRIC_TRACKER_ALLOCATIONS, 1);
+    }
+    MPI_Irecv(slot->buffer, slot->capacity, MPI_BYTE, MPI_ANY_SOURCE, slot->tag,
+              MPI_COMM_WORLD, &loop->requests[index]);
+}
 
-        char *message = (char *)malloc((message_size + 1) * sizeof(char));
-        if (!message)
+// Posteaza receptiile buclei: cate TRACKER_RECV_SLOTS pentru fiecare
+// eticheta de dupa inregistrare. SEGMENT_BITFIELD-urile au cel mult
+// bitfield-ul celui mai mare fisier din catalog. Cu --early-start, peers se
+// inregistreaza tot prin bucla, pe eticheta MSG_INIT.
+void tracker_loop_init(TrackerLoop *loop, int peer_count)
+{
+    memset(loop, 0, sizeof(*loop));
+    loop->bitfield_capacity = tracker_bitfield_capacity();
+    loop->peer_count = peer_count;
+    loop->registered = options.early_start ? 0 : peer_count;
+
+    const struct
+    {
+        int tag;
+        int capacity;
+    } kinds[] = {
+        {MSG_LIST_PEERS, sizeof(FileMsg)},
+        {MSG_RECEIVED_SEGMENT, sizeof(FileMsg)},
+        {MSG_FINISH_DOWNLOAD, sizeof(FileMsg)},
+        {MSG_FINALIZE_ALL, sizeof(ControlMsg)},
+        {MSG_SEGMENT_BITFIELD, loop->bitfield_capacity},
+        {MSG_INIT, sizeof(RegisterMsg)}, // ultimul: doar cu --early-start
+    };
+    int kind_count = sizeof(kinds) / sizeof(kinds[0]) - (options.early_start ? 0 : 1);
+
+    // Dupa sloturi, receptiile blocurilor de inregistrare, cate una pentru
+    // fiecare peer care si-a trimis anuntul
+    loop->slot_count = kind_count * TRACKER_RECV_SLOTS;
+    loop->request_count = loop->slot_count + (options.early_start ? peer_count : 0);
+    loop->slots = (TrackerSlot *)calloc(loop->slot_count, sizeof(TrackerSlot));
+    loop->requests = (MPI_Request *)malloc(loop->request_count * sizeof(MPI_Request));
+    loop->indices = (int *)malloc(loop->request_count * sizeof(int));
+    loop->statuses = (MPI_Status *)malloc(loop->request_count * sizeof(MPI_Status));
+    loop->registrations = (char **)calloc(peer_count, sizeof(char *));
+    if (!loop->slots || !loop->requests || !loop->indices || !loop->statuses || !loop->registrations)
+    {
+        LOG_ERROR("Tracker: Memory allocation failed\n");
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+    for (int i = loop->slot_count; i < loop->request_count; i++)
+    {
+        loop->requests[i] = MPI_REQUEST_NULL;
+    }
+
+    for (int i = 0; i < loop->slot_count; i++)
+    {
+        TrackerSlot *slot = &loop->slots[i];
+        slot->tag = kinds[i / TRACKER_RECV_SLOTS].tag;
+        slot->capacity = kinds[i / TRACKER_RECV_SLOTS].capacity;
+        slot->buffer = (char *)malloc(slot->capacity);
+        if (!slot->buffer)
         {
-            fprintf(log_file, "Tracker: Memory allocation failed\n");
-            fflush(log_file);
+            LOG_ERROR("Tracker: Memory allocation failed\n");
             MPI_Abort(MPI_COMM_WORLD, -1);
         }
+        tracker_loop_post(loop, i);
+    }
+}
+
+// Trateaza mesajul sosit in slot; receptiile pre-postate nu trec prin
+// interceptarea din metrics.c, deci se numara aici
+int tracker_loop_dispatch(TrackerLoop *loop, int index, MPI_Status *status)
+{
+    TrackerSlot *slot = &loop->slots[index];
+    int message_size;
+    MPI_Get_count(status, MPI_BYTE, &message_size);
+    metrics_add(METRIC_BYTES_RECEIVED, message_size);
+    metrics_add(METRIC_MESSAGES_RECEIVED, 1);
+    LOG_DEBUG("Tracker: Received message of size %d from rank %d with tag %d\n",
+            message_size, status->MPI_SOURCE, slot->tag);
+
+    double received = MPI_Wtime();
+    int finalized = handle_tracker_request(loop, slot->buffer, message_size, slot->tag, status->MPI_SOURCE);
+    metrics_record_tag(slot->tag, MPI_Wtime() - received);
+    return finalized;
+}
+
+// Anuleaza receptiile ramase si asteapta raspunsurile in zbor. Un mesaj
+// potrivit chiar inainte de anulare se trateaza ca oricare altul.
+void tracker_loop_destroy(TrackerLoop *loop)
+{
+    for (int i = 0; i < loop->slot_count; i++)
+    {
+        MPI_Status status;
+        int cancelled;
+        MPI_Cancel(&loop->requests[i]);
+        MPI_Wait(&loop->requests[i], &status);
+        MPI_Test_cancelled(&status, &cancelled);
+        if (!cancelled)
+        {
+            tracker_loop_dispatch(loop, i, &status);
+        }
+    }
+    MPI_Waitall(loop->reply_count, loop->reply_requests, MPI_STATUSES_IGNORE);
 
-        MPI_Recv(message, message_size, MPI_CHAR,
-                 status.MPI_SOURCE, status.MPI_TAG,
-                 MPI_COMM_WORLD, &status);
-        message[message_size] = '\0';
+    for (int i = 0; i < loop->slot_count; i++)
+    {
+        free(loop->slots[i].buffer);
+    }
+    for (int i = 0; i < loop->reply_count; i++)
+    {
+        free(loop->replies[i]);
+    }
+    free(loop->slots);
+    free(loop->requests);
+    free(loop->indices);
+    free(loop->statuses);
+    free(loop->replies);
+    free(loop->reply_capacity);
+    free(loop->reply_requests);
+    free(loop->deferred);
+    free(loop->deferred_from);
+    free(loop->registrations);
+}
 
-        int sender_rank = status.MPI_SOURCE;
-        fprintf(log_file, "Tracker: Received message of size %d from rank %d with tag %d\n",
-                message_size, sender_rank, status.MPI_TAG);
-        fflush(log_file);
+// Colectiv: inregistrarile tuturor rank-urilor pentru fiecare shard ajung la
+// acesta printr-un MPI_Igatherv; shard-urile contribuie cu blocuri goale.
+// Pe rank-ul unui shard, *gathered primeste blocurile peers (in ordinea
+// rank-urilor) si *counts / *displs pozitia fiecaruia; altfel raman NULL.
+void gather_registrations(int rank, int numtasks, Registration *registrations,
+                          uint8_t **gathered, int **counts, int **displs)
+{
+    int shards = options.trackers;
+    int *sizes = (int *)malloc(shards * sizeof(int));
+    MPI_Request *requests = (MPI_Request *)malloc(shards * sizeof(MPI_Request));
+    *gathered = NULL;
+    *counts = NULL;
+    *displs = NULL;
+    if (rank < shards)
+    {
+        *counts = (int *)calloc(numtasks, sizeof(int));
+        *displs = (int *)calloc(numtasks, sizeof(int));
+    }
+    if (!sizes || !requests || (rank < shards && (!*counts || !*displs)))
+    {
+        LOG_ERROR("Rank %d: Memory allocation failed\n", rank);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
 
-        if (status.MPI_TAG == MSG_LIST_PEERS)
+    // Intai dimensiunile, ca fiecare shard sa stie unde ajunge fiecare bloc
+    for (int shard = 0; shard < shards; shard++)
+    {
+        if (registrations[shard].size > INT_MAX)
         {
-            char requested_filename[MAX_FILENAME];
-            sscanf(message, "LIST_PEERS %s", requested_filename);
+            LOG_ERROR("Rank %d: Registration for tracker %d is too large\n", rank, shard);
+            MPI_Abort(MPI_COMM_WORLD, -1);
+        }
+        sizes[shard] = (int)registrations[shard].size;
+        MPI_Igather(&sizes[shard], 1, MPI_INT, *counts, 1, MPI_INT, shard, MPI_COMM_WORLD, &requests[shard]);
+    }
+    MPI_Waitall(shards, requests, MPI_STATUSES_IGNORE);
 
-            int file_index = -1;
-            for (int i = 0; i < tracker_file_count; i++)
+    if (rank < shards)
+    {
+        size_t total = 0;
+        for (int p = 0; p < numtasks; p++)
+        {
+            if (total + (*counts)[p] > INT_MAX)
             {
-                if (strcmp(tracker_files[i].filename, requested_filename) == 0)
-                {
-                    file_index = i;
-                    break;
-                }
+                LOG_ERROR("Tracker: Registrations are too large for one gather\n");
+                MPI_Abort(MPI_COMM_WORLD, -1);
             }
+            (*displs)[p] = (int)total;
+            total += (*counts)[p];
+            if ((*counts)[p] > 0)
+                metrics_add(METRIC_MESSAGES_RECEIVED, 1);
+        }
+        *gathered = (uint8_t *)malloc(total ? total : 1);
+        if (!*gathered)
+        {
+            LOG_ERROR("Tracker: Memory allocation failed\n");
+            MPI_Abort(MPI_COMM_WORLD, -1);
+        }
+        metrics_add(METRIC_BYTES_RECEIVED, total);
+    }
 
-            if (file_index != -1)
-            {
-                // Trimite lista de peers
-                char peer_list[1024] = "";
-                sprintf(peer_list, "%d", tracker_files[file_index].total_segments);
-                for (int j = 0; j < MAX_PEERS; j++)
-                {
-                    if (tracker_files[file_index].clients_with_file[j])
-                    {
-                        char rank_str[16];
-                        sprintf(rank_str, " %d", j);
-                        strcat(peer_list, rank_str);
-                    }
-                }
-                MPI_Send(peer_list, strlen(peer_list) + 1, MPI_CHAR, sender_rank, MSG_PEER_LIST, MPI_COMM_WORLD);
+    // Toate shard-urile aduna in paralel; ordinea apelurilor este aceeasi pe
+    // toate rank-urile
+    for (int shard = 0; shard < shards; shard++)
+    {
+        MPI_Igatherv(registrations[shard].data, sizes[shard], MPI_BYTE, *gathered, *counts, *displs, MPI_BYTE,
+                     shard, MPI_COMM_WORLD, &requests[shard]);
+        if (sizes[shard] > 0)
+        {
+            metrics_add(METRIC_BYTES_SENT, sizes[shard]);
+            metrics_add(METRIC_MESSAGES_SENT, 1);
+        }
+    }
+    MPI_Waitall(shards, requests, MPI_STATUSES_IGNORE);
 
-                // Trimite hash-urile segmentelor separat
-                for (int s = 0; s < tracker_files[file_index].total_segments; s++)
-                {
-                    char hash_message[256];
-                    sprintf(hash_message, "HASH %d %s", s, tracker_files[file_index].segment_hashes[s]);
-                    MPI_Send(hash_message, strlen(hash_message) + 1, MPI_CHAR, sender_rank, MSG_PEER_LIST, MPI_COMM_WORLD);
-                }
-            }
+    free(sizes);
+    free(requests);
+}
+
+// Fisierele dintr-un INIT; un seed detine toate segmentele
+void register_files(InitMsg *init, int sender_rank)
+{
+    for (uint32_t i = 0; i < init->file_count; i++)
+    {
+        // Procesam fiecare fisier
+        FileEntry *entry = &init->files[i];
+        int seg_count = entry->total_segments;
+
+        int file_index = catalog_add_file(&tracker_catalog, entry->file_id, entry->filename);
+        if (file_index == -1)
+        {
+            LOG_ERROR("Tracker: File id collision for %s\n", entry->filename);
+            MPI_Abort(MPI_COMM_WORLD, -1);
+        }
+
+        TrackerFile *file = &tracker_catalog.files[file_index];
+        catalog_set_segments(file, seg_count);
+        if (entry->file_size > 0)
+        {
+            file->file_size = entry->file_size;
         }
-        else if (status.MPI_TAG == MSG_RECEIVED_SEGMENT)
+        uint8_t *bits = catalog_holder_bits(file, sender_rank);
+        if (seg_count > 0 && !(entry->flags & FILE_ENTRY_PARTIAL))
         {
-            char filename[MAX_FILENAME];
-            sscanf(message, "RECEIVED_SEGMENT %s", filename);
+            bitfield_set_all(bits, seg_count); // seed-ul detine tot fisierul
+        }
+    }
+}
+
+// Toate hash-urile unui fisier, dintr-un UPLOAD
+void store_uploaded_hashes(UploadMsg *upload, int sender_rank)
+{
+    int file_index = catalog_find(&tracker_catalog, upload->file_id);
+    if (file_index == -1)
+        return;
+
+    TrackerFile *file = &tracker_catalog.files[file_index];
+    int hash_count = upload->hash_count;
+    if (hash_count > file->total_segments)
+    {
+        hash_count = file->total_segments;
+    }
+
+    memcpy(file->segment_hashes, upload->digests, (size_t)hash_count * HASH_SIZE);
+    if (hash_count == file->total_segments)
+    {
+        file->manifest_complete = 1;
+    }
+    LOG_INFO("Tracker: Stored %d hashes for file %s from rank %d.\n",
+            hash_count, file->filename, sender_rank);
+}
+
+// Prelucreaza blocul de inregistrare al unui peer, mesaj cu mesaj
+void register_peer(uint8_t *block, int block_size, int sender_rank)
+{
+    size_t offset = 0;
+    int tag;
+    int message_size;
+    char *message;
 
-            fprintf(log_file, "Tracker: Peer %d received a segment of %s.\n", sender_rank, filename);
-            fflush(log_file);
+    while ((message = (char *)proto_next_record(block, block_size, &offset, &tag, &message_size)) != NULL)
+    {
+        double received = MPI_Wtime();
+        LOG_DEBUG("Tracker: Registration message of size %d from rank %d with tag %d\n",
+                message_size, sender_rank, tag);
 
-            for (int i = 0; i < tracker_file_count; i++)
+        if (tag == MSG_INIT)
+        {
+            if (proto_check_init(message, message_size) != 0)
             {
-                if (strcmp(tracker_files[i].filename, filename) == 0)
-                {
-                    tracker_files[i].clients_with_file[sender_rank] = 1; // Marcheaza peer-ul ca avand partial fisierul
-                    break;
-                }
+                LOG_ERROR("Tracker: Malformed INIT from rank %d\n", sender_rank);
+                MPI_Abort(MPI_COMM_WORLD, -1);
             }
+            register_files((InitMsg *)message, sender_rank);
         }
-        else if (status.MPI_TAG == MSG_FINISH_DOWNLOAD)
+        else if (tag == MSG_SEGMENT_BITFIELD)
         {
-            char filename[MAX_FILENAME];
-            sscanf(message, "FINISH_DOWNLOAD %s", filename);
-            fprintf(log_file, "Tracker: Peer %d has finished downloading %s.\n", sender_rank, filename);
-            fflush(log_file);
-
-            for (int i = 0; i < tracker_file_count; i++)
+            // Segmentele unei descarcari reluate, dupa INIT-ul aceluiasi peer
+            handle_tracker_request(NULL, message, message_size, tag, sender_rank);
+        }
+        else if (tag == MSG_UPLOAD)
+        {
+            if (proto_check_upload(message, message_size) != 0)
             {
-                if (strcmp(tracker_files[i].filename, filename) == 0)
-                {
-                    tracker_files[i].clients_with_file[sender_rank] = 1; // Marcheaza peer-ul ca avand fisierul full
-                    break;
-                }
+                LOG_ERROR("Tracker: Malformed UPLOAD from rank %d\n", sender_rank);
+                MPI_Abort(MPI_COMM_WORLD, -1);
             }
+            store_uploaded_hashes((UploadMsg *)message, sender_rank);
+        }
+        else
+        {
+            LOG_ERROR("Tracker: Unexpected tag %d in registration from rank %d\n", tag, sender_rank);
+            MPI_Abort(MPI_COMM_WORLD, -1);
+        }
+        metrics_record_tag(tag, MPI_Wtime() - received);
+    }
+
+    if (offset != (size_t)block_size)
+    {
+        LOG_ERROR("Tracker: Truncated registration from rank %d\n", sender_rank);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+}
+
+// Inregistrarile tuturor peers, adunate cu colectivele de pornire.
+// Shard-ul nu are nimic de inregistrat, dar participa la colectivele
+// celorlalte shard-uri.
+void tracker_gather_registrations(int rank, int numtasks)
+{
+    Registration *empty = (Registration *)calloc(options.trackers, sizeof(Registration));
+    uint8_t *gathered;
+    int *counts;
+    int *displs;
+    if (!empty)
+    {
+        LOG_ERROR("Tracker: Memory allocation failed\n");
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+    gather_registrations(rank, numtasks, empty, &gathered, &counts, &displs);
+    free(empty);
+
+    for (int p = options.trackers; p < numtasks; p++)
+    {
+        if (counts[p] > 0)
+        {
+            register_peer(gathered + displs[p], counts[p], p);
+        }
+    }
+    free(gathered);
+    free(counts);
+    free(displs);
+}
+
+// Mareste receptiile SEGMENT_BITFIELD cand catalogul are fisiere mai mari.
+// Receptiile in curs se anuleaza si se posteaza din nou; un mesaj deja
+// potrivit se trateaza inainte.
+void tracker_loop_fit(TrackerLoop *loop)
+{
+    int capacity = tracker_bitfield_capacity();
+    if (capacity <= loop->bitfield_capacity)
+        return;
+
+    loop->bitfield_capacity = capacity;
+    for (int i = 0; i < loop->slot_count; i++)
+    {
+        // Un slot terminat in acelasi MPI_Waitsome se mareste cand se reposteaza
+        if (loop->slots[i].tag != MSG_SEGMENT_BITFIELD || loop->requests[i] == MPI_REQUEST_NULL)
+            continue;
+
+        MPI_Status status;
+        int cancelled;
+        MPI_Cancel(&loop->requests[i]);
+        MPI_Wait(&loop->requests[i], &status);
+        MPI_Test_cancelled(&status, &cancelled);
+        if (!cancelled)
+        {
+            tracker_loop_dispatch(loop, i, &status);
+        }
+        tracker_loop_post(loop, i);
+    }
+}
+
+// Termina inregistrarea unui peer cu --early-start. Cererile LIST_PEERS
+// amanate primesc raspuns cand fisierul lor are manifestul complet sau cand
+// s-au inregistrat toti peers.
+void tracker_loop_registered(TrackerLoop *loop, int sender_rank)
+{
+    loop->registered++;
+    LOG_INFO("Tracker: Peer %d registered (%d of %d).\n", sender_rank, loop->registered, loop->peer_count);
+
+    tracker_loop_fit(loop);
+
+    int kept = 0;
+    for (int i = 0; i < loop->deferred_count; i++)
+    {
+        FileMsg *request = &loop->deferred[i];
+        int file_index = catalog_find(&tracker_catalog, request->file_id);
+        int ready = file_index != -1 && tracker_catalog.files[file_index].manifest_complete;
+        if (ready || loop->registered == loop->peer_count)
+        {
+            handle_tracker_request(loop, (char *)request, sizeof(*request), MSG_LIST_PEERS, loop->deferred_from[i]);
+        }
+        else
+        {
+            loop->deferred[kept] = *request;
+            loop->deferred_from[kept] = loop->deferred_from[i];
+            kept++;
+        }
+    }
+    loop->deferred_count = kept;
+}
+
+// Anuntul de inregistrare al unui peer cu --early-start, sosit in slot. Blocul
+// lui de pe MSG_UPLOAD se primeste neblocant, in aceeasi bucla, ca un peer lent
+// sa nu opreasca celelalte cereri.
+void tracker_loop_announce(TrackerLoop *loop, int index, MPI_Status *status)
+{
+    TrackerSlot *slot = &loop->slots[index];
+    int sender_rank = status->MPI_SOURCE;
+    int message_size;
+    MPI_Get_count(status, MPI_BYTE, &message_size);
+    metrics_add(METRIC_BYTES_RECEIVED, message_size);
+    metrics_add(METRIC_MESSAGES_RECEIVED, 1);
+
+    double received = MPI_Wtime();
+    if (proto_check(slot->buffer, message_size, MSG_INIT, sizeof(RegisterMsg)) != 0 ||
+        sender_rank < options.trackers || loop->registrations[sender_rank - options.trackers])
+    {
+        LOG_ERROR("Tracker: Malformed INIT from rank %d\n", sender_rank);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+
+    RegisterMsg *announce = (RegisterMsg *)slot->buffer;
+    int block_size = (int)announce->size;
+    if (block_size > 0)
+    {
+        int peer = sender_rank - options.trackers;
+        loop->registrations[peer] = (char *)malloc(block_size);
+        if (!loop->registrations[peer])
+        {
+            LOG_ERROR("Tracker: Memory allocation failed\n");
+            MPI_Abort(MPI_COMM_WORLD, -1);
+        }
+        metrics_add(METRIC_TRACKER_ALLOCATIONS, 1);
+        MPI_Irecv(loop->registrations[peer], block_size, MPI_BYTE, sender_rank, MSG_UPLOAD,
+                  MPI_COMM_WORLD, &loop->requests[loop->slot_count + peer]);
+    }
+    else
+    {
+        tracker_loop_registered(loop, sender_rank);
+    }
+    metrics_record_tag(MSG_INIT, MPI_Wtime() - received);
+}
+
+// A sosit blocul de inregistrare cerut de tracker_loop_announce
+void tracker_loop_register(TrackerLoop *loop, int index, MPI_Status *status)
+{
+    int peer = index - loop->slot_count;
+    int sender_rank = peer + options.trackers;
+    int block_size;
+    MPI_Get_count(status, MPI_BYTE, &block_size);
+    metrics_add(METRIC_BYTES_RECEIVED, block_size);
+    metrics_add(METRIC_MESSAGES_RECEIVED, 1);
+
+    register_peer((uint8_t *)loop->registrations[peer], block_size, sender_rank);
+    free(loop->registrations[peer]);
+    loop->registrations[peer] = NULL;
+    tracker_loop_registered(loop, sender_rank);
+}
+
+// Functia trackerului
+void tracker(int numtasks, int rank)
+{
+    catalog_init(&tracker_catalog);
+    // Fereastra este colectiva; trackerul nu expune nimic
+    if (options.transport == TRANSPORT_RMA && rma_init(0) != 0)
+    {
+        LOG_ERROR("Tracker: Cannot create the RMA window\n");
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+
+    int clients_finalized = 0; // numar de clienti care au trimis FINALIZE_ALL
+    int peer_count = numtasks - options.trackers;
+    double bootstrap_start = MPI_Wtime();
+
+    // ---------------- Faza 1: Initializarea fiecarui peer ---------------
+    if (!options.early_start)
+    {
+        tracker_gather_registrations(rank, numtasks);
+    }
+
+    // Receptiile fazei 2 se posteaza inainte de bariera, ca primele cereri
+    // sa gaseasca deja un buffer
+    TrackerLoop loop;
+    tracker_loop_init(&loop, peer_count);
+
+    if (!options.early_start)
+    {
+        double barrier_start = MPI_Wtime();
+        metrics_add(METRIC_BOOTSTRAP_NS, (uint64_t)((barrier_start - bootstrap_start) * 1e9));
+
+        // Peers asteapta aceeasi bariera, deci nu cer liste de peers inainte ca
+        // toate shard-urile sa fi prelucrat inregistrarile
+        MPI_Request barrier;
+        MPI_Ibarrier(MPI_COMM_WORLD, &barrier);
+        MPI_Wait(&barrier, MPI_STATUS_IGNORE);
+        metrics_add(METRIC_BARRIER_NS, (uint64_t)((MPI_Wtime() - barrier_start) * 1e9));
+    }
+
+    // ---------------- Faza 2: Asistarea fiecarui peer cu informatii despre fisiere si cu mesaj de finalizare ---------------
+
+    // Cu --early-start, un peer poate termina inainte ca altii sa se inregistreze
+    while (clients_finalized < peer_count || loop.registered < peer_count)
+    {
+        int completed;
+        MPI_Waitsome(loop.request_count, loop.requests, &completed, loop.indices, loop.statuses);
+
+        for (int k = 0; k < completed; k++)
+        {
+            int index = loop.indices[k];
+            if (index >= loop.slot_count)
+            {
+                // Receptia blocului nu se reposteaza: fiecare peer se inregistreaza o data
+                tracker_loop_register(&loop, index, &loop.statuses[k]);
+                continue;
+            }
+            if (loop.slots[index].tag == MSG_INIT)
+                tracker_loop_announce(&loop, index, &loop.statuses[k]);
+            else
+                clients_finalized += tracker_loop_dispatch(&loop, index, &loop.statuses[k]);
+
+            // Bufferul este liber din nou; se reposteaza pentru urmatorul mesaj
+            tracker_loop_post(&loop, index);
+        }
+    }
+    tracker_loop_destroy(&loop);
+
+    // Fiecare peer trimite FINALIZE_ALL tuturor shard-urilor, deci fiecare
+    // stie singur ca swarm-ul a terminat; firele de upload le opreste primul
+    if (rank == TRACKER_RANK)
+    {
+        FileMsg terminate;
+        proto_header_init(&terminate.hdr, MSG_DOWNLOAD_REQUEST, MSG_FLAG_TERMINATE);
+        terminate.file_id = 0;
+        terminate.segment_index = 0;
+        terminate.reply_tag = 0;
+        terminate.payload_tag = 0;
+        for (int i = options.trackers; i < numtasks; i++)
+        {
+            MPI_Send(&terminate, sizeof(terminate), MPI_BYTE, i,
+                     MSG_DOWNLOAD_REQUEST, MPI_COMM_WORLD); // trimis catre thread ul de upload
+            LOG_INFO("Tracker: Sent TERMINATE to Peer %d.\n", i);
+        }
+    }
+
+    if (options.transport == TRANSPORT_RMA)
+    {
+        rma_finalize();
+    }
+    catalog_destroy(&tracker_catalog);
+}
+
+// Fisierul din --data-dir cu continutul: cel detinut de la inceput (source)
+// sau cel in care rank-ul il descarca
+void content_path(char *path, size_t size, int rank, const char *filename, int source)
+{
+    if (source)
+        snprintf(path, size, "%s/%s", options.data_dir, filename);
+    else
+        snprintf(path, size, "%s/client%d_%s.data", options.data_dir, rank, filename);
+}
+
+// Mapeaza continutul unui fisier detinut din --data-dir. Numarul de segmente
+// din fisierul de intrare trebuie sa corespunda dimensiunii lui.
+void map_owned_payload(int rank, FileDetails *file)
+{
+    char path[PATH_MAX];
+    PayloadMap map;
+    content_path(path, sizeof(path), rank, file->filename, 1);
+    if (payload_map_source(&map, path) != 0)
+    {
+        LOG_ERROR("Peer %d: Cannot map content file %s\n", rank, path);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+
+    if (payload_segment_count(map.size, options.segment_size) != file->total_segments)
+    {
+        LOG_ERROR("Peer %d: %s has %llu bytes, not %d segments of %d bytes\n",
+                  rank, path, (unsigned long long)map.size, file->total_segments, options.segment_size);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+
+    file->payload = map.data;
+    file->payload_size = map.size;
+}
+
+// Intrarea nu respecta formatul: fara ea peer-ul nu poate participa
+void abort_malformed_input(int rank, const char *input_filename, const char *detail)
+{
+    LOG_ERROR("Peer %d: Malformed input file %s: %s\n", rank, input_filename, detail);
+    MPI_Abort(MPI_COMM_WORLD, -1);
+}
+
+// Functia de citire a fisierului de input
+void read_input_file(int rank, PeerInfo *peer_info)
+{
+    char input_filename[20], output_filename[20];
+    sprintf(input_filename, "in%d.txt", rank);
+    sprintf(output_filename, "o%d.txt", rank);
+
+    FILE *input_file = fopen(input_filename, "r");
+    if (!input_file)
+    {
+        LOG_ERROR("Peer %d: Error opening input file %s\n", rank, input_filename);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+
+    FILE *output_file = fopen(output_filename, "a");
+    if (!output_file)
+    {
+        LOG_ERROR("Peer %d: Error opening output file %s\n", rank, output_filename);
+        fclose(input_file);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+
+    arena_init(&peer_info->arena);
+    store_init(&peer_info->owned_files, &peer_info->arena);
+    if (options.shared_memory)
+    {
+        peer_info->owned_files.metadata_alloc = node_alloc; // vecinii de nod le citesc direct
+    }
+
+    int owned_file_count = 0;
+    if (fscanf(input_file, "%d", &owned_file_count) != 1)
+        abort_malformed_input(rank, input_filename, "missing owned file count");
+    fprintf(output_file, "%d\n", owned_file_count);
+
+    for (int i = 0; i < owned_file_count; i++)
+    {
+        char filename[MAX_FILENAME];
+        int total_segments = 0;
+        if (fscanf(input_file, "%49s %d", filename, &total_segments) != 2)
+            abort_malformed_input(rank, input_filename, "missing file name or segment count");
+        fprintf(output_file, "%s %d\n", filename, total_segments);
+        if (total_segments < 0)
+        {
+            total_segments = 0;
+        }
+
+        FileDetails *file = store_add_file(&peer_info->owned_files, filename, total_segments);
+        if (options.data_dir)
+        {
+            map_owned_payload(rank, file);
+        }
+        for (int j = 0; j < total_segments; j++)
+        {
+            char hash_value[256];
+            uint8_t digest[HASH_SIZE];
+            // Liniile din client<rank>_<fisier> au latime fixa: exact HASH_SIZE caractere
+            if (fscanf(input_file, "%255s", hash_value) != 1 || strlen(hash_value) != HASH_SIZE)
+                abort_malformed_input(rank, input_filename, "segment hash is not 32 characters");
+            fprintf(output_file, "%s\n", hash_value);
+
+            proto_digest_from_str(digest, hash_value);
+            store_put_segment(file, j, digest);
+        }
+        fprintf(output_file, "\n");
+    }
+    peer_info->source_count = store_file_count(&peer_info->owned_files);
+
+    peer_info->requested_file_count = 0;
+    if (fscanf(input_file, "%d", &peer_info->requested_file_count) != 1)
+        abort_malformed_input(rank, input_filename, "missing requested file count");
+    fprintf(output_file, "%d\n", peer_info->requested_file_count);
+    if (peer_info->requested_file_count < 0)
+    {
+        peer_info->requested_file_count = 0;
+    }
+    peer_info->requested_files = arena_alloc(&peer_info->arena,
+                                             (size_t)peer_info->requested_file_count * MAX_FILENAME);
+
+    for (int i = 0; i < peer_info->requested_file_count; i++)
+    {
+        if (fscanf(input_file, "%49s", peer_info->requested_files[i]) != 1)
+            abort_malformed_input(rank, input_filename, "missing requested file name");
+        fprintf(output_file, "%s\n", peer_info->requested_files[i]);
+    }
+
+    fclose(input_file);
+    fclose(output_file);
+}
+
+// Un fisier detinut doar partial provine dintr-o descarcare reluata
+int file_is_partial(FileDetails *file)
+{
+    return atomic_load_explicit(&file->segment_count, memory_order_relaxed) < file->total_segments;
+}
+
+// Verifica un segment marcat in starea unei descarcari intrerupte: continutul
+// trebuie sa aiba hash-ul din manifest, iar fara continut linia lui din
+// fisierul de iesire trebuie sa fie chiar hash-ul
+int verify_resumed_segment(const ResumeState *state, const uint8_t *payload, int output_fd, int segment)
+{
+    const uint8_t *expected = state->digests + (size_t)segment * HASH_SIZE;
+    if (payload)
+    {
+        uint8_t digest[HASH_SIZE];
+        uint32_t segment_size = state->header->segment_size;
+        verify_digest(payload + payload_segment_offset(segment, segment_size),
+                      payload_segment_length(state->header->file_size, segment, segment_size), digest);
+        return memcmp(digest, expected, HASH_SIZE) == 0;
+    }
+
+    char line[HASH_LINE_SIZE];
+    return output_fd >= 0 &&
+           pread(output_fd, line, sizeof(line), (off_t)segment * HASH_LINE_SIZE) == sizeof(line) &&
+           memcmp(line, expected, HASH_SIZE) == 0 && line[HASH_SIZE] == '\n';
+}
+
+// Reia descarcarile intrerupte: segmentele marcate in client<rank>_<nume>.state
+// care sunt inca intacte pe disc intra in store si se anunta tracker-ului
+void resume_downloads(int rank, PeerInfo *peer_info)
+{
+    uint32_t segment_size = options.data_dir ? options.segment_size : 0;
+
+    for (int i = 0; i < peer_info->requested_file_count; i++)
+    {
+        const char *filename = peer_info->requested_files[i];
+        char path[PATH_MAX];
+        ResumeState state;
+        snprintf(path, sizeof(path), "client%d_%s.state", rank, filename);
+        if (resume_load(&state, path) != 0)
+            continue;
+
+        ResumeHeader *header = state.header;
+        if (header->file_id != proto_file_id(filename) || header->segment_size != segment_size)
+        {
+            LOG_WARN("Peer %d: Ignoring %s, written with other options.\n", rank, path);
+            resume_close(&state);
+            continue;
+        }
+        if (store_find(&peer_info->owned_files, header->file_id))
+        {
+            resume_close(&state); // fisierul este deja detinut complet
+            continue;
+        }
+
+        PayloadMap map = {NULL, 0};
+        int output_fd = -1;
+        if (options.data_dir)
+        {
+            char data_path[PATH_MAX];
+            content_path(data_path, sizeof(data_path), rank, filename, 0);
+            if (payload_map_existing(&map, data_path, header->file_size) != 0)
+            {
+                LOG_ERROR("Peer %d: Cannot map content file %s\n", rank, data_path);
+                MPI_Abort(MPI_COMM_WORLD, -1);
+            }
+        }
+        else
+        {
+            char output_path[PATH_MAX];
+            snprintf(output_path, sizeof(output_path), "client%d_%s", rank, filename);
+            output_fd = open(output_path, O_RDONLY);
+        }
+
+        FileDetails *file = store_add_file(&peer_info->owned_files, filename, header->total_segments);
+        file->payload = map.data;
+        file->payload_size = map.size;
+
+        int kept = 0, marked = 0;
+        for (int segment = 0; segment < (int)header->total_segments; segment++)
+        {
+            if (!resume_has(&state, segment))
+                continue;
+            marked++;
+            if (verify_resumed_segment(&state, map.data, output_fd, segment))
+            {
+                store_put_segment(file, segment, state.digests + (size_t)segment * HASH_SIZE);
+                kept++;
+            }
+            else
+            {
+                resume_clear(&state, segment);
+            }
+        }
+        LOG_INFO("Peer %d: Resumed %s with %d of %d segments (%d failed verification).\n",
+                 rank, filename, kept, (int)header->total_segments, marked - kept);
+
+        if (output_fd >= 0)
+            close(output_fd);
+        resume_close(&state);
+    }
+}
+
+// Adauga in blocul de inregistrare un mesaj de size octeti, initializat cu
+// zero, si intoarce locul lui
+void *registration_append(int rank, Registration *registration, int tag, size_t size)
+{
+    size_t needed = registration->size + proto_record_size(size);
+    if (needed > registration->capacity)
+    {
+        size_t capacity = registration->capacity ? registration->capacity : 4096;
+        while (capacity < needed)
+            capacity *= 2;
+        uint8_t *data = (uint8_t *)realloc(registration->data, capacity);
+        if (!data)
+        {
+            LOG_ERROR("Peer %d: Memory allocation failed\n", rank);
+            MPI_Abort(MPI_COMM_WORLD, -1);
+        }
+        registration->data = data;
+        registration->capacity = capacity;
+    }
+
+    RecordHeader *record = (RecordHeader *)(registration->data + registration->size);
+    memset(record, 0, proto_record_size(size));
+    record->size = (uint32_t)size;
+    record->tag = (uint32_t)tag;
+    registration->size = needed;
+    return record + 1;
+}
+
+// Construieste inregistrarea pentru un shard de tracker: INIT, segmentele
+// descarcarilor reluate si hash-urile fiecarui fisier. Un peer fara fisiere
+// pentru shard are un bloc gol.
+void build_registration(int rank, PeerInfo *peer_info, int shard, Registration *registration)
+{
+    SegmentStore *owned = &peer_info->owned_files;
+    int owned_count = store_file_count(owned);
+    FileDetails **files = (FileDetails **)malloc((owned_count + 1) * sizeof(FileDetails *));
+    if (!files)
+    {
+        LOG_ERROR("Peer %d: Memory allocation failed\n", rank);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+    int file_count = 0;
+    for (int i = 0; i < owned_count; i++)
+    {
+        FileDetails *file = store_file_at(owned, i);
+        if (tracker_for(file->file_id) == shard)
+        {
+            files[file_count++] = file;
+        }
+    }
+    if (file_count == 0)
+    {
+        free(files);
+        return;
+    }
+
+    // Mesajul INIT: numele fisierelor si numarul de segmente
+    InitMsg *init_message = (InitMsg *)registration_append(rank, registration, MSG_INIT,
+                                                           proto_init_size(file_count));
+    proto_header_init(&init_message->hdr, MSG_INIT, 0);
+    init_message->file_count = file_count;
+    for (int i = 0; i < file_count; i++)
+    {
+        FileEntry *entry = &init_message->files[i];
+        FileDetails *file = files[i];
+        entry->file_id = file->file_id;
+        entry->total_segments = file->total_segments;
+        entry->file_size = file->payload_size;
+        entry->flags = file_is_partial(file) ? FILE_ENTRY_PARTIAL : 0;
+        strcpy(entry->filename, file->filename);
+    }
+
+    // Segmentele detinute din descarcarile reluate; restul fisierelor sunt complete
+    for (int i = 0; i < file_count; i++)
+    {
+        FileDetails *file = files[i];
+        if (!file_is_partial(file))
+            continue;
+
+        BitfieldMsg *update = (BitfieldMsg *)registration_append(rank, registration, MSG_SEGMENT_BITFIELD,
+                                                                 proto_bitfield_size(file->total_segments));
+        proto_header_init(&update->hdr, MSG_SEGMENT_BITFIELD, 0);
+        update->file_id = file->file_id;
+        update->segment_count = file->total_segments;
+        store_copy_bitfield(file, update->bits);
+    }
+
+    // Hash-urile fiecarui fisier intr-un singur mesaj UPLOAD
+    for (int i = 0; i < file_count; i++)
+    {
+        FileDetails *file = files[i];
+        int is_last = (i == file_count - 1);
+        // Hash-urile unei descarcari reluate vin de la seed-uri
+        int hash_count = file_is_partial(file) ? 0 : file->total_segments;
+
+        UploadMsg *upload_message = (UploadMsg *)registration_append(rank, registration, MSG_UPLOAD,
+                                                                     proto_upload_size(hash_count));
+        proto_header_init(&upload_message->hdr, MSG_UPLOAD, is_last ? MSG_FLAG_LAST : 0);
+        upload_message->file_id = file->file_id;
+        upload_message->hash_count = hash_count;
+        // Blocul de hash-uri al fisierului este deja in formatul mesajului
+        memcpy(upload_message->digests, file->digests, (size_t)hash_count * HASH_SIZE);
+
+        LOG_DEBUG("Peer %d: Added UPLOAD for file %s with %d segments.\n",
+                rank, file->filename, file->total_segments);
+    }
+    free(files);
+}
+
+// Cu --early-start, fiecare shard primeste direct inregistrarea: un INIT cu
+// dimensiunea blocului, apoi blocul. Peer-ul nu asteapta raspuns.
+void send_registrations(int rank, Registration *registrations)
+{
+    int shards = options.trackers;
+    RegisterMsg *announces = (RegisterMsg *)calloc(shards, sizeof(RegisterMsg));
+    MPI_Request *requests = (MPI_Request *)malloc(2 * shards * sizeof(MPI_Request));
+    if (!announces || !requests)
+    {
+        LOG_ERROR("Peer %d: Memory allocation failed\n", rank);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+
+    for (int shard = 0; shard < shards; shard++)
+    {
+        if (registrations[shard].size > INT_MAX)
+        {
+            LOG_ERROR("Peer %d: Registration for tracker %d is too large\n", rank, shard);
+            MPI_Abort(MPI_COMM_WORLD, -1);
+        }
+        proto_header_init(&announces[shard].hdr, MSG_INIT, 0);
+        announces[shard].size = (uint32_t)registrations[shard].size;
+        MPI_Isend(&announces[shard], sizeof(RegisterMsg), MPI_BYTE, shard, MSG_INIT, MPI_COMM_WORLD,
+                  &requests[2 * shard]);
+        requests[2 * shard + 1] = MPI_REQUEST_NULL;
+        if (registrations[shard].size > 0)
+        {
+            MPI_Isend(registrations[shard].data, (int)registrations[shard].size, MPI_BYTE, shard, MSG_UPLOAD,
+                      MPI_COMM_WORLD, &requests[2 * shard + 1]);
+        }
+    }
+    MPI_Waitall(2 * shards, requests, MPI_STATUSES_IGNORE);
+    free(announces);
+    free(requests);
+}
+
+// Trimite info despre fisiere la tracker. Intoarce bariera neblocanta care se
+// termina cand toate shard-urile au prelucrat inregistrarile tuturor peers;
+// cu --early-start, MPI_REQUEST_NULL.
+MPI_Request send_file_info_to_tracker(int rank, int numtasks, PeerInfo *peer_info)
+{
+    Registration *registrations = (Registration *)calloc(options.trackers, sizeof(Registration));
+    if (!registrations)
+    {
+        LOG_ERROR("Peer %d: Memory allocation failed\n", rank);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+    for (int shard = 0; shard < options.trackers; shard++)
+    {
+        build_registration(rank, peer_info, shard, &registrations[shard]);
+    }
+
+    MPI_Request barrier = MPI_REQUEST_NULL;
+    if (options.early_start)
+    {
+        send_registrations(rank, registrations);
+    }
+    else
+    {
+        // Pe un peer nu se aduna nimic; pointerii raman NULL
+        uint8_t *gathered;
+        int *counts;
+        int *displs;
+        gather_registrations(rank, numtasks, registrations, &gathered, &counts, &displs);
+
+        // Bariera inlocuieste ACK-urile trackerului
+        MPI_Ibarrier(MPI_COMM_WORLD, &barrier);
+    }
+
+    for (int shard = 0; shard < options.trackers; shard++)
+    {
+        free(registrations[shard].data);
+    }
+    free(registrations);
+    LOG_INFO("Peer %d: Registration sent to %d tracker(s).\n", rank, options.trackers);
+    return barrier;
+}
+
+// Creeaza fisierul de iesire la dimensiunea finala. Fiecare segment are o
+// linie de lungime fixa, scrisa la pozitia ei cand segmentul este acceptat.
+void open_output_file(int rank, DownloadInfo *download)
+{
+    char output_filename[100];
+    sprintf(output_filename, "client%d_%s", rank, download->filename);
+    download->output_fd = open(output_filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (download->output_fd < 0)
+    {
+        LOG_ERROR("Peer %d: Error creating output file %s\n", rank, output_filename);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+
+    off_t size = (off_t)download->segments_total * HASH_LINE_SIZE;
+    if (ftruncate(download->output_fd, size) != 0)
+    {
+        LOG_ERROR("Peer %d: Cannot allocate output file %s\n", rank, output_filename);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+    if (size > 0)
+        posix_fallocate(download->output_fd, 0, size);
+}
+
+// Scrie linia unui segment acceptat; firele scriu in paralel, la pozitii diferite
+void write_output_line(int rank, DownloadInfo *download, int segment, const uint8_t *digest)
+{
+    char line[HASH_LINE_SIZE];
+    memcpy(line, digest, HASH_SIZE);
+    line[HASH_SIZE] = '\n';
+    if (pwrite(download->output_fd, line, sizeof(line), (off_t)segment * HASH_LINE_SIZE) != sizeof(line))
+    {
+        LOG_WARN("Peer %d: Cannot write segment %d of %s\n", rank, segment, download->filename);
+    }
+}
+
+// Salveaza fisierul descarcat in fisierul specificat de cerinta, cu linii de
+// diagnostic pentru segmentele lipsa
+void save_downloaded_file(int rank, const char *filename, PeerInfo *peer_info)
+{
+    char output_filename[100];
+    sprintf(output_filename, "client%d_%s", rank, filename);
+    FILE *output_file = fopen(output_filename, "w");
+    if (!output_file)
+    {
+        LOG_ERROR("Peer %d: Error creating output file %s\n", rank, output_filename);
+        return;
+    }
+
+    FileDetails *file = store_find(&peer_info->owned_files, proto_file_id(filename));
+    for (int j = 0; file && j < file->total_segments; j++)
+    {
+        if (store_has_segment(file, j))
+        {
+            char hash_value[HASH_SIZE + 1];
+            proto_digest_to_str(hash_value, store_digest(file, j));
+            fprintf(output_file, "%s\n", hash_value);
+        }
+        else
+        {
+            fprintf(output_file, "MISSING_SEGMENT_%d\n", j); // Diagnostic
+        }
+    }
+
+    fclose(output_file);
+    LOG_INFO("Peer %d: Saved downloaded file %s.\n", rank, output_filename);
+}
+
+// Raspunde unei cereri de segment primite de la alt peer
+void serve_request(int rank, PeerInfo *peer_info, UploadJob *job)
+{
+    FileMsg *request = &job->request;
+    SegmentHashMsg response;
+    int segment_index = request->segment_index;
+
+    int has_segment = 0;
+
+    // Citire fara lock: bitul segmentului se incarca cu acquire, deci
+    // hash-ul scris inaintea lui este complet
+    FileDetails *file = store_find(&peer_info->owned_files, request->file_id);
+    if (file && store_has_segment(file, segment_index))
+    {
+        has_segment = 1;
+        memcpy(response.digest, store_digest(file, segment_index), HASH_SIZE);
+    }
+
+    // Continutul cerut pleaca direct din maparea fisierului, fara copie
+    uint32_t length = 0;
+    if (has_segment && request->payload_tag >= MSG_PAYLOAD_TAG_BASE)
+    {
+        length = payload_segment_length(file->payload_size, segment_index, options.segment_size);
+        has_segment = file->payload != NULL && length > 0;
+    }
+
+    int reply_tag = proto_reply_tag(request, MSG_DOWNLOAD_RESPONSE);
+    response.file_id = request->file_id;
+    response.segment_index = request->segment_index;
+
+    if (has_segment)
+    {
+        if (length > 0)
+        {
+            MPI_Send(file->payload + payload_segment_offset(segment_index, options.segment_size), length,
+                     MPI_BYTE, job->source, request->payload_tag, MPI_COMM_WORLD);
+        }
+        proto_header_init(&response.hdr, MSG_DOWNLOAD_RESPONSE, 0);
+        MPI_Send(&response, sizeof(response), MPI_BYTE,
+                 job->source, reply_tag, MPI_COMM_WORLD);
+        LOG_DEBUG("Peer %d: Sent hash for segment %d to peer %d.\n",
+                rank, segment_index, job->source);
+    }
+    else
+    {
+        proto_header_init(&response.hdr, MSG_DOWNLOAD_RESPONSE, MSG_FLAG_NACK);
+        memset(response.digest, 0, HASH_SIZE);
+        MPI_Send(&response, sizeof(response), MPI_BYTE, job->source,
+                 reply_tag, MPI_COMM_WORLD);
+        LOG_DEBUG("Peer %d: NACK for segment %d, file %08x.\n",
+                rank, segment_index, request->file_id);
+    }
+}
+
+// Adauga o cerere in coada unui worker de upload; asteapta daca este plina
+void upload_queue_push(UploadQueue *queue, UploadJob *job)
+{
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == UPLOAD_QUEUE_SIZE)
+    {
+        pthread_cond_wait(&queue->not_full, &queue->lock);
+    }
+
+    job->enqueue_time = MPI_Wtime();
+    queue->jobs[queue->tail] = *job;
+    queue->tail = (queue->tail + 1) % UPLOAD_QUEUE_SIZE;
+    queue->count++;
+    if (queue->count > queue->max_depth)
+    {
+        queue->max_depth = queue->count;
+    }
+
+    pthread_cond_signal(&queue->not_empty);
+    pthread_mutex_unlock(&queue->lock);
+}
+
+// Scoate urmatoarea cerere din coada. Intoarce 0 cand coada este goala si
+// oprita.
+int upload_queue_pop(UploadQueue *queue, UploadJob *job)
+{
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == 0 && !queue->stop)
+    {
+        pthread_cond_wait(&queue->not_empty, &queue->lock);
+    }
+
+    if (queue->count == 0)
+    {
+        pthread_mutex_unlock(&queue->lock);
+        return 0;
+    }
+
+    *job = queue->jobs[queue->head];
+    queue->head = (queue->head + 1) % UPLOAD_QUEUE_SIZE;
+    queue->count--;
+    queue->handled++;
+    double wait = MPI_Wtime() - job->enqueue_time;
+    queue->total_wait += wait;
+    metrics_record(HIST_UPLOAD_WAIT, wait);
+
+    pthread_cond_signal(&queue->not_full);
+    pthread_mutex_unlock(&queue->lock);
+    return 1;
+}
+
+// Workerul de upload: raspunde cererilor din coada lui
+void *upload_worker_func(void *arg)
+{
+    UploadWorker *worker = (UploadWorker *)arg;
+    UploadJob job;
+
+    while (upload_queue_pop(&worker->queue, &job))
+    {
+        serve_request(worker->rank, worker->peer_info, &job);
+    }
+
+    return NULL;
+}
+
+// Alege workerul de upload cu cea mai scurta coada
+UploadWorker *least_loaded_worker(UploadWorker *workers, int count)
+{
+    UploadWorker *best = &workers[0];
+    int best_count = -1;
+
+    for (int w = 0; w < count; w++)
+    {
+        pthread_mutex_lock(&workers[w].queue.lock);
+        int queued = workers[w].queue.count;
+        pthread_mutex_unlock(&workers[w].queue.lock);
+
+        if (best_count == -1 || queued < best_count)
+        {
+            best = &workers[w];
+            best_count = queued;
+        }
+    }
+    return best;
+}
+
+// Firul de upload - primeste cererile de segmente in buffere pre-postate si
+// le imparte workerilor de upload
+void *upload_thread_func(void *arg)
+{
+    ThreadArgs *thread_args = (ThreadArgs *)arg;
+    int rank = thread_args->rank;
+    MPI_Status status;
+
+    int worker_count = options.upload_workers;
+    int buffer_count = worker_count * UPLOAD_BUFFERS_PER_WORKER;
+    UploadWorker *workers = (UploadWorker *)calloc(worker_count, sizeof(UploadWorker));
+    FileMsg *requests = (FileMsg *)calloc(buffer_count, sizeof(FileMsg));
+    MPI_Request *recv_requests = (MPI_Request *)malloc(buffer_count * sizeof(MPI_Request));
+    if (!workers || !requests || !recv_requests)
+    {
+        LOG_ERROR("Peer %d: Memory allocation failed\n", rank);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+
+    for (int w = 0; w < worker_count; w++)
+    {
+        workers[w].id = w;
+        workers[w].rank = rank;
+        workers[w].peer_info = thread_args->peer_info;
+        pthread_mutex_init(&workers[w].queue.lock, NULL);
+        pthread_cond_init(&workers[w].queue.not_empty, NULL);
+        pthread_cond_init(&workers[w].queue.not_full, NULL);
+
+        if (pthread_create(&workers[w].thread, NULL, upload_worker_func, &workers[w]))
+        {
+            LOG_ERROR("Peer %d: Error creating upload worker.\n", rank);
+            exit(-1);
+        }
+    }
+
+    for (int i = 0; i < buffer_count; i++)
+    {
+        MPI_Irecv(&requests[i], sizeof(FileMsg), MPI_BYTE, MPI_ANY_SOURCE,
+                  MSG_DOWNLOAD_REQUEST, MPI_COMM_WORLD, &recv_requests[i]);
+    }
+
+    while (1)
+    {
+        int index;
+        MPI_Waitany(buffer_count, recv_requests, &index, &status);
+
+        FileMsg *request = &requests[index];
+        int request_size;
+        MPI_Get_count(&status, MPI_BYTE, &request_size);
+        metrics_add(METRIC_BYTES_RECEIVED, request_size);
+        metrics_add(METRIC_MESSAGES_RECEIVED, 1);
+        if (proto_check(request, request_size, MSG_DOWNLOAD_REQUEST, sizeof(FileMsg)) != 0)
+        {
+            LOG_WARN("Peer %d: Malformed request from peer %d.\n", rank, status.MPI_SOURCE);
+        }
+        else if (request->hdr.flags & MSG_FLAG_TERMINATE)
+        {
+            LOG_INFO("Peer %d: Received TERMINATE signal. Exiting upload thread.\n", rank);
+            recv_requests[index] = MPI_REQUEST_NULL;
+            break;
+        }
+        else
+        {
+            UploadJob job;
+            job.request = *request;
+            job.source = status.MPI_SOURCE;
+            upload_queue_push(&least_loaded_worker(workers, worker_count)->queue, &job);
+        }
+
+        MPI_Irecv(request, sizeof(FileMsg), MPI_BYTE, MPI_ANY_SOURCE,
+                  MSG_DOWNLOAD_REQUEST, MPI_COMM_WORLD, &recv_requests[index]);
+    }
+
+    for (int i = 0; i < buffer_count; i++)
+    {
+        if (recv_requests[i] != MPI_REQUEST_NULL)
+        {
+            MPI_Cancel(&recv_requests[i]);
+            MPI_Wait(&recv_requests[i], MPI_STATUS_IGNORE);
+        }
+    }
+
+    // Workerii termina cererile deja primite, apoi se opresc
+    for (int w = 0; w < worker_count; w++)
+    {
+        UploadQueue *queue = &workers[w].queue;
+        pthread_mutex_lock(&queue->lock);
+        queue->stop = 1;
+        pthread_cond_signal(&queue->not_empty);
+        pthread_mutex_unlock(&queue->lock);
+    }
+
+    for (int w = 0; w < worker_count; w++)
+    {
+        UploadQueue *queue = &workers[w].queue;
+        pthread_join(workers[w].thread, NULL);
+
+        LOG_INFO("Peer %d: Upload worker %d handled %ld requests, max queue %d, avg wait %.1f us.\n",
+                rank, w, queue->handled, queue->max_depth,
+                queue->handled ? queue->total_wait / queue->handled * 1e6 : 0.0);
+
+        pthread_mutex_destroy(&queue->lock);
+        pthread_cond_destroy(&queue->not_empty);
+        pthread_cond_destroy(&queue->not_full);
+    }
+
+    free(workers);
+    free(requests);
+    free(recv_requests);
+    return NULL;
+}
+
+// Salveaza un segment nou primit pentru un fisier
+void store_segment_locally(DownloadInfo *download, int segment_index, const uint8_t *digest)
+{
+    FileDetails *file = store_add_file(&global_peer_info.owned_files,
+                                       download->filename, download->segments_total);
+    store_put_segment(file, segment_index, digest);
+}
+
+// Bitfield-ul unui peer in vederea asupra fisierului, adaugat daca lipseste.
+// Se apeleaza cu download->lock tinut, dupa ce manifestul a sosit.
+uint8_t *download_peer_bits(DownloadInfo *download, int peer)
+{
+    if (peer < 0 || peer >= download->rank_count)
+    {
+        return NULL;
+    }
+
+    int index = download->peer_index[peer];
+    if (index == -1)
+    {
+        if (download->peer_count == download->peer_capacity)
+        {
+            download->peer_capacity = download->peer_capacity ? download->peer_capacity * 2 : 4;
+            download->peers = (int *)realloc(download->peers, download->peer_capacity * sizeof(int));
+            download->peer_bits = (uint8_t *)realloc(download->peer_bits,
+                                                     (size_t)download->peer_capacity * download->bitfield_bytes + 1);
+            if (!download->peers || !download->peer_bits)
+            {
+                LOG_ERROR("Download: Memory allocation failed\n");
+                MPI_Abort(MPI_COMM_WORLD, -1);
+            }
+        }
+
+        index = download->peer_count++;
+        download->peers[index] = peer;
+        download->peer_index[peer] = index;
+        memset(download->peer_bits + (size_t)index * download->bitfield_bytes, 0, download->bitfield_bytes);
+    }
+    return download->peer_bits + (size_t)index * download->bitfield_bytes;
+}
+
+// Trimite LIST_PEERS pentru fisier, fara sa astepte raspunsul de pe reply_tag
+void send_list_request(DownloadInfo *download, int reply_tag)
+{
+    FileMsg request;
+    proto_header_init(&request.hdr, MSG_LIST_PEERS, 0);
+    request.file_id = download->file_id;
+    pthread_mutex_lock(&download->lock);
+    request.segment_index = download->have_hashes ? download->list_version : 0;
+    pthread_mutex_unlock(&download->lock);
+    request.reply_tag = reply_tag;
+    request.payload_tag = 0;
+    MPI_Send(&request, sizeof(request), MPI_BYTE, tracker_for(download->file_id), MSG_LIST_PEERS, MPI_COMM_WORLD);
+}
+
+// Primeste urmatorul PEER_LIST de la source pe reply_tag; se elibereaza de apelant
+PeerListMsg *receive_peer_list(int rank, int source, int reply_tag)
+{
+    MPI_Status status;
+    int list_size;
+    MPI_Probe(source, reply_tag, MPI_COMM_WORLD, &status);
+    MPI_Get_count(&status, MPI_BYTE, &list_size);
+
+    PeerListMsg *peer_list = (PeerListMsg *)malloc(list_size);
+    if (!peer_list)
+    {
+        LOG_ERROR("Peer %d: Memory allocation failed\n", rank);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+    MPI_Recv(peer_list, list_size, MPI_BYTE, status.MPI_SOURCE, reply_tag, MPI_COMM_WORLD, &status);
+
+    if (proto_check_peer_list(peer_list, list_size) != 0)
+    {
+        LOG_ERROR("Peer %d: Malformed peer list from rank %d.\n", rank, status.MPI_SOURCE);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+    return peer_list;
+}
+
+// Adauga lista tracker-ului la descarcare; prima lista aduce si manifestul
+void apply_peer_list(int rank, DownloadInfo *download, PeerListMsg *peer_list)
+{
+    pthread_mutex_lock(&download->lock);
+
+    // Fisierul nu are manifest la tracker; o lista deja primita ramane valabila
+    if (peer_list->hdr.flags & MSG_FLAG_NACK)
+    {
+        if (!download->have_hashes && !download->unavailable)
+        {
+            download->unavailable = 1;
+            LOG_WARN("Peer %d: File %s is not available from any seed.\n", rank, download->filename);
+        }
+        pthread_mutex_unlock(&download->lock);
+        return;
+    }
+
+    // Manifestul se copiaza o singura data, inainte ca workerii sa primeasca segmentele fisierului
+    if (!download->have_hashes)
+    {
+        download->segments_total = peer_list->total_segments;
+        download->file_size = peer_list->file_size;
+        download->bitfield_bytes = bitfield_bytes(peer_list->total_segments);
+        download->digests = (uint8_t *)calloc((size_t)peer_list->total_segments + 1, HASH_SIZE);
+        if (!download->digests)
+        {
+            LOG_ERROR("Peer %d: Memory allocation failed\n", rank);
+            MPI_Abort(MPI_COMM_WORLD, -1);
+        }
+        memcpy(download->digests, proto_peer_list_digests(peer_list),
+               (size_t)peer_list->hash_count * HASH_SIZE);
+        download->have_hashes = 1;
+    }
+
+    // Lista tracker-ului se adauga la ce se stie deja din gossip. Un raspuns
+    // mai vechi decat altul deja aplicat aduce doar biti stiuti.
+    if (peer_list->version > download->list_version)
+    {
+        download->list_version = peer_list->version;
+    }
+    const uint8_t *bits = proto_peer_list_bitfields(peer_list);
+    for (uint32_t p = 0; p < peer_list->peer_count; p++)
+    {
+        uint8_t *row = download_peer_bits(download, peer_list->peers[p]);
+        if (row && (int)peer_list->bitfield_bytes == download->bitfield_bytes)
+        {
+            bitfield_merge(row, bits + (size_t)p * download->bitfield_bytes, download->bitfield_bytes);
+        }
+    }
+    pthread_mutex_unlock(&download->lock);
+}
+
+// Cere tracker-ului manifestul unui fisier: lista de peers si hash-urile
+// segmentelor sosesc intr-un singur mesaj, pe eticheta reply_tag
+void request_peer_list(int rank, DownloadInfo *download, int reply_tag)
+{
+    double sent = MPI_Wtime();
+    send_list_request(download, reply_tag);
+    PeerListMsg *peer_list = receive_peer_list(rank, tracker_for(download->file_id), reply_tag);
+    metrics_record(HIST_PEER_LIST_RTT, MPI_Wtime() - sent);
+
+    if (peer_list->file_id != download->file_id)
+    {
+        LOG_ERROR("Peer %d: Peer list for another file instead of %s.\n", rank, download->filename);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+    apply_peer_list(rank, download, peer_list);
+    free(peer_list);
+}
+
+// Scoate urmatorul segment din coada proprie sau fura unul de la alt worker
+int take_task(DownloadWorker *worker, SegmentTask *task)
+{
+    for (int i = 0; i < worker->worker_count; i++)
+    {
+        int victim = (worker->id + i) % worker->worker_count;
+        TaskDeque *deque = &worker->deques[victim];
+        int found = 0;
+
+        pthread_mutex_lock(&deque->lock);
+        if (deque->head < deque->tail)
+        {
+            if (victim == worker->id)
+                *task = deque->tasks[deque->head++];
+            else
+                *task = deque->tasks[--deque->tail];
+            found = 1;
+        }
+        pthread_mutex_unlock(&deque->lock);
+
+        if (found)
+            return 1;
+    }
+    return 0;
+}
+
+// Adauga un segment la sfarsitul cozii; apelata cu deque->lock tinut
+void deque_push(int rank, TaskDeque *deque, DownloadInfo *download, int segment)
+{
+    if (deque->tail == deque->capacity)
+    {
+        deque->capacity = deque->capacity ? deque->capacity * 2 : 64;
+        deque->tasks = (SegmentTask *)realloc(deque->tasks, deque->capacity * sizeof(SegmentTask));
+        if (!deque->tasks)
+        {
+            LOG_ERROR("Peer %d: Memory allocation failed\n", rank);
+            MPI_Abort(MPI_COMM_WORLD, -1);
+        }
+    }
+    SegmentTask *task = &deque->tasks[deque->tail++];
+    task->download = download;
+    task->segment = segment;
+}
+
+long feed_generation(TaskFeed *feed)
+{
+    pthread_mutex_lock(&feed->lock);
+    long generation = feed->generation;
+    pthread_mutex_unlock(&feed->lock);
+    return generation;
+}
+
+// Asteapta segmente adaugate dupa generatia seen. Intoarce 0 daca nu mai
+// vine niciun manifest, deci workerul a terminat.
+int feed_wait(TaskFeed *feed, long seen)
+{
+    pthread_mutex_lock(&feed->lock);
+    while (feed->pending > 0 && feed->generation == seen)
+    {
+        pthread_cond_wait(&feed->changed, &feed->lock);
+    }
+    int more = feed->generation != seen;
+    pthread_mutex_unlock(&feed->lock);
+    return more;
+}
+
+void window_init(RequestWindow *window, int depth, int response_tag)
+{
+    window->depth = depth;
+    window->in_flight = 0;
+    window->response_tag = response_tag;
+    window->slots = (PendingRequest *)calloc(depth, sizeof(PendingRequest));
+    window->responses = (SegmentHashMsg *)calloc(depth, sizeof(SegmentHashMsg));
+    window->recv_requests = (MPI_Request *)malloc(3 * depth * sizeof(MPI_Request));
+    window->ready = (int *)malloc(depth * sizeof(int));
+    window->ready_count = 0;
+    if (!window->slots || !window->responses || !window->recv_requests || !window->ready)
+    {
+        LOG_ERROR("Download: Memory allocation failed\n");
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+
+    for (int i = 0; i < depth; i++)
+    {
+        MPI_Irecv(&window->responses[i], sizeof(SegmentHashMsg), MPI_BYTE, MPI_ANY_SOURCE,
+                  response_tag, MPI_COMM_WORLD, &window->recv_requests[i]);
+        window->recv_requests[depth + i] = MPI_REQUEST_NULL;
+        window->recv_requests[2 * depth + i] = MPI_REQUEST_NULL;
+    }
+}
+
+void window_destroy(RequestWindow *window)
+{
+    for (int i = 0; i < window->depth; i++)
+    {
+        MPI_Cancel(&window->recv_requests[i]);
+        MPI_Wait(&window->recv_requests[i], MPI_STATUS_IGNORE);
+        free(window->slots[i].tried);
+    }
+    free(window->slots);
+    free(window->responses);
+    free(window->recv_requests);
+    free(window->ready);
+}
+
+int slot_tried(PendingRequest *slot, int peer)
+{
+    for (int i = 0; i < slot->tried_count; i++)
+    {
+        if (slot->tried[i] == peer)
+            return 1;
+    }
+    return 0;
+}
+
+void slot_mark_tried(PendingRequest *slot, int peer)
+{
+    if (slot->tried_count == slot->tried_capacity)
+    {
+        slot->tried_capacity = slot->tried_capacity ? slot->tried_capacity * 2 : 4;
+        slot->tried = (int *)realloc(slot->tried, slot->tried_capacity * sizeof(int));
+        if (!slot->tried)
+        {
+            LOG_ERROR("Download: Memory allocation failed\n");
+            MPI_Abort(MPI_COMM_WORLD, -1);
+        }
+    }
+    slot->tried[slot->tried_count++] = peer;
+}
+
+// Ordinea naturala a segmentelor
+void sequential_order(int rank, DownloadInfo *download, int *segments)
+{
+    for (int s = 0; s < download->segments_total; s++)
+    {
+        segments[s] = s;
+    }
+}
+
+// Alegere circulara a peer-ului de la care descarcam. Lista de peers se poate
+// reimprospata intre incercari, asa ca se tine evidenta peers deja intrebati
+// in loc de o pozitie in lista.
+int round_robin_peer(int rank, DownloadInfo *download, PendingRequest *slot)
+{
+    for (int k = 0; k < download->peer_count; k++)
+    {
+        int candidate = download->peers[(slot->segment + slot->attempts + k) % download->peer_count];
+        if (candidate != rank && !slot_tried(slot, candidate))
+        {
+            return candidate;
+        }
+    }
+    return -1;
+}
+
+typedef struct
+{
+    int availability; // peers care detin segmentul
+    uint32_t tie;
+    int segment;
+} SegmentRarity;
+
+int compare_rarity(const void *a, const void *b)
+{
+    const SegmentRarity *x = (const SegmentRarity *)a;
+    const SegmentRarity *y = (const SegmentRarity *)b;
+    if (x->availability != y->availability)
+        return x->availability < y->availability ? -1 : 1;
+    if (x->tie != y->tie)
+        return x->tie < y->tie ? -1 : 1;
+    return x->segment - y->segment;
+}
+
+// Amestec determinist al segmentului cu rank-ul
+uint32_t rarity_tie(int segment, int rank)
+{
+    uint32_t x = (uint32_t)segment * 2654435761u ^ (uint32_t)rank * 0x85ebca6bu;
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    return x;
+}
+
+// Segmentele detinute de cei mai putini peers se descarca primele. Egalitatile
+// se rup diferit pe fiecare rank, ca peers care descarca acelasi fisier sa
+// ceara segmente diferite si sa si le poata da apoi unul altuia.
+void rarest_first_order(int rank, DownloadInfo *download, int *segments)
+{
+    int total = download->segments_total;
+    SegmentRarity *rarity = (SegmentRarity *)calloc(total + 1, sizeof(SegmentRarity));
+    if (!rarity)
+    {
+        LOG_ERROR("Peer %d: Memory allocation failed\n", rank);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+
+    for (int s = 0; s < total; s++)
+    {
+        rarity[s].segment = s;
+        rarity[s].tie = rarity_tie(s, rank);
+    }
+
+    for (int p = 0; download->bitfield_bytes > 0 && p < download->peer_count; p++)
+    {
+        const uint8_t *bits = download->peer_bits + (size_t)p * download->bitfield_bytes;
+        if (download->peers[p] == rank)
+            continue;
+        for (int s = 0; s < total; s++)
+        {
+            rarity[s].availability += bitfield_test(bits, s);
+        }
+    }
+
+    qsort(rarity, total, sizeof(SegmentRarity), compare_rarity);
+    for (int s = 0; s < total; s++)
+    {
+        segments[s] = rarity[s].segment;
+    }
+    free(rarity);
+}
+
+// Doar peers despre care tracker-ul stie ca detin segmentul, intai cei de pe
+// acelasi nod. Cand niciunul nu mai poate fi intrebat, se revine la alegerea
+// circulara.
+int holder_peer(int rank, DownloadInfo *download, PendingRequest *slot)
+{
+    int remote = -1;
+    for (int k = 0; download->bitfield_bytes > 0 && k < download->peer_count; k++)
+    {
+        int index = (slot->segment + slot->attempts + k) % download->peer_count;
+        int candidate = download->peers[index];
+        const uint8_t *bits = download->peer_bits + (size_t)index * download->bitfield_bytes;
+        if (candidate != rank && !slot_tried(slot, candidate) && bitfield_test(bits, slot->segment))
+        {
+            if (node_is_local(candidate))
+                return candidate;
+            if (remote == -1)
+                remote = candidate;
+        }
+    }
+    return remote != -1 ? remote : round_robin_peer(rank, download, slot);
+}
+
+const PiecePicker piece_pickers[] = {
+    {"rarest", rarest_first_order, holder_peer},
+    {"round-robin", sequential_order, round_robin_peer},
+};
+
+const PiecePicker *find_piece_picker(const char *name)
+{
+    for (size_t i = 0; i < sizeof(piece_pickers) / sizeof(piece_pickers[0]); i++)
+    {
+        if (strcmp(piece_pickers[i].name, name) == 0)
+            return &piece_pickers[i];
+    }
+    return NULL;
+}
+
+// Mesaj nou alocat cu segmentele detinute dintr-un fisier
+BitfieldMsg *build_bitfield(PeerInfo *peer_info, int type, int flags,
+                            uint32_t file_id, int segment_count, size_t *size)
+{
+    *size = proto_bitfield_size(segment_count);
+    BitfieldMsg *message = (BitfieldMsg *)calloc(1, *size);
+    if (!message)
+    {
+        LOG_ERROR("Peer: Memory allocation failed\n");
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+
+    proto_header_init(&message->hdr, type, flags);
+    message->file_id = file_id;
+    message->segment_count = segment_count;
+
+    FileDetails *file = store_find(&peer_info->owned_files, file_id);
+    if (file && file->total_segments == segment_count)
+    {
+        store_copy_bitfield(file, message->bits);
+    }
+    return message;
+}
+
+// Trimite tracker-ului segmentele detinute dintr-un fisier descarcat
+void send_segment_bitfield(int rank, DownloadInfo *download, PeerInfo *peer_info)
+{
+    size_t size;
+    BitfieldMsg *update = build_bitfield(peer_info, MSG_SEGMENT_BITFIELD, 0,
+                                         download->file_id, download->segments_total, &size);
+
+    MPI_Send(update, size, MPI_BYTE, tracker_for(download->file_id), MSG_SEGMENT_BITFIELD, MPI_COMM_WORLD);
+    free(update);
+}
+
+// Primul contact cu un peer pentru un fisier: ii trimite bitfield-ul
+// propriu, iar firul lui de gossip raspunde cu al sau
+void greet_peer(DownloadWorker *worker, DownloadInfo *download, int peer)
+{
+    size_t size;
+    BitfieldMsg *hello = build_bitfield(worker->peer_info, MSG_PEER_BITFIELD, MSG_FLAG_INTERESTED,
+                                        download->file_id, download->segments_total, &size);
+
+    pthread_mutex_lock(&gossip_state.lock);
+    gossip_state.hellos_sent++;
+    pthread_mutex_unlock(&gossip_state.lock);
+
+    MPI_Send(hello, size, MPI_BYTE, peer, MSG_GOSSIP, MPI_COMM_WORLD);
+    free(hello);
+}
+
+// Anunta vecinii care descarca fisierul ca segmentul este acum detinut
+void broadcast_have(DownloadWorker *worker, DownloadInfo *download, int segment)
+{
+    // Vecinii doar se adauga, deci primii count raman valizi fara lock
+    pthread_mutex_lock(&download->lock);
+    int count = download->interested_count;
+    pthread_mutex_unlock(&download->lock);
+
+    FileMsg have;
+    proto_header_init(&have.hdr, MSG_HAVE, 0);
+    have.file_id = download->file_id;
+    have.segment_index = segment;
+    have.reply_tag = 0;
+    have.payload_tag = 0;
+    for (int i = 0; i < count; i++)
+    {
+        MPI_Send(&have, sizeof(have), MPI_BYTE, download->interested[i], MSG_GOSSIP, MPI_COMM_WORLD);
+    }
+    worker->haves_sent += count;
+}
+
+// Fisierul expus de peer in fereastra RMA; directorul lui se citeste o
+// singura data. Intoarce 0 daca peer-ul nu l-a expus.
+int remote_file(DownloadInfo *download, int peer, RmaFile *file)
+{
+    pthread_mutex_lock(&download->lock);
+    *file = download->remote_files[peer];
+    pthread_mutex_unlock(&download->lock);
+    if (file->metadata != 0)
+        return 1;
+
+    // Fara continut expus, segmentul se cere prin mesaje
+    if (rma_lookup(peer, download->file_id, file) != 0 || (int)file->total_segments != download->segments_total ||
+        (download->payload && (!file->payload || file->payload_size != download->file_size)))
+        return 0;
+
+    pthread_mutex_lock(&download->lock);
+    download->remote_files[peer] = *file;
+    pthread_mutex_unlock(&download->lock);
+    return 1;
+}
+
+// Porneste citirea etapei curente a slotului, terminata in ultima treime a
+// recv_requests. Intoarce 0 daca citirea a pornit.
+int start_rma_read(DownloadWorker *worker, PendingRequest *slot)
+{
+    RequestWindow *window = &worker->window;
+    DownloadInfo *download = slot->download;
+    MPI_Request *request = &window->recv_requests[2 * window->depth + (slot - window->slots)];
+
+    if (slot->rma_phase == RMA_PROBE)
+        return rma_read_present(slot->peer, &slot->rma_file, slot->segment, &slot->rma_present, request);
+    if (download->payload)
+    {
+        uint64_t offset = payload_segment_offset(slot->segment, options.segment_size);
+        return rma_read_payload(slot->peer, &slot->rma_file, offset, slot->payload_length,
+                                download->payload + offset, request);
+    }
+    return rma_read_digest(slot->peer, &slot->rma_file, slot->segment, slot->rma_response.digest, request);
+}
+
+// Citeste segmentul din slot direct din fereastra peer-ului, fara firul lui
+// de upload. Un segment despre care se stie ca este detinut se citeste
+// direct; altfel intai bitul lui. Intoarce 0 daca peer-ul nu si-a expus
+// fisierul; cererea pleaca atunci prin mesaje.
+int issue_rma_read(DownloadWorker *worker, PendingRequest *slot, int known)
+{
+    DownloadInfo *download = slot->download;
+    if (!remote_file(download, slot->peer, &slot->rma_file))
+        return 0;
+
+    slot->send_request = MPI_REQUEST_NULL;
+    slot->payload_request = MPI_REQUEST_NULL;
+    slot->payload_length = download->payload ? payload_segment_length(download->file_size, slot->segment,
+                                                                       options.segment_size) : 0;
+    slot->rma_phase = known ? RMA_FETCH : RMA_PROBE;
+    proto_header_init(&slot->rma_response.hdr, MSG_DOWNLOAD_RESPONSE, 0);
+    slot->rma_response.file_id = download->file_id;
+    slot->rma_response.segment_index = slot->segment;
+    slot->sent_time = MPI_Wtime();
+    return start_rma_read(worker, slot) == 0;
+}
+
+// Fisierul deschis din pool-ul unui vecin de nod; se deschide o singura
+// data. Intoarce 0 daca vecinul nu l-a expus.
+int local_file(DownloadInfo *download, int peer, NodeFile *file)
+{
+    pthread_mutex_lock(&download->lock);
+    *file = download->local_files[peer];
+    pthread_mutex_unlock(&download->lock);
+    if (file->metadata)
+        return 1;
+
+    if (node_open(peer, download->file_id, file) != 0)
+        return 0;
+    if ((int)file->total_segments != download->segments_total ||
+        (download->payload && (!file->payload.data || file->payload.size != download->file_size)))
+    {
+        node_close(file);
+        return 0;
+    }
+
+    // Alt worker l-a putut deschide intre timp
+    NodeFile opened = *file;
+    pthread_mutex_lock(&download->lock);
+    int raced = download->local_files[peer].metadata != NULL;
+    if (raced)
+        *file = download->local_files[peer];
+    else
+        download->local_files[peer] = opened;
+    pthread_mutex_unlock(&download->lock);
+    if (raced)
+        node_close(&opened);
+    return 1;
+}
+
+// Copiaza segmentul din slot direct din memoria unui vecin de nod: bitul si
+// hash-ul din pool-ul lui, continutul din fisierul lui mapat. Raspunsul este
+// gata imediat si se trateaza in bucla workerului. Intoarce 0 daca peer-ul
+// nu este pe nod sau nu si-a expus fisierul.
+int issue_node_read(DownloadWorker *worker, PendingRequest *slot)
+{
+    RequestWindow *window = &worker->window;
+    DownloadInfo *download = slot->download;
+    NodeFile file;
+    if (!node_is_local(slot->peer) || !local_file(download, slot->peer, &file))
+        return 0;
+
+    slot->send_request = MPI_REQUEST_NULL;
+    slot->payload_request = MPI_REQUEST_NULL;
+    slot->payload_length = 0;
+    slot->sent_time = MPI_Wtime();
+    int held = node_has_segment(&file, slot->segment);
+    proto_header_init(&slot->rma_response.hdr, MSG_DOWNLOAD_RESPONSE, held ? 0 : MSG_FLAG_NACK);
+    slot->rma_response.file_id = download->file_id;
+    slot->rma_response.segment_index = slot->segment;
+    if (held && download->payload)
+    {
+        uint64_t offset = payload_segment_offset(slot->segment, options.segment_size);
+        slot->payload_length = payload_segment_length(download->file_size, slot->segment, options.segment_size);
+        memcpy(download->payload + offset, file.payload.data + offset, slot->payload_length);
+    }
+    else if (held)
+    {
+        memcpy(slot->rma_response.digest, node_digest(&file, slot->segment), HASH_SIZE);
+    }
+    if (held)
+    {
+        metrics_add(METRIC_NODE_READS, 1);
+    }
+
+    window->ready[window->ready_count++] = (int)(slot - window->slots);
+    return 1;
+}
+
+// Trimite cererea din slot catre peer-ul ales de strategie. Intoarce 0 daca
+// s-au epuizat peers pentru acest segment.
+int issue_request(DownloadWorker *worker, PendingRequest *slot)
+{
+    int rank = worker->rank;
+    RequestWindow *window = &worker->window;
+    DownloadInfo *download = slot->download;
+
+    pthread_mutex_lock(&download->lock);
+    int peer_to_request = worker->picker->choose_peer(rank, download, slot);
+    int greet = options.gossip && peer_to_request != -1 &&
+                !(download->neighbor_flags[peer_to_request] & NEIGHBOR_GREETED);
+    if (greet)
+    {
+        download->neighbor_flags[peer_to_request] |= NEIGHBOR_GREETED;
+    }
+    // Bitii aflati de la tracker sau din gossip au fost setati de peer
+    // inaintea mesajului care i-a adus
+    int known = 0;
+    if (peer_to_request != -1 && download->peer_index[peer_to_request] != -1 && download->bitfield_bytes > 0)
+    {
+        known = bitfield_test(download->peer_bits + (size_t)download->peer_index[peer_to_request] *
+                                                        download->bitfield_bytes, slot->segment);
+    }
+    pthread_mutex_unlock(&download->lock);
+
+    if (greet)
+    {
+        greet_peer(worker, download, peer_to_request);
+    }
+
+    if (peer_to_request != -1)
+    {
+        worker->requests++;
+        slot->attempts++;
+        slot_mark_tried(slot, peer_to_request);
+        if (node_is_local(peer_to_request))
+        {
+            metrics_add(METRIC_LOCAL_REQUESTS, 1);
+        }
+
+        slot->peer = peer_to_request;
+        if (options.shared_memory && issue_node_read(worker, slot))
+        {
+            LOG_DEBUG("Peer %d: Copied %s segment %d from Peer %d on this node.\n",
+                      rank, download->filename, slot->segment, peer_to_request);
+            return 1;
+        }
+        if (options.transport == TRANSPORT_RMA && issue_rma_read(worker, slot, known))
+        {
+            LOG_DEBUG("Peer %d: Reading %s segment %d from Peer %d.\n",
+                      rank, download->filename, slot->segment, peer_to_request);
+            return 1;
+        }
+
+        proto_header_init(&slot->request.hdr, MSG_DOWNLOAD_REQUEST, 0);
+        slot->request.file_id = download->file_id;
+        slot->request.segment_index = slot->segment;
+        slot->request.reply_tag = window->response_tag;
+        slot->request.payload_tag = 0;
+        slot->payload_request = MPI_REQUEST_NULL;
+        if (download->payload)
+        {
+            // Receptia se posteaza inaintea cererii, direct in fisierul mapat
+            int payload_tag = WORKER_PAYLOAD_TAG(worker->id, (int)(slot - window->slots));
+            slot->payload_length = payload_segment_length(download->file_size, slot->segment,
+                                                          options.segment_size);
+            MPI_Irecv(download->payload + payload_segment_offset(slot->segment, options.segment_size),
+                      slot->payload_length, MPI_BYTE, peer_to_request, payload_tag, MPI_COMM_WORLD,
+                      &slot->payload_request);
+            slot->request.payload_tag = payload_tag;
+        }
+        slot->sent_time = MPI_Wtime();
+        MPI_Isend(&slot->request, sizeof(slot->request), MPI_BYTE,
+                  peer_to_request, MSG_DOWNLOAD_REQUEST, MPI_COMM_WORLD, &slot->send_request);
+
+        LOG_DEBUG("Peer %d: Requested %s segment %d from Peer %d.\n",
+                rank, download->filename, slot->segment, peer_to_request);
+        return 1;
+    }
+
+    LOG_ERROR("Peer %d: Could not download segment %d of file %s from any peer.\n",
+            rank, slot->segment, download->filename);
+    return 0;
+}
+
+// Fisierul de iesire este deja scris; ramane sincronizarea lui. Daca lipsesc
+// segmente, se rescrie cu liniile de diagnostic.
+void finish_output_file(int rank, DownloadInfo *download, PeerInfo *peer_info)
+{
+    FileDetails *file = store_find(&peer_info->owned_files, download->file_id);
+    int complete = file && atomic_load_explicit(&file->segment_count, memory_order_relaxed) == download->segments_total;
+
+    if (!complete)
+    {
+        close(download->output_fd);
+        download->output_fd = -1;
+        save_downloaded_file(rank, download->filename, peer_info);
+        return;
+    }
+
+    if (download->payload)
+    {
+        PayloadMap map = {download->payload, download->file_size};
+        payload_sync(&map);
+    }
+    fdatasync(download->output_fd);
+    close(download->output_fd);
+    download->output_fd = -1;
+    LOG_INFO("Peer %d: Saved downloaded file client%d_%s.\n", rank, rank, download->filename);
+}
+
+// Anunta tracker-ul ca fisierul este descarcat si il salveaza
+void complete_download(int rank, DownloadInfo *download, PeerInfo *peer_info)
+{
+    send_segment_bitfield(rank, download, peer_info);
+
+    FileMsg finalize_download;
+    proto_header_init(&finalize_download.hdr, MSG_FINISH_DOWNLOAD, 0);
+    finalize_download.file_id = download->file_id;
+    finalize_download.segment_index = download->segments_total;
+    finalize_download.reply_tag = 0;
+    finalize_download.payload_tag = 0;
+    MPI_Send(&finalize_download, sizeof(finalize_download), MPI_BYTE,
+             tracker_for(download->file_id), MSG_FINISH_DOWNLOAD, MPI_COMM_WORLD);
+    LOG_INFO("Peer %d: Sent FINISH_DOWNLOAD for file %s.\n",
+            rank, download->filename);
+
+    finish_output_file(rank, download, peer_info);
+}
+
+// Marcheaza un segment ca terminat; workerul care termina ultimul segment
+// al unui fisier il finalizeaza
+void finish_segment(DownloadWorker *worker, DownloadInfo *download)
+{
+    pthread_mutex_lock(&download->lock);
+    int finished = ++download->segments_finished;
+    int total = download->segments_total;
+    pthread_mutex_unlock(&download->lock);
+
+    if (finished == total)
+    {
+        complete_download(worker->rank, download, worker->peer_info);
+    }
+}
+
+// Porneste cererea pentru un segment intr-un slot liber al ferestrei
+void start_segment(DownloadWorker *worker, SegmentTask *task)
+{
+    RequestWindow *window = &worker->window;
+
+    for (int i = 0; i < window->depth; i++)
+    {
+        PendingRequest *slot = &window->slots[i];
+        if (slot->download != NULL)
+            continue;
+
+        slot->download = task->download;
+        slot->segment = task->segment;
+        slot->attempts = 0;
+        slot->tried_count = 0;
+        if (issue_request(worker, slot))
+        {
+            window->in_flight++;
+        }
+        else
+        {
+            slot->download = NULL;
+            finish_segment(worker, task->download);
+        }
+        return;
+    }
+}
+
+// Termina receptia continutului cerut de slot. Un NACK nu are continut, deci
+// receptia postata se anuleaza.
+void finish_payload(PendingRequest *slot, SegmentHashMsg *message)
+{
+    if (slot->payload_request == MPI_REQUEST_NULL)
+        return;
+
+    if (message->hdr.flags & MSG_FLAG_NACK)
+    {
+        MPI_Cancel(&slot->payload_request);
+        MPI_Wait(&slot->payload_request, MPI_STATUS_IGNORE);
+        return;
+    }
+
+    MPI_Wait(&slot->payload_request, MPI_STATUS_IGNORE);
+    metrics_add(METRIC_BYTES_RECEIVED, slot->payload_length);
+    metrics_add(METRIC_MESSAGES_RECEIVED, 1);
+}
+
+// Salveaza un segment verificat si anunta vecinii si, la nevoie, tracker-ul
+void accept_segment(DownloadWorker *worker, DownloadInfo *download, int segment, const uint8_t *digest, int peer)
+{
+    int rank = worker->rank;
+
+    store_segment_locally(download, segment, digest);
+    write_output_line(rank, download, segment, digest);
+    if (download->resume.header)
+    {
+        resume_mark(&download->resume, segment); // abia dupa ce segmentul este scris
+    }
+    if (!atomic_exchange(&worker->peer_info->first_segment, 1))
+    {
+        metrics_record(HIST_FIRST_SEGMENT, MPI_Wtime() - worker->peer_info->start_time);
+    }
+
+    if (options.gossip)
+    {
+        broadcast_have(worker, download, segment);
+    }
+
+    pthread_mutex_lock(&download->lock);
+    int downloaded = ++download->segments_downloaded;
+    pthread_mutex_unlock(&download->lock);
+
+    if (LOG_ENABLED(LOG_LEVEL_DEBUG))
+    {
+        char hash_value[HASH_SIZE + 1];
+        proto_digest_to_str(hash_value, digest);
+        LOG_DEBUG("Peer %d: Successfully downloaded segment %d of %s from Peer %d: %s\n",
+                rank, segment, download->filename, peer, hash_value);
+    }
+
+    if (downloaded == 1) // Dupa primul segment descarcat
+    {
+        FileMsg notify_tracker;
+        proto_header_init(&notify_tracker.hdr, MSG_RECEIVED_SEGMENT, 0);
+        notify_tracker.file_id = download->file_id;
+        notify_tracker.segment_index = segment;
+        notify_tracker.reply_tag = 0;
+        notify_tracker.payload_tag = 0;
+        MPI_Send(&notify_tracker, sizeof(notify_tracker), MPI_BYTE,
+                 tracker_for(download->file_id), MSG_RECEIVED_SEGMENT, MPI_COMM_WORLD);
+        LOG_DEBUG("Peer %d: Notified tracker about partial ownership of %s.\n",
+                rank, download->filename);
+    }
+
+    // re-actualizez la fiecare 10 segmente; cu gossip vecinii isi anunta
+    // singuri segmentele noi, iar tracker-ul este intrebat mai rar
+    if (downloaded % (options.gossip ? GOSSIP_REQUEST_BATCH : SEGMENT_REQUEST_BATCH) == 0)
+    {
+        LOG_DEBUG("Peer %d: Re-requested peer list for file %s after %d segments.\n",
+                rank, download->filename, downloaded);
+
+        send_segment_bitfield(rank, download, worker->peer_info);
+        request_peer_list(rank, download, WORKER_PEER_LIST_TAG(worker->id));
+        worker->refreshes++;
+
+        pthread_mutex_lock(&download->lock);
+        if (LOG_ENABLED(LOG_LEVEL_DEBUG))
+        {
+            // Lista se trunchiaza la dimensiunea unei linii de log
+            char peer_text[512];
+            int length = 0;
+            peer_text[0] = '\0';
+            for (int p = 0; p < download->peer_count && length < (int)sizeof(peer_text); p++)
+            {
+                length += snprintf(peer_text + length, sizeof(peer_text) - length, "%d ", download->peers[p]);
+            }
+            LOG_DEBUG("Peer %d: Updated peers for file %s: %s\n",
+                    rank, download->filename, peer_text);
+        }
+        pthread_mutex_unlock(&download->lock);
+    }
+}
+
+// Verifica un raspuns si salveaza segmentul. Intoarce 1 daca segmentul este
+// descarcat.
+int handle_response(DownloadWorker *worker, DownloadInfo *download, SegmentHashMsg *message, int peer)
+{
+    int rank = worker->rank;
+    int segment = message->segment_index;
+
+    if (message->hdr.flags & MSG_FLAG_NACK)
+    {
+        worker->nacks++;
+        LOG_DEBUG("Peer %d: NACK for segment %d, file %s from peer %d.\n",
+                rank, segment, download->filename, peer);
+        return 0;
+    }
+
+    const uint8_t *expected = download->digests + (size_t)segment * HASH_SIZE;
+    if (memcmp(message->digest, expected, HASH_SIZE) != 0)
+    {
+        char hash_value[HASH_SIZE + 1], expected_value[HASH_SIZE + 1];
+        proto_digest_to_str(hash_value, message->digest);
+        proto_digest_to_str(expected_value, expected);
+        LOG_WARN("Peer %d: Failed to download segment %d of %s from Peer %d: %s\n %s\n",
+                rank, segment, download->filename, peer, hash_value, expected_value);
+        return 0;
+    }
+
+    accept_segment(worker, download, segment, message->digest, peer);
+    return 1;
+}
+
+// Continutul primit intr-un slot se verifica pe firele din verify.c; slotul
+// ramane ocupat pana la rezultat
+void submit_verification(RequestWindow *window, PendingRequest *slot)
+{
+    DownloadInfo *download = slot->download;
+    slot->verify.data = download->payload + payload_segment_offset(slot->segment, options.segment_size);
+    slot->verify.length = slot->payload_length;
+    slot->verify.expected = download->digests + (size_t)slot->segment * HASH_SIZE;
+    verify_submit(&slot->verify);
+    window->recv_requests[window->depth + (slot - window->slots)] = slot->verify.request;
+}
+
+// Rezultatul verificarii continutului dintr-un slot. Intoarce 1 daca
+// segmentul este descarcat.
+int handle_verification(DownloadWorker *worker, PendingRequest *slot)
+{
+    DownloadInfo *download = slot->download;
+    if (!slot->verify.valid)
+    {
+        worker->verify_failures++;
+        LOG_WARN("Peer %d: Content of segment %d of %s from Peer %d does not match its hash.\n",
+                 worker->rank, slot->segment, download->filename, slot->peer);
+        return 0;
+    }
+
+    accept_segment(worker, download, slot->segment, slot->verify.expected, slot->peer);
+    worker->payload_bytes += slot->payload_length;
+    return 1;
+}
+
+// Raspunsul pentru un slot, primit prin mesaje sau construit dintr-o citire
+// RMA. Continutul se verifica separat; hash-ul anuntat de peer nu conteaza.
+// La esec, aceeasi cerere pleaca spre urmatorul peer.
+void complete_request(DownloadWorker *worker, PendingRequest *slot, SegmentHashMsg *message)
+{
+    RequestWindow *window = &worker->window;
+    DownloadInfo *download = slot->download;
+    MPI_Wait(&slot->send_request, MPI_STATUS_IGNORE);
+    finish_payload(slot, message);
+    metrics_record_rtt(slot->peer, MPI_Wtime() - slot->sent_time);
+
+    if (download->payload && !(message->hdr.flags & MSG_FLAG_NACK))
+    {
+        submit_verification(window, slot);
+    }
+    else if (handle_response(worker, download, message, slot->peer) || !issue_request(worker, slot))
+    {
+        slot->download = NULL;
+        window->in_flight--;
+        finish_segment(worker, download);
+    }
+}
+
+// Workerul de download: tine pana la window.depth cereri in zbor, cu
+// segmente din coada proprie sau furate de la ceilalti workeri
+void *download_worker_func(void *arg)
+{
+    DownloadWorker *worker = (DownloadWorker *)arg;
+    RequestWindow *window = &worker->window;
+    MPI_Status status;
+    SegmentTask task;
+
+    while (1)
+    {
+        long seen = feed_generation(worker->feed);
+        while (window->in_flight < window->depth && take_task(worker, &task))
+        {
+            start_segment(worker, &task);
+        }
+
+        // Fara cereri in zbor, bucla de mai sus s-a oprit pentru ca nu mai
+        // exista segmente; mai pot veni doar din manifestele asteptate
+        if (window->in_flight == 0)
+        {
+            if (!feed_wait(worker->feed, seen))
+                break;
+            continue;
+        }
+
+        if (window->ready_count > 0)
+        {
+            // Un segment copiat de la un vecin de nod; nu asteapta nimic
+            PendingRequest *slot = &window->slots[window->ready[--window->ready_count]];
+            complete_request(worker, slot, &slot->rma_response);
+            continue;
+        }
+
+        int index;
+        MPI_Waitany(3 * window->depth, window->recv_requests, &index, &status);
+
+        if (index >= 2 * window->depth)
+        {
+            // S-a terminat o citire RMA a unui slot
+            PendingRequest *slot = &window->slots[index - 2 * window->depth];
+            int held = slot->rma_phase == RMA_FETCH;
+            if (!held && ((slot->rma_present >> (slot->segment % 8)) & 1))
+            {
+                slot->rma_phase = RMA_FETCH;
+                if (start_rma_read(worker, slot) == 0)
+                    continue;
+            }
+            slot->rma_response.hdr.flags = held ? 0 : MSG_FLAG_NACK;
+            complete_request(worker, slot, &slot->rma_response);
+            continue;
+        }
+
+        if (index >= window->depth)
+        {
+            // S-a terminat verificarea continutului unui slot
+            PendingRequest *slot = &window->slots[index - window->depth];
+            DownloadInfo *download = slot->download;
+            if (handle_verification(worker, slot) || !issue_request(worker, slot))
+            {
+                slot->download = NULL;
+                window->in_flight--;
+                finish_segment(worker, download);
+            }
+            continue;
+        }
+
+        SegmentHashMsg *message = &window->responses[index];
+        int message_size;
+        MPI_Get_count(&status, MPI_BYTE, &message_size);
+        metrics_add(METRIC_BYTES_RECEIVED, message_size);
+        metrics_add(METRIC_MESSAGES_RECEIVED, 1);
+
+        PendingRequest *slot = NULL;
+        if (proto_check(message, message_size, MSG_DOWNLOAD_RESPONSE, sizeof(SegmentHashMsg)) == 0)
+        {
+            for (int i = 0; i < window->depth; i++)
+            {
+                PendingRequest *candidate = &window->slots[i];
+                if (candidate->download != NULL &&
+                    candidate->download->file_id == message->file_id &&
+                    candidate->segment == (int)message->segment_index &&
+                    candidate->peer == status.MPI_SOURCE)
+                {
+                    slot = candidate;
+                    break;
+                }
+            }
+        }
+
+        if (slot)
+        {
+            complete_request(worker, slot, message);
+        }
+        else
+        {
+            LOG_WARN("Peer %d: Unexpected response from peer %d.\n", worker->rank, status.MPI_SOURCE);
+        }
+
+        MPI_Irecv(message, sizeof(SegmentHashMsg), MPI_BYTE, MPI_ANY_SOURCE,
+                  window->response_tag, MPI_COMM_WORLD, &window->recv_requests[index]);
+    }
+
+    return NULL;
+}
+
+// Numarul de workeri de download: din optiuni sau cate unul per procesor
+int download_worker_count(void)
+{
+    int count = options.download_workers;
+    if (count <= 0)
+    {
+        count = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (count < 1)
+        count = 1;
+    if (count > MAX_DOWNLOAD_WORKERS)
+        count = MAX_DOWNLOAD_WORKERS;
+    return count;
+}
+
+// Pregateste fisierul in care se primeste direct continutul segmentelor.
+// Un fisier detinut deja nu se mai scrie; se descarca doar hash-urile.
+void map_download_payload(int rank, DownloadInfo *download, PeerInfo *peer_info)
+{
+    if (payload_segment_count(download->file_size, options.segment_size) != download->segments_total)
+    {
+        LOG_ERROR("Peer %d: %s has %llu bytes, not %d segments of %d bytes\n", rank, download->filename,
+                  (unsigned long long)download->file_size, download->segments_total, options.segment_size);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+
+    FileDetails *owned = store_find(&peer_info->owned_files, download->file_id);
+    if (owned)
+    {
+        download->payload = owned->payload; // descarcare reluata sau fisier detinut
+        return;
+    }
+
+    char path[PATH_MAX];
+    PayloadMap map;
+    content_path(path, sizeof(path), rank, download->filename, 0);
+    if (payload_map_destination(&map, path, download->file_size) != 0)
+    {
+        LOG_ERROR("Peer %d: Cannot create content file %s\n", rank, path);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+
+    FileDetails *file = store_add_file(&peer_info->owned_files, download->filename, download->segments_total);
+    file->payload = map.data;
+    file->payload_size = map.size;
+    download->payload = map.data;
+}
+
+// Starea persistata a unei descarcari. Segmentele reluate la pornire au fost
+// verificate fata de manifestul din stare, deci acesta trebuie sa fie cel
+// primit acum de la tracker.
+void open_resume_state(int rank, DownloadInfo *download, PeerInfo *peer_info)
+{
+    FileDetails *owned = store_find(&peer_info->owned_files, download->file_id);
+    if (owned && !file_is_partial(owned))
+    {
+        return; // nu mai este nimic de descarcat
+    }
+
+    char path[PATH_MAX];
+    ResumeHeader expected = {RESUME_MAGIC, download->file_id, (uint32_t)download->segments_total,
+                             options.data_dir ? (uint32_t)options.segment_size : 0, download->file_size};
+    snprintf(path, sizeof(path), "client%d_%s.state", rank, download->filename);
+
+    int result = resume_open(&download->resume, path, &expected, download->digests);
+    if (result < 0)
+    {
+        LOG_WARN("Peer %d: Cannot create %s; progress of %s will not be kept.\n", rank, path, download->filename);
+    }
+    else if (result == 0 && owned && atomic_load_explicit(&owned->segment_count, memory_order_relaxed) > 0)
+    {
+        LOG_ERROR("Peer %d: %s does not match the tracker's manifest of %s; remove it and restart.\n",
+                  rank, path, download->filename);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+}
+
+// Expune un fisier din store prin fereastra RMA si vecinilor de nod; source
+// = fisierul vine din fisierul de intrare
+void expose_file(int rank, FileDetails *file, int source)
+{
+    if (file->total_segments == 0)
+        return;
+
+    if (options.transport == TRANSPORT_RMA && rma_publish(file) != 0)
+    {
+        LOG_WARN("Peer %d: Cannot expose %s in the RMA window; it is served through messages.\n",
+                 rank, file->filename);
+    }
+    if (options.shared_memory)
+    {
+        char path[PATH_MAX];
+        if (options.data_dir)
+        {
+            content_path(path, sizeof(path), rank, file->filename, source);
+        }
+        if (node_publish(file, options.data_dir ? path : NULL) != 0)
+        {
+            LOG_WARN("Peer %d: Cannot share %s through node memory; peers on this node request it instead.\n",
+                     rank, file->filename);
+        }
+    }
+}
+
+// Fisierul de iesire, continutul si starea unei descarcari, dupa manifest
+void prepare_download(int rank, DownloadInfo *download, PeerInfo *peer_info)
+{
+    open_output_file(rank, download);
+    if (options.data_dir)
+    {
+        map_download_payload(rank, download, peer_info);
+    }
+    if (options.resume)
+    {
+        open_resume_state(rank, download, peer_info);
+    }
+    // Fisierul se expune inainte ca peer-ul sa anunte vreun segment din el
+    if ((options.transport == TRANSPORT_RMA || options.shared_memory) && download->segments_total > 0)
+    {
+        expose_file(rank, store_add_file(&peer_info->owned_files, download->filename, download->segments_total), 0);
+    }
+}
+
+// Imparte segmentele unui fisier cozilor workerilor, in ordinea strategiei,
+// si anunta workerii care asteapta
+void enqueue_download(int rank, DownloadInfo *download, PeerInfo *peer_info, const PiecePicker *picker,
+                      TaskDeque *deques, int worker_count, TaskFeed *feed)
+{
+    int total = download->segments_total;
+    int *order = (int *)malloc((total + 1) * sizeof(int));
+    if (!order)
+    {
+        LOG_ERROR("Peer %d: Memory allocation failed\n", rank);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+    picker->order_segments(rank, download, order);
+
+    // Segmentele reluate sunt deja verificate; ramane doar linia lor. Se
+    // numara inainte ca workerii sa primeasca restul fisierului.
+    FileDetails *owned = store_find(&peer_info->owned_files, download->file_id);
+    int remaining = 0;
+    for (int k = 0; k < total; k++)
+    {
+        if (owned && store_has_segment(owned, order[k]))
+        {
+            write_output_line(rank, download, order[k], store_digest(owned, order[k]));
+            download->segments_downloaded++;
+            download->segments_finished++;
+        }
+        else
+        {
+            order[remaining++] = order[k];
+        }
+    }
+
+    if (remaining == 0)
+    {
+        complete_download(rank, download, peer_info);
+    }
+    for (int k = 0; k < remaining; k++)
+    {
+        TaskDeque *deque = &deques[k % worker_count];
+        pthread_mutex_lock(&deque->lock);
+        deque_push(rank, deque, download, order[k]);
+        pthread_mutex_unlock(&deque->lock);
+    }
+    free(order);
+
+    pthread_mutex_lock(&feed->lock);
+    feed->generation++;
+    if (feed->pending > 0)
+        feed->pending--;
+    pthread_cond_broadcast(&feed->changed);
+    pthread_mutex_unlock(&feed->lock);
+}
+
+// Un manifest asteptat nu mai vine: fisierul nu este disponibil
+void feed_drop(TaskFeed *feed)
+{
+    pthread_mutex_lock(&feed->lock);
+    if (feed->pending > 0)
+        feed->pending--;
+    pthread_cond_broadcast(&feed->changed);
+    pthread_mutex_unlock(&feed->lock);
+}
+
+void start_download_workers(DownloadWorker *workers, pthread_t *threads, int worker_count)
+{
+    for (int w = 0; w < worker_count; w++)
+    {
+        if (pthread_create(&threads[w], NULL, download_worker_func, &workers[w]))
+        {
+            LOG_ERROR("Peer %d: Error creating download worker.\n", workers[w].rank);
+            exit(-1);
+        }
+    }
+}
+
+void *download_thread_func(void *arg)
+{
+    ThreadArgs *thread_args = (ThreadArgs *)arg;
+    int rank = thread_args->rank;
+    PeerInfo *peer_info = thread_args->peer_info;
+
+    int download_count = peer_info->requested_file_count;
+    DownloadInfo *downloads = (DownloadInfo *)calloc(download_count + 1, sizeof(DownloadInfo));
+    if (!downloads)
+    {
+        LOG_ERROR("Peer %d: Memory allocation failed\n", rank);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+
+    int rank_count;
+    MPI_Comm_size(MPI_COMM_WORLD, &rank_count);
+
+    for (int i = 0; i < download_count; i++)
+    {
+        DownloadInfo *download = &downloads[i];
+        strcpy(download->filename, peer_info->requested_files[i]);
+        download->file_id = proto_file_id(download->filename);
+        download->rank_count = rank_count;
+        download->peer_index = (int *)malloc(rank_count * sizeof(int));
+        download->neighbor_flags = (uint8_t *)calloc(rank_count, 1);
+        download->interested = (int *)malloc(rank_count * sizeof(int));
+        if (options.transport == TRANSPORT_RMA)
+        {
+            download->remote_files = (RmaFile *)calloc(rank_count, sizeof(RmaFile));
+        }
+        if (options.shared_memory)
+        {
+            download->local_files = (NodeFile *)calloc(rank_count, sizeof(NodeFile));
+        }
+        if (!download->peer_index || !download->neighbor_flags || !download->interested ||
+            (options.transport == TRANSPORT_RMA && !download->remote_files) ||
+            (options.shared_memory && !download->local_files))
+        {
+            LOG_ERROR("Peer %d: Memory allocation failed\n", rank);
+            MPI_Abort(MPI_COMM_WORLD, -1);
         }
-        else if (status.MPI_TAG == MSG_FINALIZE_ALL)
+        for (int r = 0; r < rank_count; r++)
         {
-            fprintf(log_file, "Tracker: Peer %d has finalized all downloads.\n", sender_rank);
-            fflush(log_file);
-            clients_finalized++;
+            download->peer_index[r] = -1;
         }
-
-        free(message);
+        pthread_mutex_init(&download->lock, NULL);
     }
 
-    for (int i = 1; i < numtasks; i++)
+    // De acum firul de gossip poate actualiza descarcarile
+    pthread_mutex_lock(thread_args->peer_info_mutex);
+    peer_info->downloads = downloads;
+    peer_info->download_count = download_count;
+    pthread_mutex_unlock(thread_args->peer_info_mutex);
+
+    int worker_count = download_worker_count();
+    DownloadWorker *workers = (DownloadWorker *)calloc(worker_count, sizeof(DownloadWorker));
+    TaskDeque *deques = (TaskDeque *)calloc(worker_count, sizeof(TaskDeque));
+    pthread_t *threads = (pthread_t *)malloc(worker_count * sizeof(pthread_t));
+    if (!workers || !deques || !threads)
     {
-        MPI_Send("TERMINATE", strlen("TERMINATE") + 1, MPI_CHAR, i,
-                 MSG_DOWNLOAD_REQUEST, MPI_COMM_WORLD); // trimis catre thread ul de upload
-        fprintf(log_file, "Tracker: Sent TERMINATE to Peer %d.\n", i);
-        fflush(log_file);
+        LOG_ERROR("Peer %d: Memory allocation failed\n", rank);
+        MPI_Abort(MPI_COMM_WORLD, -1);
     }
-}
 
-// Functia de citire a fisierului de input
-void read_input_file(int rank, PeerInfo *peer_info)
-{
-    char input_filename[20], output_filename[20];
-    sprintf(input_filename, "in%d.txt", rank);
-    sprintf(output_filename, "o%d.txt", rank);
+    const PiecePicker *picker = find_piece_picker(options.piece_picker);
+    TaskFeed feed = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, 0};
 
-    FILE *input_file = fopen(input_filename, "r");
-    if (!input_file)
+    for (int w = 0; w < worker_count; w++)
     {
-        fprintf(log_file, "Peer %d: Error opening input file %s\n", rank, input_filename);
-        fflush(log_file);
-        MPI_Abort(MPI_COMM_WORLD, -1);
+        pthread_mutex_init(&deques[w].lock, NULL);
+        workers[w].id = w;
+        workers[w].rank = rank;
+        workers[w].worker_count = worker_count;
+        workers[w].deques = deques;
+        workers[w].feed = &feed;
+        workers[w].peer_info = peer_info;
+        workers[w].picker = picker;
+        window_init(&workers[w].window, options.request_window, WORKER_RESPONSE_TAG(w));
     }
 
-    FILE *output_file = fopen(output_filename, "a");
-    if (!output_file)
+    double download_start = MPI_Wtime();
+    if (options.early_start)
     {
-        fprintf(log_file, "Peer %d: Error opening output file %s\n", rank, output_filename);
-        fflush(log_file);
-        fclose(input_file);
-        MPI_Abort(MPI_COMM_WORLD, -1);
-    }
+        // Toate cererile pleaca deodata; fiecare fisier intra in cozi cand ii
+        // soseste manifestul, iar workerii pornesc inainte de primul
+        for (int i = 0; i < download_count; i++)
+        {
+            downloads[i].list_sent = MPI_Wtime();
+            send_list_request(&downloads[i], MANIFEST_TAG);
+        }
+        feed.pending = download_count;
+        start_download_workers(workers, threads, worker_count);
 
-    fscanf(input_file, "%d", &peer_info->owned_file_count);
-    fprintf(output_file, "%d\n", peer_info->owned_file_count);
+        for (int received = 0; received < download_count; received++)
+        {
+            PeerListMsg *peer_list = receive_peer_list(rank, MPI_ANY_SOURCE, MANIFEST_TAG);
+            DownloadInfo *download = NULL;
+            for (int i = 0; i < download_count && !download; i++)
+            {
+                if (downloads[i].file_id == peer_list->file_id && !downloads[i].have_hashes &&
+                    !downloads[i].unavailable)
+                    download = &downloads[i];
+            }
+            if (!download)
+            {
+                LOG_ERROR("Peer %d: Unexpected manifest for file id %u.\n", rank, peer_list->file_id);
+                MPI_Abort(MPI_COMM_WORLD, -1);
+            }
+            metrics_record(HIST_PEER_LIST_RTT, MPI_Wtime() - download->list_sent);
+            apply_peer_list(rank, download, peer_list);
+            free(peer_list);
+            if (download->unavailable)
+            {
+                feed_drop(&feed);
+                continue;
+            }
 
-    for (int i = 0; i < peer_info->owned_file_count; i++)
+            prepare_download(rank, download, peer_info);
+            enqueue_download(rank, download, peer_info, picker, deques, worker_count, &feed);
+        }
+    }
+    else
     {
-        fscanf(input_file, "%s %d",
-               peer_info->owned_files[i].filename,
-               &peer_info->owned_files[i].total_segments);
-        fprintf(output_file, "%s %d\n",
-                peer_info->owned_files[i].filename,
-                peer_info->owned_files[i].total_segments);
-
-        for (int j = 0; j < peer_info->owned_files[i].total_segments; j++)
+        for (int i = 0; i < download_count; i++)
         {
-            fscanf(input_file, "%s", peer_info->owned_files[i].segments[j]);
-            peer_info->owned_files[i].segments[j][HASH_SIZE] = '\0';
-            fprintf(output_file, "%s\n", peer_info->owned_files[i].segments[j]);
+            request_peer_list(rank, &downloads[i], WORKER_PEER_LIST_TAG(0));
+            if (!downloads[i].unavailable)
+                prepare_download(rank, &downloads[i], peer_info);
         }
-        fprintf(output_file, "\n");
+        // Segmentele fiecarui fisier se impart pe rand workerilor, in ordinea
+        // data de strategie, ca fiecare worker sa inceapa cu cele prioritare
+        for (int i = 0; i < download_count; i++)
+        {
+            if (downloads[i].unavailable)
+                continue;
+            enqueue_download(rank, &downloads[i], peer_info, picker, deques, worker_count, &feed);
+        }
+        start_download_workers(workers, threads, worker_count);
     }
 
-    fscanf(input_file, "%d", &peer_info->requested_file_count);
-    fprintf(output_file, "%d\n", peer_info->requested_file_count);
-
-    for (int i = 0; i < peer_info->requested_file_count; i++)
+    long requests = 0, nacks = 0, haves_sent = 0, refreshes = 0;
+    uint64_t payload_bytes = 0;
+    long verify_failures = 0;
+    for (int w = 0; w < worker_count; w++)
     {
-        fscanf(input_file, "%s", peer_info->requested_files[i]);
-        fprintf(output_file, "%s\n", peer_info->requested_files[i]);
+        pthread_join(threads[w], NULL);
+        window_destroy(&workers[w].window);
+        pthread_mutex_destroy(&deques[w].lock);
+        free(deques[w].tasks);
+        requests += workers[w].requests;
+        nacks += workers[w].nacks;
+        haves_sent += workers[w].haves_sent;
+        refreshes += workers[w].refreshes;
+        payload_bytes += workers[w].payload_bytes;
+        verify_failures += workers[w].verify_failures;
     }
-
-    fclose(input_file);
-    fclose(output_file);
-}
-
-// Trimite info despre fisiere la tracker
-void send_file_info_to_tracker(int rank, PeerInfo *peer_info)
-{
-    // Construim mesajul INIT
-    char init_message[1024];
-    memset(init_message, 0, sizeof(init_message));
-
-    sprintf(init_message, "INIT %d", peer_info->owned_file_count);
-
-    // Adauga numele fisierelor si numarul de segmente
-    for (int i = 0; i < peer_info->owned_file_count; i++)
+    pthread_mutex_destroy(&feed.lock);
+    pthread_cond_destroy(&feed.changed);
+    LOG_INFO("Peer %d: Picker %s sent %ld segment requests, received %ld NACKs.\n",
+            rank, picker->name, requests, nacks);
+    if (options.data_dir && download_count > 0)
     {
-        char tmp[128];
-        sprintf(tmp, " %s %d",
-                peer_info->owned_files[i].filename,
-                peer_info->owned_files[i].total_segments);
-        strcat(init_message, tmp);
+        double elapsed = MPI_Wtime() - download_start;
+        LOG_INFO("Peer %d: Downloaded %.2f MB of content in %.3f s (%.2f MB/s), %ld segments failed verification.\n",
+                 rank, payload_bytes / 1e6, elapsed, elapsed > 0 ? payload_bytes / 1e6 / elapsed : 0.0,
+                 verify_failures);
+        metrics_add(METRIC_PAYLOAD_BYTES, payload_bytes);
+        metrics_add(METRIC_VERIFY_FAILURES, verify_failures);
     }
+    metrics_add(METRIC_SEGMENT_REQUESTS, requests);
+    metrics_add(METRIC_NACKS, nacks);
+    free(threads);
+    free(deques);
+    free(workers);
+
+    // Fiecare bitfield trimis primeste un raspuns inainte de FINALIZE_ALL
+    pthread_mutex_lock(&gossip_state.lock);
+    while (gossip_state.replies_received < gossip_state.hellos_sent)
+    {
+        pthread_cond_wait(&gossip_state.replied, &gossip_state.lock);
+    }
+    LOG_INFO("Peer %d: Gossip sent %ld bitfields and %ld HAVEs; %ld peer list refreshes from tracker.\n",
+            rank, gossip_state.hellos_sent, haves_sent, refreshes);
+    pthread_mutex_unlock(&gossip_state.lock);
 
-    // Trimite INIT
-    MPI_Send(init_message, strlen(init_message) + 1, MPI_CHAR,
-             TRACKER_RANK, MSG_INIT, MPI_COMM_WORLD);
-
-    char ack_buffer[16] = {0};
-    MPI_Status ack_status;
-    fflush(stdout);
+    pthread_mutex_lock(thread_args->peer_info_mutex);
+    peer_info->downloads = NULL;
+    peer_info->download_count = 0;
+    pthread_mutex_unlock(thread_args->peer_info_mutex);
 
-    // Trimite segmentele (UPLOAD)
-    for (int i = 0; i < peer_info->owned_file_count; i++)
+    for (int i = 0; i < download_count; i++)
     {
-        for (int j = 0; j < peer_info->owned_files[i].total_segments; j++)
+        pthread_mutex_destroy(&downloads[i].lock);
+        free(downloads[i].peers);
+        free(downloads[i].peer_bits);
+        free(downloads[i].peer_index);
+        free(downloads[i].neighbor_flags);
+        free(downloads[i].interested);
+        free(downloads[i].remote_files);
+        for (int r = 0; downloads[i].local_files && r < rank_count; r++)
         {
-            char upload_message[256];
-            sprintf(upload_message, "UPLOAD %s %d %s",
-                    peer_info->owned_files[i].filename,     
-                    j,                                      
-                    peer_info->owned_files[i].segments[j]);
-
-            MPI_Send(upload_message, strlen(upload_message) + 1, MPI_CHAR,
-                     TRACKER_RANK, MSG_UPLOAD, MPI_COMM_WORLD);
-
-            fprintf(stdout, "Peer %d: Sent UPLOAD for file %s, segment %d, hash %s.\n",
-                    rank, peer_info->owned_files[i].filename, j, peer_info->owned_files[i].segments[j]);
-            fflush(stdout);
+            node_close(&downloads[i].local_files[r]);
         }
+        free(downloads[i].local_files);
+        free(downloads[i].digests);
+        resume_close(&downloads[i].resume);
+    }
+    free(downloads);
+
+    ControlMsg finalize_all;
+    proto_header_init(&finalize_all.hdr, MSG_FINALIZE_ALL, 0);
+    finalize_all.rank = rank;
+    for (int shard = 0; shard < options.trackers; shard++)
+    {
+        MPI_Send(&finalize_all, sizeof(finalize_all), MPI_BYTE,
+                 shard, MSG_FINALIZE_ALL, MPI_COMM_WORLD);
     }
+    LOG_INFO("Peer %d: Sent FINALIZE_ALL.\n", rank);
 
-    // Asteapta  ACK pentru finalizarea UPLOAD-urilor
-    MPI_Recv(ack_buffer, 16, MPI_CHAR, TRACKER_RANK, MSG_ACK, MPI_COMM_WORLD, &ack_status);
-    fprintf(stdout, "Peer %d: Received ACK from tracker for UPLOAD completion.\n", rank);
-    fflush(stdout);
+    pthread_exit(NULL);
+    return NULL;
 }
 
-// Salveaza fisierul descarcat in fisierul specificat de cerinta
-void save_downloaded_file(int rank, const char *filename, PeerInfo *peer_info)
+// Descarcarea unui fisier dupa file_id; se apeleaza cu mutex-ul peer-ului tinut
+DownloadInfo *find_download(PeerInfo *peer_info, uint32_t file_id)
 {
-    char output_filename[100];
-    sprintf(output_filename, "client%d_%s", rank, filename);
-    FILE *output_file = fopen(output_filename, "w");
-    if (!output_file)
+    for (int i = 0; i < peer_info->download_count; i++)
     {
-        fprintf(log_file, "Peer %d: Error creating output file %s\n", rank, output_filename);
-        fflush(log_file);
-        return;
+        if (peer_info->downloads[i].file_id == file_id)
+            return &peer_info->downloads[i];
     }
+    return NULL;
+}
+
+// Inregistreaza un vecin care si-a trimis bitfield-ul; apelata cu download->lock tinut
+void add_neighbor(DownloadInfo *download, int peer, int flags)
+{
+    if (peer < 0 || peer >= download->rank_count)
+        return;
 
-    for (int i = 0; i < peer_info->owned_file_count; i++)
+    download->neighbor_flags[peer] |= NEIGHBOR_GREETED;
+    if ((flags & MSG_FLAG_INTERESTED) && !(download->neighbor_flags[peer] & NEIGHBOR_INTERESTED))
     {
-        if (strcmp(peer_info->owned_files[i].filename, filename) == 0)
-        {
-            for (int j = 0; j < peer_info->owned_files[i].total_segments; j++)
-            {
-                if (strlen(peer_info->owned_files[i].segments[j]) > 0)
-                {
-                    fprintf(output_file, "%s\n", peer_info->owned_files[i].segments[j]);
-                }
-                else
-                {
-                    fprintf(output_file, "MISSING_SEGMENT_%d\n", j); // Diagnostic
-                }
-            }
-            break;
-        }
+        download->neighbor_flags[peer] |= NEIGHBOR_INTERESTED;
+        download->interested[download->interested_count++] = peer;
     }
-
-    fclose(output_file);
-    fprintf(log_file, "Peer %d: Saved downloaded file %s.\n", rank, output_filename);
-    fflush(log_file);
 }
 
-// Firul de upload - raspunde cererilor de segmente
-void *upload_thread_func(void *arg)
+// Aplica un HAVE sau un bitfield primit de la alt peer. Intoarce raspunsul
+// de trimis sau NULL.
+BitfieldMsg *handle_gossip(PeerInfo *peer_info, char *message, int message_size, int source, size_t *reply_size)
 {
-    ThreadArgs *thread_args = (ThreadArgs *)arg;
-    int rank = thread_args->rank;
-    PeerInfo *peer_info = thread_args->peer_info;
-    pthread_mutex_t *mutex = thread_args->peer_info_mutex;
-    MPI_Status status;
-    char message[256];
+    BitfieldMsg *reply = NULL;
 
-    while (1)
+    if (proto_check(message, message_size, MSG_HAVE, sizeof(FileMsg)) == 0)
     {
-        MPI_Recv(message, 256, MPI_CHAR, MPI_ANY_SOURCE,
-                 MSG_DOWNLOAD_REQUEST, MPI_COMM_WORLD, &status);
+        FileMsg *have = (FileMsg *)message;
+        gossip_state.haves_received++;
 
-        if (strcmp(message, "TERMINATE") == 0)
+        DownloadInfo *download = find_download(peer_info, have->file_id);
+        if (download)
         {
-            fprintf(log_file, "Peer %d: Received TERMINATE signal. Exiting upload thread.\n", rank);
-            fflush(log_file);
-            break;
+            pthread_mutex_lock(&download->lock);
+            if (download->have_hashes && (int)have->segment_index < download->segments_total)
+            {
+                uint8_t *row = download_peer_bits(download, source);
+                if (row)
+                    bitfield_set(row, have->segment_index);
+            }
+            pthread_mutex_unlock(&download->lock);
         }
+    }
+    else if (proto_check_bitfield(message, message_size, MSG_PEER_BITFIELD) == 0)
+    {
+        BitfieldMsg *hello = (BitfieldMsg *)message;
+        gossip_state.bitfields_received++;
 
-        char requested_filename[MAX_FILENAME];
-        int segment_index;
-        sscanf(message, "%s %d", requested_filename, &segment_index);
-
-        int file_index = -1;
-        int has_segment = 0;
-
-        pthread_mutex_lock(mutex);
-        for (int i = 0; i < peer_info->owned_file_count; i++)
+        int interested = 0;
+        DownloadInfo *download = find_download(peer_info, hello->file_id);
+        if (download)
         {
-            if (strcmp(peer_info->owned_files[i].filename, requested_filename) == 0)
+            pthread_mutex_lock(&download->lock);
+            add_neighbor(download, source, hello->hdr.flags);
+            if (download->have_hashes && (int)hello->segment_count == download->segments_total)
             {
-                if (segment_index < peer_info->owned_files[i].total_segments)
-                {
-                    has_segment = 1;
-                    file_index = i;
-                    break;
-                }
+                uint8_t *row = download_peer_bits(download, source);
+                if (row)
+                    bitfield_merge(row, hello->bits, download->bitfield_bytes);
             }
+            interested = !download->unavailable &&
+                         (!download->have_hashes || download->segments_finished < download->segments_total);
+            pthread_mutex_unlock(&download->lock);
         }
-        pthread_mutex_unlock(mutex);
 
-        if (has_segment)
+        if (hello->hdr.flags & MSG_FLAG_REPLY)
         {
-            const char *hash_value = peer_info->owned_files[file_index].segments[segment_index];
-            char response[256];
-            sprintf(response, "HASH %s", hash_value);
-            MPI_Send(response, strlen(response) + 1, MPI_CHAR,
-                     status.MPI_SOURCE, MSG_DOWNLOAD_RESPONSE, MPI_COMM_WORLD);
-            fprintf(log_file, "Peer %d: Sent hash for segment %d to peer %d.\n",
-                    rank, segment_index, status.MPI_SOURCE);
-            fflush(log_file);
+            pthread_mutex_lock(&gossip_state.lock);
+            gossip_state.replies_received++;
+            pthread_cond_signal(&gossip_state.replied);
+            pthread_mutex_unlock(&gossip_state.lock);
         }
         else
         {
-            MPI_Send("NACK", 5, MPI_CHAR, status.MPI_SOURCE,
-                     MSG_DOWNLOAD_RESPONSE, MPI_COMM_WORLD);
-            fprintf(log_file, "Peer %d: NACK for segment %d, file %s.\n",
-                    rank, segment_index, requested_filename);
-            fflush(log_file);
-        }
-    }
-
-    return NULL;
-}
-
-// Salveaza un segment nou primit pentru un fisier
-void store_segment_locally(const char *filename, int segment_index, const char *hash_value)
-{
-    int found_file_index = -1;
-    for (int fi = 0; fi < global_peer_info.owned_file_count; fi++)
-    {
-        if (strcmp(global_peer_info.owned_files[fi].filename, filename) == 0)
-        {
-            found_file_index = fi;
-            break;
+            reply = build_bitfield(peer_info, MSG_PEER_BITFIELD,
+                                   MSG_FLAG_REPLY | (interested ? MSG_FLAG_INTERESTED : 0),
+                                   hello->file_id, hello->segment_count, reply_size);
         }
     }
-    if (found_file_index == -1)
+    else
     {
-        found_file_index = global_peer_info.owned_file_count++;
-        strcpy(global_peer_info.owned_files[found_file_index].filename, filename);
-        global_peer_info.owned_files[found_file_index].total_segments = 0;
+        LOG_WARN("Peer: Malformed gossip message from peer %d.\n", source);
     }
-    strcpy(global_peer_info.owned_files[found_file_index].segments[segment_index],
-           hash_value);
 
-    if (segment_index + 1 > global_peer_info.owned_files[found_file_index].total_segments)
-    {
-        global_peer_info.owned_files[found_file_index].total_segments = segment_index + 1;
-    }
+    return reply;
 }
 
-// Firul de download
-void *download_thread_func(void *arg)
+// Firul de gossip: primeste bitfield-urile si HAVE-urile celorlalti peers si
+// le adauga la vederea asupra fisierelor descarcate. Raspunsurile pleaca
+// neblocant, ca doua fire de gossip sa nu se astepte unul pe altul.
+void *gossip_thread_func(void *arg)
 {
     ThreadArgs *thread_args = (ThreadArgs *)arg;
     int rank = thread_args->rank;
-    PeerInfo *peer_info = thread_args->peer_info;
-    pthread_mutex_t *mutex = thread_args->peer_info_mutex;
     MPI_Status status;
-    char message[1024];
-
-    DownloadInfo downloads[MAX_FILES];
-    memset(downloads, 0, sizeof(downloads));
 
-    for (int i = 0; i < peer_info->requested_file_count; i++)
-    {
-        strcpy(downloads[i].filename, peer_info->requested_files[i]);
-        downloads[i].segments_downloaded = 0;
-        downloads[i].segments_total = MAX_CHUNKS;
-        downloads[i].peer_count = 0;
-    }
+    BitfieldMsg **replies = NULL;
+    MPI_Request *reply_requests = NULL;
+    int reply_count = 0, reply_capacity = 0;
 
-    for (int i = 0; i < peer_info->requested_file_count; i++)
+    while (1)
     {
-        char request_message[256];
-        sprintf(request_message, "LIST_PEERS %s", peer_info->requested_files[i]);
-        MPI_Send(request_message, strlen(request_message) + 1, MPI_CHAR, TRACKER_RANK, MSG_LIST_PEERS, MPI_COMM_WORLD);
-
-        char peer_list[1024];
-        MPI_Recv(peer_list, sizeof(peer_list), MPI_CHAR, TRACKER_RANK, MSG_PEER_LIST, MPI_COMM_WORLD, &status);
-
-        int seg_count = 0;
-        sscanf(peer_list, "%d", &seg_count);
-        downloads[i].segments_total = seg_count;
+        int message_size;
+        MPI_Probe(MPI_ANY_SOURCE, MSG_GOSSIP, MPI_COMM_WORLD, &status);
+        MPI_Get_count(&status, MPI_BYTE, &message_size);
 
-        char *ptr = strtok(peer_list, " ");
-        int peer_index = 0;
-        while ((ptr = strtok(NULL, " ")) != NULL)
+        char *message = (char *)malloc(message_size + 1);
+        if (!message)
         {
-            downloads[i].peers[peer_index++] = atoi(ptr);
+            LOG_ERROR("Peer %d: Memory allocation failed\n", rank);
+            MPI_Abort(MPI_COMM_WORLD, -1);
         }
-        downloads[i].peer_count = peer_index;
+        MPI_Recv(message, message_size, MPI_BYTE, status.MPI_SOURCE, MSG_GOSSIP, MPI_COMM_WORLD, &status);
 
-        // Primim hash-urile segmentelor
-        for (int s = 0; s < downloads[i].segments_total; s++)
+        // Oprirea vine de la propriul rank, dupa TERMINATE
+        if (status.MPI_SOURCE == rank)
         {
-            char hash_message[256];
-            MPI_Recv(hash_message, sizeof(hash_message), MPI_CHAR, TRACKER_RANK, MSG_PEER_LIST, MPI_COMM_WORLD, &status);
-
-            int segment_index;
-            char hash_value[HASH_SIZE + 1];
-            sscanf(hash_message, "HASH %d %s", &segment_index, hash_value);
-            strcpy(downloads[i].filename_hashes[s], hash_value);
+            free(message);
+            break;
         }
-    }
 
-    // Descarcam
-    for (int i = 0; i < peer_info->requested_file_count; i++)
-    {
-        for (int segment = 0; segment < downloads[i].segments_total; segment++)
+        size_t reply_size;
+        pthread_mutex_lock(thread_args->peer_info_mutex);
+        BitfieldMsg *reply = handle_gossip(thread_args->peer_info, message, message_size,
+                                           status.MPI_SOURCE, &reply_size);
+        pthread_mutex_unlock(thread_args->peer_info_mutex);
+        free(message);
+
+        if (reply)
         {
-            int successful_download = 0;
-            int attempts = 0;
-            while (!successful_download && attempts < downloads[i].peer_count)
+            if (reply_count == reply_capacity)
             {
-                int peer_to_request = downloads[i].peers[(segment + attempts) % downloads[i].peer_count]; // Alegere circulara a peer ului de la care descarcam
-
-                attempts++;
-
-                if (peer_to_request == rank)
-                    continue;
-
-                char request_segment[256];
-                sprintf(request_segment, "%s %d", downloads[i].filename, segment);
-                MPI_Send(request_segment, strlen(request_segment) + 1, MPI_CHAR,
-                         peer_to_request, MSG_DOWNLOAD_REQUEST, MPI_COMM_WORLD);
-
-                fprintf(log_file, "Peer %d: Requested %s segment %d from Peer %d.\n",
-                        rank, downloads[i].filename, segment, peer_to_request);
-                fflush(log_file);
-
-                MPI_Recv(message, 256, MPI_CHAR, peer_to_request, MSG_DOWNLOAD_RESPONSE, MPI_COMM_WORLD, &status);
-
-                if (strncmp(message, "NACK", 4) == 0)
+                reply_capacity = reply_capacity ? reply_capacity * 2 : 8;
+                replies = (BitfieldMsg **)realloc(replies, reply_capacity * sizeof(BitfieldMsg *));
+                reply_requests = (MPI_Request *)realloc(reply_requests, reply_capacity * sizeof(MPI_Request));
+                if (!replies || !reply_requests)
                 {
-                    fprintf(log_file, "Peer %d: NACK for segment %d, file %s from peer %d.\n",
-                            rank, segment, downloads[i].filename, peer_to_request);
-                    fflush(log_file);
-                }
-                else if (strncmp(message, "HASH", 4) == 0)
-                {
-                    char dummy[8];
-                    char hash_value[HASH_SIZE + 1];
-                    sscanf(message, "%s %s", dummy, hash_value);
-
-                    if (strcmp(hash_value, downloads[i].filename_hashes[segment]) == 0)
-                    {
-                        pthread_mutex_lock(mutex);
-                        store_segment_locally(downloads[i].filename, segment, hash_value);
-                        pthread_mutex_unlock(mutex);
-
-                        downloads[i].segments_downloaded++;
-                        successful_download = 1;
-
-                        fprintf(log_file, "Peer %d: Successfully downloaded segment %d of %s from Peer %d: %s\n",
-                                rank, segment, downloads[i].filename, peer_to_request, hash_value);
-                        fflush(log_file);
-                    } else {
-                        fprintf(log_file, "Peer %d: Failed to download segment %d of %s from Peer %d: %s\n %s\n",
-                                rank, segment, downloads[i].filename, peer_to_request, hash_value , downloads[i].filename_hashes[segment]);
-                        fflush(log_file);
-                    }
-
-                    if (downloads[i].segments_downloaded == 1) // Dupa primul segment descarcat
-                    {
-                        char notify_tracker[256];
-                        sprintf(notify_tracker, "RECEIVED_SEGMENT %s", downloads[i].filename);
-                        MPI_Send(notify_tracker, strlen(notify_tracker) + 1, MPI_CHAR,
-                                 TRACKER_RANK, MSG_RECEIVED_SEGMENT, MPI_COMM_WORLD);
-                        fprintf(log_file, "Peer %d: Notified tracker about partial ownership of %s.\n",
-                                rank, downloads[i].filename);
-                        fflush(log_file);
-                    }
+                    LOG_ERROR("Peer %d: Memory allocation failed\n", rank);
+                    MPI_Abort(MPI_COMM_WORLD, -1);
                 }
             }
+            replies[reply_count] = reply;
+            MPI_Isend(reply, reply_size, MPI_BYTE, status.MPI_SOURCE, MSG_GOSSIP,
+                      MPI_COMM_WORLD, &reply_requests[reply_count]);
+            reply_count++;
+        }
 
-            if (!successful_download)
+        // Raspunsurile livrate se elibereaza
+        for (int i = 0; i < reply_count;)
+        {
+            int done;
+            MPI_Test(&reply_requests[i], &done, MPI_STATUS_IGNORE);
+            if (done)
             {
-                fprintf(log_file, "Peer %d: Could not download segment %d of file %s from any peer.\n",
-                        rank, segment, downloads[i].filename);
-                fflush(log_file);
+                free(replies[i]);
+                reply_count--;
+                replies[i] = replies[reply_count];
+                reply_requests[i] = reply_requests[reply_count];
             }
-
-            // re-actualizez la fiecare 10 segmente
-            if (downloads[i].segments_downloaded > 0 &&
-                downloads[i].segments_downloaded % SEGMENT_REQUEST_BATCH == 0)
+            else
             {
-                char request_message[256];
-                sprintf(request_message, "LIST_PEERS %s", downloads[i].filename);
-                MPI_Send(request_message, strlen(request_message) + 1, MPI_CHAR,
-                         TRACKER_RANK, MSG_LIST_PEERS, MPI_COMM_WORLD);
-                fprintf(log_file, "Peer %d: Re-requested peer list for file %s after %d segments.\n",
-                        rank, downloads[i].filename, downloads[i].segments_downloaded);
-                fflush(log_file);
-
-                MPI_Recv(message, 1024, MPI_CHAR, TRACKER_RANK,
-                         MSG_PEER_LIST, MPI_COMM_WORLD, &status);
-
-                int seg_count2;
-                char *token = strtok(message, " ");
-                if (token != NULL)
-                    seg_count2 = atoi(token);
-
-                int pc2 = 0;
-                while ((token = strtok(NULL, " ")) != NULL)
-                {
-                    int p2 = atoi(token);
-                    downloads[i].peers[pc2++] = p2;
-                }
-                downloads[i].peer_count = pc2;
-
-                fprintf(log_file, "Peer %d: Updated peers for file %s: ",
-                        rank, downloads[i].filename);
-                for (int p = 0; p < pc2; p++)
-                {
-                    fprintf(log_file, "%d ", downloads[i].peers[p]);
-                }
-                fprintf(log_file, "\n");
-                fflush(log_file);
-
-                for (int s = 0; s < seg_count2; s++)
-                {
-                    MPI_Recv(message, 256, MPI_CHAR, TRACKER_RANK, MSG_PEER_LIST, MPI_COMM_WORLD, &status);
-                }
+                i++;
             }
         }
-            char finalize_download[256];
-            sprintf(finalize_download, "FINISH_DOWNLOAD %s", downloads[i].filename);
-            MPI_Send(finalize_download, strlen(finalize_download) + 1, MPI_CHAR,
-                     TRACKER_RANK, MSG_FINISH_DOWNLOAD, MPI_COMM_WORLD);
-            fprintf(log_file, "Peer %d: Sent FINISH_DOWNLOAD for file %s.\n",
-                    rank, downloads[i].filename);
-            fflush(log_file);
-
-            save_downloaded_file(rank, downloads[i].filename, peer_info);
-        
-        }
-        char finalize_all[256];
-        sprintf(finalize_all, "FINALIZE_ALL %d", rank);
-        MPI_Send(finalize_all, strlen(finalize_all) + 1, MPI_CHAR,
-                 TRACKER_RANK, MSG_FINALIZE_ALL, MPI_COMM_WORLD);
-        fprintf(log_file, "Peer %d: Sent FINALIZE_ALL.\n", rank);
-        fflush(log_file);
-
-        pthread_exit(NULL);
-        return NULL;
-    
+    }
+
+    // HAVE-urile sosite dupa oprire nu mai folosesc nimanui
+    int flag;
+    MPI_Iprobe(MPI_ANY_SOURCE, MSG_GOSSIP, MPI_COMM_WORLD, &flag, &status);
+    while (flag)
+    {
+        int message_size;
+        MPI_Get_count(&status, MPI_BYTE, &message_size);
+        char *message = (char *)malloc(message_size + 1);
+        MPI_Recv(message, message_size, MPI_BYTE, status.MPI_SOURCE, MSG_GOSSIP, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        free(message);
+        MPI_Iprobe(MPI_ANY_SOURCE, MSG_GOSSIP, MPI_COMM_WORLD, &flag, &status);
+    }
+
+    MPI_Waitall(reply_count, reply_requests, MPI_STATUSES_IGNORE);
+    for (int i = 0; i < reply_count; i++)
+    {
+        free(replies[i]);
+    }
+    free(replies);
+    free(reply_requests);
+
+    LOG_INFO("Peer %d: Gossip received %ld bitfields and %ld HAVEs.\n",
+            rank, gossip_state.bitfields_received, gossip_state.haves_received);
+    return NULL;
+}
+
+// Creeaza fereastra RMA si expune fisierele detinute la pornire; cele
+// descarcate se expun in prepare_download, deci directorul are loc pentru
+// toate fisierele din fisierul de intrare
+void expose_store(int rank, PeerInfo *peer_info)
+{
+    int owned = store_file_count(&peer_info->owned_files);
+    if (options.transport == TRANSPORT_RMA && rma_init(owned + peer_info->requested_file_count) != 0)
+    {
+        LOG_ERROR("Peer %d: Cannot create the RMA window\n", rank);
+        MPI_Abort(MPI_COMM_WORLD, -1);
+    }
+
+    for (int i = 0; i < owned; i++)
+    {
+        expose_file(rank, store_file_at(&peer_info->owned_files, i), i < peer_info->source_count);
+    }
 }
+
     // Functia peer
     void peer(int numtasks, int rank)
     {
         pthread_t download_thread;
         pthread_t upload_thread;
+        pthread_t gossip_thread;
         void *status;
 
         read_input_file(rank, &global_peer_info);
+        if (options.resume)
+        {
+            resume_downloads(rank, &global_peer_info);
+        }
+        if (options.transport == TRANSPORT_RMA || options.shared_memory)
+        {
+            expose_store(rank, &global_peer_info);
+        }
 
-        send_file_info_to_tracker(rank, &global_peer_info);
+        double registration_start = MPI_Wtime();
+        global_peer_info.start_time = registration_start;
+        MPI_Request registered = send_file_info_to_tracker(rank, numtasks, &global_peer_info);
 
         pthread_mutex_t peer_info_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+        // Firele care nu depind de tracker pornesc cat timp bariera este in
+        // curs. Continutul primit se verifica pe firele din verify.c
+        if (options.data_dir && verify_pool_start(options.verify_threads) != 0)
+        {
+            LOG_ERROR("Peer %d: Error creating verification threads.\n", rank);
+            exit(-1);
+        }
+
         ThreadArgs thread_args;
         thread_args.rank = rank;
         thread_args.peer_info = &global_peer_info;
         thread_args.peer_info_mutex = &peer_info_mutex;
 
+        if (pthread_create(&upload_thread, NULL, upload_thread_func, (void *)&thread_args))
+        {
+            LOG_ERROR("Peer %d: Error creating upload thread.\n", rank);
+            exit(-1);
+        }
+
+        MPI_Wait(&registered, MPI_STATUS_IGNORE);
+        metrics_record(HIST_REGISTRATION, MPI_Wtime() - registration_start);
+        if (!options.early_start)
+        {
+            LOG_INFO("Peer %d: All peers are registered with the tracker.\n", rank);
+        }
+
         if (pthread_create(&download_thread, NULL, download_thread_func, (void *)&thread_args))
         {
-            fprintf(log_file, "Peer %d: Error creating download thread.\n", rank);
-            fflush(log_file);
+            LOG_ERROR("Peer %d: Error creating download thread.\n", rank);
             exit(-1);
         }
 
-        if (pthread_create(&upload_thread, NULL, upload_thread_func, (void *)&thread_args))
+        if (options.gossip && pthread_create(&gossip_thread, NULL, gossip_thread_func, (void *)&thread_args))
         {
-            fprintf(log_file, "Peer %d: Error creating upload thread.\n", rank);
-            fflush(log_file);
+            LOG_ERROR("Peer %d: Error creating gossip thread.\n", rank);
             exit(-1);
         }
 
         if (pthread_join(download_thread, &status))
         {
-            fprintf(log_file, "Peer %d: Error joining download thread.\n", rank);
-            fflush(log_file);
+            LOG_ERROR("Peer %d: Error joining download thread.\n", rank);
             exit(-1);
         }
+        if (options.data_dir)
+        {
+            verify_pool_stop();
+        }
 
         if (pthread_join(upload_thread, &status))
         {
-            fprintf(log_file, "Peer %d: Error joining upload thread.\n", rank);
-            fflush(log_file);
+            LOG_ERROR("Peer %d: Error joining upload thread.\n", rank);
             exit(-1);
         }
 
+        if (options.gossip)
+        {
+            // Toti peers au terminat, deci nu mai vine niciun bitfield nou
+            FileMsg stop;
+            proto_header_init(&stop.hdr, MSG_HAVE, MSG_FLAG_TERMINATE);
+            stop.file_id = 0;
+            stop.segment_index = 0;
+            stop.reply_tag = 0;
+            stop.payload_tag = 0;
+            MPI_Send(&stop, sizeof(stop), MPI_BYTE, rank, MSG_GOSSIP, MPI_COMM_WORLD);
+
+            if (pthread_join(gossip_thread, &status))
+            {
+                LOG_ERROR("Peer %d: Error joining gossip thread.\n", rank);
+                exit(-1);
+            }
+        }
+
         pthread_mutex_destroy(&peer_info_mutex);
+
+        // TERMINATE a sosit, deci toti peers au terminat si nimeni nu mai
+        // citeste din fereastra
+        if (options.transport == TRANSPORT_RMA)
+        {
+            rma_finalize();
+        }
+
+        // Continutul fisierelor detinute si descarcate ramane mapat pana la final
+        for (int i = 0; i < store_file_count(&global_peer_info.owned_files); i++)
+        {
+            FileDetails *file = store_file_at(&global_peer_info.owned_files, i);
+            PayloadMap map = {file->payload, file->payload_size};
+            payload_unmap(&map);
+        }
+        store_destroy(&global_peer_info.owned_files);
+        arena_destroy(&global_peer_info.arena);
+    }
+
+    // Dimensiune in octeti, cu sufixul optional K sau M; -1 daca nu este valida
+    int parse_size(const char *text)
+    {
+        char *end;
+        long value = strtol(text, &end, 10);
+        if (*end == 'K' || *end == 'k')
+        {
+            value *= 1024;
+            end++;
+        }
+        else if (*end == 'M' || *end == 'm')
+        {
+            value *= 1024 * 1024;
+            end++;
+        }
+        return *end == '\0' && end != text && value <= MAX_SEGMENT_SIZE ? (int)value : -1;
+    }
+
+    // Citeste optiunile din linia de comanda
+    void parse_options(int argc, char *argv[])
+    {
+        static struct option long_options[] = {
+            {"window", required_argument, NULL, 'w'},
+            {"download-workers", required_argument, NULL, 'd'},
+            {"upload-workers", required_argument, NULL, 'u'},
+            {"picker", required_argument, NULL, 'p'},
+            {"no-gossip", no_argument, NULL, 'G'},
+            {"log-level", required_argument, NULL, 'l'},
+            {"metrics-report", no_argument, NULL, 'M'},
+            {"data-dir", required_argument, NULL, 'D'},
+            {"segment-size", required_argument, NULL, 'S'},
+            {"verify-threads", required_argument, NULL, 'V'},
+            {"resume", no_argument, NULL, 'R'},
+            {"trackers", required_argument, NULL, 'T'},
+            {"early-start", no_argument, NULL, 'E'},
+            {"transport", required_argument, NULL, 't'},
+            {"shared-memory", no_argument, NULL, 'm'},
+            {"ranks-per-node", required_argument, NULL, 'N'},
+            {NULL, 0, NULL, 0}};
+        int opt;
+
+        while ((opt = getopt_long(argc, argv, "w:d:u:p:Gl:MD:S:V:RT:Et:mN:", long_options, NULL)) != -1)
+        {
+            switch (opt)
+            {
+            case 'w':
+                options.request_window = atoi(optarg);
+                break;
+            case 'd':
+                options.download_workers = atoi(optarg);
+                break;
+            case 'u':
+                options.upload_workers = atoi(optarg);
+                break;
+            case 'p':
+                options.piece_picker = optarg;
+                break;
+            case 'G':
+                options.gossip = 0;
+                break;
+            case 'M':
+                options.metrics_report = 1;
+                break;
+            case 'D':
+                options.data_dir = optarg;
+                break;
+            case 'V':
+                options.verify_threads = atoi(optarg);
+                break;
+            case 'R':
+                options.resume = 1;
+                break;
+            case 'E':
+                options.early_start = 1;
+                break;
+            case 'm':
+                options.shared_memory = 1;
+                break;
+            case 'N':
+                options.ranks_per_node = atoi(optarg);
+                if (options.ranks_per_node < 0)
+                {
+                    fprintf(stderr, "Invalid ranks per node: %s\n", optarg);
+                    MPI_Abort(MPI_COMM_WORLD, -1);
+                }
+                break;
+            case 't':
+                if (strcmp(optarg, "two-sided") == 0)
+                {
+                    options.transport = TRANSPORT_TWO_SIDED;
+                }
+                else if (strcmp(optarg, "rma") == 0)
+                {
+                    options.transport = TRANSPORT_RMA;
+                }
+                else
+                {
+                    fprintf(stderr, "Unknown transport: %s\n", optarg);
+                    MPI_Abort(MPI_COMM_WORLD, -1);
+                }
+                break;
+            case 'T':
+                options.trackers = atoi(optarg);
+                if (options.trackers < 1)
+                {
+                    fprintf(stderr, "Invalid tracker count: %s\n", optarg);
+                    MPI_Abort(MPI_COMM_WORLD, -1);
+                }
+                break;
+            case 'S':
+                options.segment_size = parse_size(optarg);
+                if (options.segment_size < 1 || options.segment_size > MAX_SEGMENT_SIZE)
+                {
+                    fprintf(stderr, "Invalid segment size: %s\n", optarg);
+                    MPI_Abort(MPI_COMM_WORLD, -1);
+                }
+                break;
+            case 'l':
+                options.log_level = log_level_from_name(optarg);
+                if (options.log_level < 0)
+                {
+                    fprintf(stderr, "Unknown log level: %s\n", optarg);
+                    MPI_Abort(MPI_COMM_WORLD, -1);
+                }
+                break;
+            default:
+                fprintf(stderr, "Usage: %s [--window N] [--download-workers N] [--upload-workers N] "
+                                "[--picker rarest|round-robin] [--no-gossip] "
+                                "[--log-level error|warn|info|debug] [--metrics-report] "
+                                "[--data-dir DIR] [--segment-size BYTES[K|M]] [--verify-threads N] [--resume] [--trackers K] [--early-start] "
+                                "[--transport two-sided|rma] [--shared-memory] [--ranks-per-node N]\n", argv[0]);
+                MPI_Abort(MPI_COMM_WORLD, -1);
+            }
+        }
+
+        if (!find_piece_picker(options.piece_picker))
+        {
+            fprintf(stderr, "Unknown piece picker: %s\n", options.piece_picker);
+            MPI_Abort(MPI_COMM_WORLD, -1);
+        }
+
+        if (options.request_window < 1)
+        {
+            options.request_window = 1;
+        }
+        if (options.request_window > MAX_REQUEST_WINDOW)
+        {
+            options.request_window = MAX_REQUEST_WINDOW; // etichetele de continut sunt per slot
+        }
+        if (options.upload_workers < 1)
+        {
+            options.upload_workers = 1;
+        }
     }
 
     int main(int argc, char *argv[])
@@ -834,16 +3850,32 @@ void *download_thread_func(void *arg)
         MPI_Comm_size(MPI_COMM_WORLD, &numtasks);
         MPI_Comm_rank(MPI_COMM_WORLD, &rank);
 
+        parse_options(argc, argv);
+
         char log_filename[32];
         sprintf(log_filename, "o%d.txt", rank);
-        log_file = fopen(log_filename, "w");
-        if (!log_file)
+        if (log_open(log_filename, options.log_level) != 0)
         {
             fprintf(stderr, "Cannot open %s for writing logs.\n", log_filename);
             MPI_Abort(MPI_COMM_WORLD, -1);
         }
+        metrics_init(rank, numtasks);
+
+        if (options.trackers >= numtasks)
+        {
+            fprintf(stderr, "Need more ranks than the %d tracker shards\n", options.trackers);
+            MPI_Abort(MPI_COMM_WORLD, -1);
+        }
+
+        // Rank-urile de pe acelasi nod; doar peers au pool
+        size_t pool_size = options.shared_memory && rank >= options.trackers ? NODE_POOL_SIZE : 0;
+        if (node_init(options.ranks_per_node, pool_size) != 0)
+        {
+            fprintf(stderr, "Cannot set up node-local shared memory\n");
+            MPI_Abort(MPI_COMM_WORLD, -1);
+        }
 
-        if (rank == TRACKER_RANK)
+        if (rank < options.trackers)
         {
             tracker(numtasks, rank);
         }
@@ -851,8 +3883,21 @@ void *download_thread_func(void *arg)
         {
             peer(numtasks, rank);
         }
+        node_finalize();
+
+        char metrics_filename[32];
+        sprintf(metrics_filename, "metrics%d.json", rank);
+        if (metrics_write_json(metrics_filename) != 0)
+        {
+            LOG_WARN("Rank %d: Cannot write %s.\n", rank, metrics_filename);
+        }
+        if (options.metrics_report && metrics_reduce_json(TRACKER_RANK, "metrics_swarm.json") != 0)
+        {
+            LOG_WARN("Rank %d: Cannot write metrics_swarm.json.\n", rank);
+        }
+        metrics_destroy();
 
-        fclose(log_file);
+        log_close();
         MPI_Finalize();
         return 0;
     }
\ No newline at end of file
@@ -0,0 +1,168 @@
+#include "verify.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "protocol.h"
+#include "sha256.h"
+
+static struct
+{
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    VerifyJob *head; // coada FIFO, inlantuita prin next
+    VerifyJob *tail;
+    int stop;
+    int thread_count;
+    pthread_t *threads;
+} pool = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL, NULL, 0, 0, NULL};
+
+void verify_digest(const uint8_t *data, size_t length, uint8_t *digest)
+{
+    uint8_t full[SHA256_DIGEST_SIZE];
+    sha256(data, length, full);
+    sha256_to_hex(full, (char *)digest, HASH_SIZE);
+}
+
+// Cererea generalizata nu transporta date; statusul este gol
+static int query_job(void *extra_state, MPI_Status *status)
+{
+    MPI_Status_set_elements(status, MPI_BYTE, 0);
+    MPI_Status_set_cancelled(status, 0);
+    status->MPI_SOURCE = MPI_UNDEFINED;
+    status->MPI_TAG = MPI_UNDEFINED;
+    return MPI_SUCCESS;
+}
+
+static int free_job(void *extra_state)
+{
+    return MPI_SUCCESS;
+}
+
+static int cancel_job(void *extra_state, int complete)
+{
+    return MPI_SUCCESS;
+}
+
+// Verifica un lot de cel mult SHA256_MAX_LANES joburi si le termina cererile
+static void verify_batch(VerifyJob **jobs, int count)
+{
+    Sha256Job hashes[SHA256_MAX_LANES];
+    uint8_t digests[SHA256_MAX_LANES][SHA256_DIGEST_SIZE];
+
+    for (int i = 0; i < count; i++)
+    {
+        hashes[i].data = jobs[i]->data;
+        hashes[i].length = jobs[i]->length;
+        hashes[i].digest = digests[i];
+    }
+    sha256_many(hashes, count);
+
+    for (int i = 0; i < count; i++)
+    {
+        char text[HASH_SIZE];
+        sha256_to_hex(digests[i], text, HASH_SIZE);
+        jobs[i]->valid = memcmp(text, jobs[i]->expected, HASH_SIZE) == 0;
+        MPI_Grequest_complete(jobs[i]->request);
+    }
+}
+
+static void *verify_thread_func(void *arg)
+{
+    int lanes = sha256_lanes();
+    VerifyJob *batch[SHA256_MAX_LANES];
+
+    while (1)
+    {
+        pthread_mutex_lock(&pool.lock);
+        while (!pool.head && !pool.stop)
+        {
+            pthread_cond_wait(&pool.not_empty, &pool.lock);
+        }
+        if (!pool.head)
+        {
+            pthread_mutex_unlock(&pool.lock);
+            break;
+        }
+
+        // Tot ce asteapta, pana la o banda per segment
+        int count = 0;
+        while (pool.head && count < lanes)
+        {
+            batch[count++] = pool.head;
+            pool.head = pool.head->next;
+        }
+        if (!pool.head)
+        {
+            pool.tail = NULL;
+        }
+        pthread_mutex_unlock(&pool.lock);
+
+        verify_batch(batch, count);
+    }
+    return NULL;
+}
+
+int verify_pool_start(int threads)
+{
+    pool.stop = 0;
+    pool.thread_count = 0;
+    if (threads <= 0)
+    {
+        return 0;
+    }
+
+    pool.threads = (pthread_t *)malloc(threads * sizeof(pthread_t));
+    if (!pool.threads)
+    {
+        return -1;
+    }
+    for (int i = 0; i < threads; i++)
+    {
+        if (pthread_create(&pool.threads[i], NULL, verify_thread_func, NULL))
+        {
+            verify_pool_stop();
+            return -1;
+        }
+        pool.thread_count++;
+    }
+    return 0;
+}
+
+void verify_pool_stop(void)
+{
+    pthread_mutex_lock(&pool.lock);
+    pool.stop = 1;
+    pthread_cond_broadcast(&pool.not_empty);
+    pthread_mutex_unlock(&pool.lock);
+
+    for (int i = 0; i < pool.thread_count; i++)
+    {
+        pthread_join(pool.threads[i], NULL);
+    }
+    free(pool.threads);
+    pool.threads = NULL;
+    pool.thread_count = 0;
+}
+
+void verify_submit(VerifyJob *job)
+{
+    MPI_Grequest_start(query_job, free_job, cancel_job, job, &job->request);
+
+    if (pool.thread_count == 0)
+    {
+        verify_batch(&job, 1);
+        return;
+    }
+
+    job->next = NULL;
+    pthread_mutex_lock(&pool.lock);
+    if (pool.tail)
+        pool.tail->next = job;
+    else
+        pool.head = job;
+    pool.tail = job;
+    pthread_cond_signal(&pool.not_empty);
+    pthread_mutex_unlock(&pool.lock);
+}
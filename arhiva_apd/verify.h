@@ -0,0 +1,38 @@
+#ifndef VERIFY_H
+#define VERIFY_H
+
+#include <mpi.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Verificarea continutului segmentelor pe un grup de fire dedicat. Un worker
+// de download trimite segmentul primit si primeste o cerere MPI generalizata
+// (MPI_Grequest), pe care o asteapta in acelasi MPI_Waitany cu raspunsurile.
+// Firele grupului iau cate sha256_lanes() segmente deodata, ca motorul SIMD
+// sa le hash-uiasca in paralel.
+typedef struct VerifyJob
+{
+    const uint8_t *data;
+    size_t length;
+    const uint8_t *expected; // HASH_SIZE octeti din lista trackerului
+    int valid;               // rezultatul, citit dupa terminarea cererii
+    MPI_Request request;
+    struct VerifyJob *next;
+} VerifyJob;
+
+// Porneste threads fire de verificare; cu 0, verify_submit verifica pe loc.
+// Intoarce 0 la succes.
+int verify_pool_start(int threads);
+
+// Asteapta verificarile ramase si opreste firele
+void verify_pool_stop(void);
+
+// Posteaza verificarea; job->request se termina dupa ce job->valid este
+// stabilit. Jobul trebuie sa ramana valid pana atunci.
+void verify_submit(VerifyJob *job);
+
+// Hash-ul unui segment de continut, in formatul listei trackerului: primii
+// HASH_SIZE / 2 octeti SHA-256, in hex
+void verify_digest(const uint8_t *data, size_t length, uint8_t *digest);
+
+#endif